@@ -21,16 +21,21 @@
 
 #include "lib_utils/ustdlib.h"
 #include "lib_utils/uartstdio.h"
+#include "lib_utils/timebase.h"
+#include "lib_utils/workqueue.h"
 #include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_addr_table.h"
+#include "lib_xbee/xbee_source_route.h"
+#include "lib_xbee/xbee_at.h"
+#include "lib_xbee/xbee_tx_window.h"
+#include "lib_xbee/xbee_reliable.h"
+#include "lib_xbee/xbee_fragment.h"
 #include "lib_xbee/xbee_data_parser.h"
+#include "lib_xbee/sensor_report.h"
 
 #include "sensor/i2cm_drv.h"
-#include "sensor/hw_bmp180.h"
-#include "sensor/bmp180.h"
-#include "sensor/hw_sht21.h"
-#include "sensor/sht21.h"
-#include "sensor/hw_isl29023.h"
-#include "sensor/isl29023.h"
+#include "sensor/sensor_scheduler.h"
 
 #include "configperiph.h"
 
@@ -45,26 +50,38 @@
 // The system tick rate expressed both as ticks per second and a millisecond period.
 #define TIMER0_PERIOD       	  45		// Timer0 period in seconds.
 #define PRINT_INTERVAL_SEC         5		// Time interval in second for printing data to console.
+#define LED_BLINK_MS			   1		// Time the blue LED stays on for each report.
+#define REPORT_BATCH_MAX_AGE_MS   (4 * TIMER0_PERIOD * 1000)	// Staleness bound of batched samples.
+
+// UART1 link to the xbee. XBEE_BAUD_BOOT is the module BD setting at power up. A higher XBEE_BAUD
+// is opt-in: once the API mode is known the module and UART1 are moved to it, without WR, so a power
+// cycle takes the module back to XBEE_BAUD_BOOT. At startup the link is probed at XBEE_BAUD first,
+// since after a reset of the MCU alone the module still runs at it, then at XBEE_BAUD_BOOT.
+// Flow control is opt-in too, it needs PC4/PC5 wired to the module DIO6 RTS and DIO7 CTS.
+#define XBEE_BAUD_BOOT		  115200
+#define XBEE_BAUD			  115200
+#define XBEE_BAUD_MAX		  921600	// Highest rate the module accepts in BD.
+#define XBEE_FLOW_CONTROL	  false		// PC4/PC5 wired to the module RTS/CTS.
+#define XBEE_RX_DMA			  true		// Received bytes stored by the uDMA, one interrupt per block.
+
+#if XBEE_BAUD > XBEE_BAUD_MAX
+#error "XBEE_BAUD above the highest xbee rate"
+#endif
 
-// Define I2C Devices Addresses.
-#define BMP180_I2C_ADDRESS      0x77
-#define SHT21_I2C_ADDRESS  		0x40
-#define ISL29023_I2C_ADDRESS    0x44
+// Deferred work items posted from interrupt context. Lower ids run first.
+#define WORK_SENSOR_REPORT		   0		// Timer0 period elapsed, send sensors report.
 
 //**************************************************************************************************
 // Global variables
 XbeeZB XbeeZB;
 char g_cZBTxReqSensorsString[48];		// Store string with all sensor values "t20.5|h50.2|l180.5".
+uint8_t g_ui8ZBTxReqSensorsBinary[ZB_MAX_RF_PAYLOAD];	// Store binary sensors report, see sensor_report.h.
+uint8_t g_ui8XbeeCmdLine[XBEE_FRAGMENT_RX_BUFFER_SIZE + 1];	// NUL terminated copy of received command, reassembled ones included.
+bool g_bXbeeCmdPending = false;			// True when g_ui8XbeeCmdLine holds a command not yet processed.
+tReportBatch g_sReportBatch;			// Samples waiting to be sent in batch report format.
 
 tI2CMInstance g_sI2CInst;				// Global instance structure for the I2C master driver.
 
-tBMP180 g_sBMP180Inst;					// Global instance structure for the BMP180 sensor driver.
-tSHT21 g_sSHT21Inst;					// Global instance structure for the SHT21 sensor driver.
-tISL29023 g_sISL29023Inst;				// Global instance structure for the ISL29023 sensor driver.
-
-volatile uint_fast8_t g_vui8DataFlag;	// Global new data flag to alert main that BMP180 data is ready.
-volatile uint_fast8_t g_vui8ErrorFlag;	// Global new error flag to store the error condition if encountered.
-
 typedef struct{
 	float fTemp;				// Temperature.
 	char cTempString[11];
@@ -81,6 +98,32 @@ typedef struct{
 tSensorsValues;
 tSensorsValues g_sSensorValues;		// Store sensors values.
 
+// Radio identity and settings, read with AT commands at startup.
+typedef struct{
+	uint32_t ui32SerialHigh;	// SH
+	uint32_t ui32SerialLow;		// SL
+	uint16_t ui16Addr16;		// MY
+	uint8_t ui8ApiMode;			// AP
+	uint32_t ui32Baud;			// BD, baud rate index.
+	char cNodeId[XBEE_AT_MAX_VALUE + 1];	// NI
+	uint8_t ui8Rssi;			// DB, -dBm of the last packet received.
+}
+tRadioInfo;
+tRadioInfo g_sRadioInfo;
+
+// Standard rates and their BD index. Other rates are given to BD as the rate itself.
+const uint32_t g_pui32RadioBaudRates[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+#define RADIO_BAUD_RATES	(sizeof(g_pui32RadioBaudRates) / sizeof(g_pui32RadioBaudRates[0]))
+bool g_bRadioBaudFailed = false;	// A command of the rate change failed.
+uint32_t g_ui32RadioLinkBaud = XBEE_BAUD;	// Current UART1 rate.
+
+// Queries sent once the API mode is known. The summary is printed once the last one completes.
+const char * const g_ppcRadioQueries[] = {"SH", "SL", "MY", "BD", "NI", "DB"};
+#define RADIO_QUERIES	(sizeof(g_ppcRadioQueries) / sizeof(g_ppcRadioQueries[0]))
+
+bool g_bLedOn = false;				// True while the report LED blink is on.
+uint32_t g_ui32LedOffMs;			// Time at which the report LED blink ends.
+
 //**************************************************************************************************
 // Functions Prototypes
 extern "C" void Timer0IntHandler(void);
@@ -95,12 +138,10 @@ void __error__(char *pcFilename, uint32_t ui32Line){
 #endif
 
 //**************************************************************************************************
-// Send string to PC from UART0 using uart.h driver.
+// Send string to PC from UART0. The string is queued whole, or dropped and counted in the console
+// statistics when the transmit buffer lacks room, so diagnostics never stall the radio path.
 void UART0Send(const uint8_t *stringBuffer){
-	uint8_t stringLength = ustrlen((char *)stringBuffer);	// Get string length.
-	while(stringLength--){
-		ROM_UARTCharPut(UART0_BASE, *stringBuffer++);
-	}
+	UARTStdioWriteRaw(&g_sUART0Stdio, stringBuffer, ustrlen((char *)stringBuffer));
 }
 
 // Convert float to string with 2 decimal digit.
@@ -125,19 +166,6 @@ void floatToString(float floatValue, char destinationBuffer[]){
 	strcat(destinationBuffer, fractionPartStr);
 }
 
-//***************************************************************************************************
-// SHT21, BMP180, ISL29023 sensors callback function. Called at the end of SHT21, BMP180, ISL29023
-// sensor driver transactions. This is called from I2C interrupt context. Therefore, we just set a
-// flag and let main do the bulk of the computations and display.
-void SensorAppCallback(void* pvCallbackData, uint_fast8_t ui8Status){
-	// If the transaction succeeded set the data flag to indicate to application that this
-	// transaction is complete and data may be ready.
-    if(ui8Status == I2CM_STATUS_SUCCESS){
-        g_vui8DataFlag = 1;
-    }
-    g_vui8ErrorFlag = ui8Status;  // Store the most recent status in case it was an error condition.
-}
-
 //***************************************************************************************************
 // Called by the NVIC as a result of I2C3 Interrupt. I2C3 is the I2C connection to SHT21, BMP180.
 void SensorI2CIntHandler(void){
@@ -147,15 +175,104 @@ void SensorI2CIntHandler(void){
 }
 
 //**************************************************************************************************
-// The interrupt handler for TIMER0 interrupt. It periodically transmit read sensor data.
-void Timer0IntHandler(void){
-    // Clear the timer interrupt.
-    ROM_TimerIntClear(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+// Send a report to the gateway through the transmit window, which resends it if delivery fails.
+// In reliable mode the report is instead kept until the gateway acknowledges it. Return false when
+// the report was not accepted because the window or the retransmit buffer is full.
+bool reportSend(const uint8_t *pui8Report, uint16_t ui16Length){
+	if(SensorReportReliableGet()){
+		return XbeeReliableSend(g_pui8ZBCoordinatorAddr64, pui8Report, ui16Length, TimebaseMsGet());
+	}
+	return XbeeTxWindowSend(pui8Report, ui16Length, TimebaseMsGet());
+}
+
+//**************************************************************************************************
+// Called by the reliable layer when a report is acknowledged or given up.
+void reportReliableDone(uint8_t ui8Seq, bool bDelivered, uint32_t ui32LatencyMs){
+	if(!bDelivered){
+		UART0Send((uint8_t *)"Report not acknowledged\n\r");
+	}
+}
+
+//**************************************************************************************************
+// Called by the transmit window with the final delivery result of each report.
+void reportTxDone(const struct tXbeeTxResult *psResult){
+	if(psResult->deliveryStatus != XBEE_DELIVERY_SUCCESS){
+		UART0Send((uint8_t *)"Report delivery failed\n\r");
+	}
+}
+
+//**************************************************************************************************
+// Fill a report sample with the latest sensors values.
+void reportSampleGet(tReportSample *psSample){
+	psSample->ui32TimeMs = TimebaseMsGet();
+	psSample->ui8Count = 4;
+	psSample->psValues[0].ui8Sensor = REPORT_SENSOR_TEMP;
+	psSample->psValues[0].i32Value = SensorReportFixedPoint(g_sSensorValues.fTemp);
+	psSample->psValues[1].ui8Sensor = REPORT_SENSOR_PRESSURE;
+	psSample->psValues[1].i32Value = SensorReportFixedPoint(g_sSensorValues.fPres);
+	psSample->psValues[2].ui8Sensor = REPORT_SENSOR_HUMIDITY;
+	psSample->psValues[2].i32Value = SensorReportFixedPoint(g_sSensorValues.fHum);
+	psSample->psValues[3].ui8Sensor = REPORT_SENSOR_LIGHT;
+	psSample->psValues[3].i32Value = SensorReportFixedPoint(g_sSensorValues.fLight);
+}
 
-    // Use the flags to Toggle the LED for this timer.
+//**************************************************************************************************
+// Send batched samples in one ZB Transmit Request once the payload is full or the oldest sample
+// reached REPORT_BATCH_MAX_AGE_MS. Samples are only removed from the batch once the record is
+// accepted, otherwise they are sent again on the next pass.
+void reportBatchFlush(void){
+	uint16_t ui16Length;
+	uint8_t ui8Samples;
+
+	if(!SensorReportBatchReady(&g_sReportBatch, TimebaseMsGet())){
+		return;
+	}
+
+	ui16Length = SensorReportBatchEncode(&g_sReportBatch, g_ui8ZBTxReqSensorsBinary,
+										 sizeof(g_ui8ZBTxReqSensorsBinary), &ui8Samples);
+	if(ui16Length && reportSend(g_ui8ZBTxReqSensorsBinary, ui16Length)){	// Send batch to gateway.
+		SensorReportBatchDiscard(&g_sReportBatch, ui8Samples);
+		UART0Send((uint8_t *)"Batch report sent\n\r");
+	}
+}
+
+//**************************************************************************************************
+// Build the sensors report string, send it to the gateway and echo it to the console. Runs from
+// main context as deferred work posted by Timer0IntHandler.
+void sensorReportSend(void){
+    // Use the flags to Toggle the LED for this timer. Main turns it off after LED_BLINK_MS.
     ROM_GPIOPinWrite(GPIO_PORTF_BASE, LED_RED|LED_GREEN|LED_BLUE, LED_BLUE);
-    ROM_SysCtlDelay(ROM_SysCtlClockGet() / 1000);
-    ROM_GPIOPinWrite(GPIO_PORTF_BASE, LED_RED|LED_GREEN|LED_BLUE, 0);
+    g_ui32LedOffMs = TimebaseMsGet() + LED_BLINK_MS;
+    g_bLedOn = true;
+
+    // Binary and batch reports: fixed-point values, no float to text conversion.
+    if(SensorReportFormatGet() != REPORT_FORMAT_ASCII){
+    	tReportSample sSample;
+    	reportSampleGet(&sSample);
+
+    	if(SensorReportFormatGet() == REPORT_FORMAT_BATCH){
+    		SensorReportBatchAdd(&g_sReportBatch, &sSample);
+    		reportBatchFlush();
+    		return;
+    	}
+
+    	uint16_t ui16Length = SensorReportEncode(g_ui8ZBTxReqSensorsBinary, sizeof(g_ui8ZBTxReqSensorsBinary),
+    											 sSample.psValues, sSample.ui8Count);
+    	if(reportSend(g_ui8ZBTxReqSensorsBinary, ui16Length)){	// Send sensor value to gateway.
+    		UART0Send((uint8_t *)"Binary report sent\n\r");
+    	}
+    	else{
+    		UART0Send((uint8_t *)"Report dropped, transmit buffer full\n\r");
+    	}
+    	return;
+    }
+
+    // ASCII report. Values are converted here, so the report is current even right after the
+    // format was switched to ASCII.
+    floatToString(g_sSensorValues.fTemp, g_sSensorValues.cTempString);
+    floatToString(g_sSensorValues.fPres, g_sSensorValues.cPresString);
+    floatToString(g_sSensorValues.fHum, g_sSensorValues.cHumString);
+    floatToString(g_sSensorValues.fLight, g_sSensorValues.cLightString);
 
     strcpy(g_cZBTxReqSensorsString, "t");
     strcat(g_cZBTxReqSensorsString, g_sSensorValues.cTempString);
@@ -169,12 +286,214 @@ void Timer0IntHandler(void){
 	strcat(g_cZBTxReqSensorsString, "l");
 	strcat(g_cZBTxReqSensorsString, g_sSensorValues.cLightString);
 
-	XbeeZB.ZBTransmitRequest((uint8_t *)g_cZBTxReqSensorsString);	// Send sensor value to gateway.
+	if(!reportSend((uint8_t *)g_cZBTxReqSensorsString, strlen(g_cZBTxReqSensorsString))){	// Send sensor value to gateway.
+		UART0Send((uint8_t *)"Report dropped, transmit buffer full\n\r");
+	}
 
 	UART0Send((uint8_t *)g_cZBTxReqSensorsString);
 	UART0Send((uint8_t *)"\n\r");
 }
 
+//**************************************************************************************************
+// Store a received command. The command processor splits arguments in place, so the command is
+// copied out of the UART1 receive buffer, letting the frame be released before it is processed.
+void xbeeCmdCopy(const struct tXbeeRxView *psData){
+	uint16_t ui16Length;
+
+	ui16Length = XbeeViewCopy(psData, g_ui8XbeeCmdLine, sizeof(g_ui8XbeeCmdLine) - 1);
+	g_ui8XbeeCmdLine[ui16Length] = 0;
+	g_bXbeeCmdPending = true;
+}
+
+//**************************************************************************************************
+// Commands sent through the reliable layer, once acknowledged and checked for duplicates.
+void xbeeReliableDeliver(const uint8_t *pui8SrcAddr64, const struct tXbeeRxView *psData){
+	xbeeCmdCopy(psData);
+}
+
+//**************************************************************************************************
+// Commands sent in fragments, once reassembled.
+void xbeeFragmentDeliver(const uint8_t *pui8SrcAddr64, const uint8_t *pui8Data, uint16_t ui16Length){
+	struct tXbeeRxView sData;
+
+	sData.data1 = pui8Data;
+	sData.length1 = ui16Length;
+	sData.data2 = pui8Data;
+	sData.length2 = 0;
+	xbeeCmdCopy(&sData);
+}
+
+//**************************************************************************************************
+// Numeric value of an AT command result, msb first.
+uint32_t radioValueGet(const struct tXbeeAtResult *psResult){
+	uint32_t ui32Value = 0;
+	uint8_t i;
+
+	for(i = 0; i < psResult->length && i < 4; i++){
+		ui32Value = (ui32Value << 8) | psResult->value[i];
+	}
+	return ui32Value;
+}
+
+//**************************************************************************************************
+// Store the result of a startup radio query. Failed queries leave the field at 0.
+void radioQueryDone(const struct tXbeeAtResult *psResult){
+	char cRadioString[80];
+	uint32_t ui32Value = radioValueGet(psResult);
+	uint8_t ui8Command = psResult->command[0];
+	uint8_t i;
+
+	if(psResult->status != XBEE_AT_STATUS_OK){
+		UART0Send((uint8_t *)"Radio query failed\n\r");
+	}
+	else if(ui8Command == 'S' && psResult->command[1] == 'H'){
+		g_sRadioInfo.ui32SerialHigh = ui32Value;
+	}
+	else if(ui8Command == 'S' && psResult->command[1] == 'L'){
+		g_sRadioInfo.ui32SerialLow = ui32Value;
+	}
+	else if(ui8Command == 'M'){
+		g_sRadioInfo.ui16Addr16 = ui32Value;
+	}
+	else if(ui8Command == 'B'){
+		g_sRadioInfo.ui32Baud = ui32Value;
+	}
+	else if(ui8Command == 'N'){
+		for(i = 0; i < psResult->length; i++){
+			g_sRadioInfo.cNodeId[i] = psResult->value[i];
+		}
+		g_sRadioInfo.cNodeId[i] = 0;
+	}
+	else if(ui8Command == 'D'){
+		g_sRadioInfo.ui8Rssi = ui32Value;
+	}
+
+	// DB is the last startup query.
+	if(ui8Command == 'D'){
+		usprintf(cRadioString, "Radio %08x%08x MY %04x AP %d BD %d NI %s DB -%d\n\r",
+				 g_sRadioInfo.ui32SerialHigh, g_sRadioInfo.ui32SerialLow, g_sRadioInfo.ui16Addr16,
+				 g_sRadioInfo.ui8ApiMode, g_sRadioInfo.ui32Baud, g_sRadioInfo.cNodeId, g_sRadioInfo.ui8Rssi);
+		UART0Send((uint8_t *)cRadioString);
+	}
+}
+
+//**************************************************************************************************
+// Read the rest of the radio settings.
+void radioQueriesStart(void){
+	uint8_t i;
+
+	for(i = 0; i < RADIO_QUERIES; i++){
+		XbeeAtQuery(g_ppcRadioQueries[i], radioQueryDone, 0);
+	}
+}
+
+//**************************************************************************************************
+// Result of a queued command of the rate change.
+void radioBaudSetDone(const struct tXbeeAtResult *psResult){
+	if(psResult->status != XBEE_AT_STATUS_OK){
+		g_bRadioBaudFailed = true;
+	}
+}
+
+//**************************************************************************************************
+// The module sends the AC response at the old rate and then applies the queued changes, so UART1
+// follows once the response is in. Frames sent in between may be lost; the transmit window and
+// reliable layer resend them.
+void radioBaudApplied(const struct tXbeeAtResult *psResult){
+	char cBaudString[48];
+
+	if(psResult->status == XBEE_AT_STATUS_OK && !g_bRadioBaudFailed){
+		UARTStdioBaudSet(g_psUART1Stdio, XBEE_BAUD, UART1_CLOCK_HZ);
+		g_ui32RadioLinkBaud = XBEE_BAUD;
+		usprintf(cBaudString, "Radio link at %d baud\n\r", XBEE_BAUD);
+		UART0Send((uint8_t *)cBaudString);
+	}
+	else{
+		UART0Send((uint8_t *)"Radio baud change failed, link kept\n\r");
+	}
+	radioQueriesStart();
+}
+
+//**************************************************************************************************
+// Move the module to XBEE_BAUD, with RTS flow control when XBEE_FLOW_CONTROL is set. The changes are
+// queued and applied together by AC, so a rejected rate leaves the module as it was.
+void radioBaudChange(void){
+	uint8_t pui8Rts[1] = {1};
+	uint8_t pui8Baud[4];
+	uint32_t ui32Baud = XBEE_BAUD;
+	uint8_t i;
+
+	for(i = 0; i < RADIO_BAUD_RATES; i++){
+		if(g_pui32RadioBaudRates[i] == XBEE_BAUD){
+			ui32Baud = i;
+		}
+	}
+	pui8Baud[0] = ui32Baud >> 24;
+	pui8Baud[1] = ui32Baud >> 16;
+	pui8Baud[2] = ui32Baud >> 8;
+	pui8Baud[3] = ui32Baud;
+
+	g_bRadioBaudFailed = false;
+	if(XBEE_FLOW_CONTROL){
+		XbeeAtCommand("D6", pui8Rts, sizeof(pui8Rts), true, radioBaudSetDone, 0);
+	}
+	XbeeAtCommand("BD", pui8Baud, sizeof(pui8Baud), true, radioBaudSetDone, 0);
+	XbeeAtCommand("AC", 0, 0, false, radioBaudApplied, 0);
+}
+
+//**************************************************************************************************
+// Switch frame codec to the API mode of the module, then read the rest of the radio settings. The
+// ATAP query is the first frame sent and its bytes need no escaping, so the module understands it
+// in either mode. Without answer at XBEE_BAUD the query is repeated at XBEE_BAUD_BOOT, without
+// answer there the escaped mode is kept.
+void radioApiModeDone(const struct tXbeeAtResult *psResult){
+	uint32_t ui32Mode = radioValueGet(psResult);
+
+	if(psResult->status == XBEE_AT_STATUS_TIMEOUT && g_ui32RadioLinkBaud != XBEE_BAUD_BOOT){
+		UARTStdioBaudSet(g_psUART1Stdio, XBEE_BAUD_BOOT, UART1_CLOCK_HZ);
+		g_ui32RadioLinkBaud = XBEE_BAUD_BOOT;
+		XbeeAtQuery("AP", radioApiModeDone, 0);
+		return;
+	}
+
+	if(psResult->status == XBEE_AT_STATUS_OK &&
+	   (ui32Mode == API_MODE_UNESCAPED || ui32Mode == API_MODE_ESCAPED)){
+		g_sRadioInfo.ui8ApiMode = ui32Mode;
+		XbeeZB.setApiMode(ui32Mode);
+	}
+	else{
+		UART0Send((uint8_t *)"Radio API mode unknown, escaped mode kept\n\r");
+	}
+
+	if(g_ui32RadioLinkBaud != XBEE_BAUD || XBEE_FLOW_CONTROL){
+		radioBaudChange();
+	}
+	else{
+		radioQueriesStart();
+	}
+}
+
+//**************************************************************************************************
+// ZB Receive Packet handler. The source network address is learned for later frames to it. Reliable
+// layer payloads and fragments are handled by their layers, other payloads are plain text commands.
+void xbeeRxPacketHandler(const struct tXbeeApiFrame *psFrame){
+	XbeeAddrLearn(psFrame->u.rxPacket.srcAddr64, psFrame->u.rxPacket.srcAddr16);
+	if(!XbeeReliableReceive(&psFrame->u.rxPacket) &&
+	   !XbeeFragmentReceive(&psFrame->u.rxPacket, TimebaseMsGet())){
+		xbeeCmdCopy(&psFrame->u.rxPacket.data);
+	}
+}
+
+//**************************************************************************************************
+// The interrupt handler for TIMER0 interrupt. It periodically requests a sensors report. The report
+// is assembled and sent from main context so this handler stays short.
+void Timer0IntHandler(void){
+    // Clear the timer interrupt.
+    ROM_TimerIntClear(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+
+    WorkQueuePost(WORK_SENSOR_REPORT);
+}
+
 //**************************************************************************************************
 int main(void){
 	// Setup the system clock to run at 80 Mhz from PLL with crystal reference
@@ -185,10 +504,15 @@ int main(void){
 	ROM_GPIOPinTypeGPIOOutput(GPIO_PORTF_BASE, LED_RED|LED_BLUE|LED_GREEN);
 
 	ConfigureTimer0(TIMER0_PERIOD);
+	ConfigureSysTick(TIMEBASE_TICKS_PER_SECOND);
 	ConfigureUART0();
-	ConfigureUART1();
+	ConfigureUDMA();
+	ConfigureUART1(XBEE_BAUD, XBEE_FLOW_CONTROL, XBEE_RX_DMA);
 	ConfigureI2C3();
 
+	// The xbee object is built before main(), it can only use UART1 from here.
+	XbeeZB.begin();
+
 	// Prompt for text to be entered.
 	UART0Send((uint8_t *)"\n\rWSN Tiva TM4C123G + Xbee Module\n\r");
 
@@ -198,122 +522,105 @@ int main(void){
     // Initialize the I2C3 peripheral.
     I2CMInit(&g_sI2CInst, I2C3_BASE, INT_I2C3, 0xff, 0xff, ROM_SysCtlClockGet());
 
-
-    // Initialize the BMP180.
-    BMP180Init(&g_sBMP180Inst, &g_sI2CInst, BMP180_I2C_ADDRESS, SensorAppCallback, &g_sBMP180Inst);
-    // Wait for initialization callback to indicate reset request is complete.
-    while(g_vui8DataFlag == 0){
-        // Wait for I2C Transactions to complete.
-    }
-    g_vui8DataFlag = 0;		// Reset the data ready flag
-    ROM_SysCtlDelay(ROM_SysCtlClockGet()/(30*3));
-
-
-    // Initialize the SHT21.
-    SHT21Init(&g_sSHT21Inst, &g_sI2CInst, SHT21_I2C_ADDRESS, SensorAppCallback, &g_sSHT21Inst);
-    // Wait for initialization callback to indicate reset request is complete.
-	while(g_vui8DataFlag == 0){
-		// Wait for I2C Transactions to complete.
-	}
-	g_vui8DataFlag = 0;		// Reset the data ready flag
-	ROM_SysCtlDelay(ROM_SysCtlClockGet()/(30*3));
-
-
-	// Initialize the ISL29023 Driver.
-	ISL29023Init(&g_sISL29023Inst, &g_sI2CInst, ISL29023_I2C_ADDRESS, SensorAppCallback, &g_sISL29023Inst);
-    // Wait for initialization callback to indicate reset request is complete.
-	while(g_vui8DataFlag == 0){
-		// Wait for I2C Transactions to complete.
-	}
-	// Configure the ISL29023 to measure ambient light continuously. Set a 8
-	// sample persistence before the INT pin is asserted. Clears the INT flag.
-	// Persistence setting of 8 is sufficient to ignore camera flashes.
-	uint8_t ui8Mask = (ISL29023_CMD_I_OP_MODE_M | ISL29023_CMD_I_INT_PERSIST_M | ISL29023_CMD_I_INT_FLAG_M);
-	ISL29023ReadModifyWrite(&g_sISL29023Inst, ISL29023_O_CMD_I, ~ui8Mask,
-							(ISL29023_CMD_I_OP_MODE_ALS_CONT | ISL29023_CMD_I_INT_PERSIST_8),
-							SensorAppCallback, &g_sISL29023Inst);
-    // Wait for initialization callback to indicate reset request is complete.
-	while(g_vui8DataFlag == 0){
-		// Wait for I2C Transactions to complete.
-	}
-	ROM_SysCtlDelay(ROM_SysCtlClockGet()/(30*3));
+    // Sensors are reset and configured by the scheduler from the main loop.
+    SensorSchedulerInit(&g_sI2CInst);
+
+    // Samples are batched up to the largest RF payload, or until the oldest is too old.
+    // Batches leave room for the reliable layer header.
+    SensorReportBatchInit(&g_sReportBatch, XBEE_RELIABLE_MAX_DATA, REPORT_BATCH_MAX_AGE_MS);
+
+    // Work deferred from interrupt handlers.
+    WorkQueueRegister(WORK_SENSOR_REPORT, sensorReportSend);
+
+    // Source routes are only learned on a concentrator. On this sensor node the cache stays empty.
+    XbeeAddrTableInit(&XbeeZB);
+    XbeeSourceRouteInit(&XbeeZB);
+    // Reports are tracked until the module returns their ZB Transmit Status.
+    XbeeTxWindowInit(&XbeeZB, reportTxDone);
+    // The boot count tells peers that reliable sequence numbers restarted.
+    XbeeReliableInit(&XbeeZB, (uint8_t)BootCountUpdate(), xbeeReliableDeliver, reportReliableDone);
+    XbeeFragmentInit(&XbeeZB, xbeeFragmentDeliver);
+    XbeeAtInit(&XbeeZB);
+
+    // Received frames routed by frame type.
+    XbeeFrameHandlerSet(ZB_RECEIVE_PACKET, xbeeRxPacketHandler);
+    XbeeFrameHandlerSet(ZB_TRANSMIT_STATUS, XbeeTxWindowStatusHandler);
+    XbeeFrameHandlerSet(ROUTE_RECORD_INDICATOR, XbeeSourceRouteRecordHandler);
+    XbeeFrameHandlerSet(MANY_TO_ONE_ROUTE_REQUEST_INDICATOR, XbeeSourceRouteManyToOneHandler);
+    XbeeFrameHandlerSet(AT_COMMAND_RESPONSE, XbeeAtResponseHandler);
+    XbeeFrameHandlerSet(REMOTE_COMMAND_RESPONSE, XbeeAtRemoteResponseHandler);
+
+    // Read the radio API mode, identity and settings. The results arrive while the main loop runs.
+    // The first query also finds the module rate, XBEE_BAUD or XBEE_BAUD_BOOT.
+    XbeeAtQuery("AP", radioApiModeDone, 0);
 
 	// Store return value from xbeeCmdLineProcess
 	int8_t i32CommandStatus;
+	// Oldest received frame.
+	const struct tXbeeRxSlot *psRxFrame;
 
 	while(1){
-		// Enter when new packet has arrived in UART1.
-		if(UARTRxBytesAvail()){
-			XbeeZB.ZBReceivePacket();
+		// Enter when a complete frame is queued in the UART1 receive buffer. One frame is
+		// processed per pass, following frames wait in the queue.
+		psRxFrame = XbeeZB.ZBRxFrameReceive();
+		if(psRxFrame){
+			XbeeFrameDispatch(psRxFrame);
+			XbeeZB.ZBRxFrameRelease();
 		}
 
-		// Enter when xbee data message is retrieved from ZBReceivePacket frame.
-		if(XbeeZB.rxMsgPayloadComplete == true){
-			// Turn off the flag in order to enter just one time here.
-			XbeeZB.rxMsgPayloadComplete = false;
+		// Enter when xbee data message was received in a ZB Receive Packet frame.
+		if(g_bXbeeCmdPending){
+			g_bXbeeCmdPending = false;
 
 			// Pass xbee data message to command line processor.
-			i32CommandStatus = xbeeCmdLineProcess(XbeeZB.getRxMsgPayload());
+			i32CommandStatus = xbeeCmdLineProcess(g_ui8XbeeCmdLine);
 
 			// Handle the case of bad command.
-	        if(i32CommandStatus == CMDLINE_BAD_CMD){
-	        	UART0Send((uint8_t *)"Bad command!\n\r");
-	        }
-
-	        // Handle the case of too many arguments.
-	        else if(i32CommandStatus == CMDLINE_TOO_MANY_ARGS){
-	        	UART0Send((uint8_t *)"Too many arguments for xbee command processor!\n\r");
-	        }
+			if(i32CommandStatus == CMDLINE_BAD_CMD){
+				UART0Send((uint8_t *)"Bad command!\n\r");
+			}
+
+			// Handle the case of too many arguments.
+			else if(i32CommandStatus == CMDLINE_TOO_MANY_ARGS){
+				UART0Send((uint8_t *)"Too many arguments for xbee command processor!\n\r");
+			}
 		}
 
-		// Read the data from the BMP180 over I2C. This command starts a temperature measurement.
-		// Then polls until temperature is ready. Then automatically starts a pressure
-		// measurement and polls for that to complete. When both measurement are complete and in
-		// the local buffer then the application callback is called from the I2C interrupt context.
-		// Polling is done on I2C interrupts allowing processor to continue doing other tasks as needed.
-		BMP180DataRead(&g_sBMP180Inst, SensorAppCallback, &g_sBMP180Inst);
-		while(g_vui8DataFlag == 0){
-			// Wait for the new data set to be available.
-		}
-		g_vui8DataFlag = 0;		// Reset the data ready flag.
-		// Get a local copy of the latest temperature data in float format.
-		BMP180DataTemperatureGetFloat(&g_sBMP180Inst, &g_sSensorValues.fTemp);
-		floatToString(g_sSensorValues.fTemp, g_sSensorValues.cTempString);
-		// Get a local copy of the latest air pressure data in float format.
-		BMP180DataPressureGetFloat(&g_sBMP180Inst, &g_sSensorValues.fPres);
-		floatToString(g_sSensorValues.fPres, g_sSensorValues.cPresString);
-
-
-		// Write the command to start a humidity measurement.
-		SHT21Write(&g_sSHT21Inst, SHT21_CMD_MEAS_RH, g_sSHT21Inst.pui8Data, 0, SensorAppCallback, &g_sSHT21Inst);
-		while(g_vui8DataFlag == 0){
-			// Wait for the new data set to be available.
-		}
-		g_vui8DataFlag = 0;		// Reset the data ready flag.
-		// Wait 33 milliseconds before attempting to get the result. Datasheet
-		// claims this can take as long as 29 milliseconds.
-		ROM_SysCtlDelay(ROM_SysCtlClockGet() / (30 * 3));
-		// Get the raw data from the sensor over the I2C bus.
-		SHT21DataRead(&g_sSHT21Inst, SensorAppCallback, &g_sSHT21Inst);
-		while(g_vui8DataFlag == 0){
-			// Wait for the new data set to be available.
+		// Advance the sensor state machines. This never waits on the I2C bus or on a
+		// sensor conversion, so xbee frames keep being serviced during a sweep.
+		if(SensorSchedulerProcess(TimebaseMsGet())){
+			tSensorReadings sReadings;
+			SensorSchedulerReadingsGet(&sReadings);
+
+			g_sSensorValues.fTemp = sReadings.fTemp;
+			g_sSensorValues.fPres = sReadings.fPres;
+			g_sSensorValues.fHum = sReadings.fHum;
+			g_sSensorValues.fLight = sReadings.fLight;
 		}
-		g_vui8DataFlag = 0;		// Reset the data ready flag.
-		// Get a copy of the most recent raw data in floating point format.
-		SHT21DataHumidityGetFloat(&g_sSHT21Inst, &g_sSensorValues.fHum);
-		g_sSensorValues.fHum *= 100.0f;		// Multiply by 100 to return percentage.
-		floatToString(g_sSensorValues.fHum, g_sSensorValues.cHumString);
 
+		// Resend failed or unacknowledged reports and time out missing transmit statuses.
+		XbeeTxWindowProcess(TimebaseMsGet());
+		XbeeReliableProcess(TimebaseMsGet());
+
+		// Stream pending fragments and drop incomplete messages.
+		XbeeFragmentProcess(TimebaseMsGet());
+
+		// Send queued AT commands and time out missing responses.
+		XbeeAtProcess(TimebaseMsGet());
+
+		// Run work posted by interrupt handlers.
+		WorkQueueRun();
+
+		// Enforce the staleness bound of batched samples between reports.
+		if(SensorReportFormatGet() == REPORT_FORMAT_BATCH){
+			reportBatchFlush();
+		}
 
-		// Go get the latest data from the sensor.
-		ISL29023DataRead(&g_sISL29023Inst, SensorAppCallback, &g_sISL29023Inst);
-		while(g_vui8DataFlag == 0){
-			// Wait for the new data set to be available.
+		// End the report LED blink.
+		if(g_bLedOn && TimebaseDeadlineReached(TimebaseMsGet(), g_ui32LedOffMs)){
+			g_bLedOn = false;
+			ROM_GPIOPinWrite(GPIO_PORTF_BASE, LED_RED|LED_GREEN|LED_BLUE, 0);
 		}
-		g_vui8DataFlag = 0;		// Reset the data ready flag.
-		// Get a local floating point copy of the latest light data
-		ISL29023DataLightVisibleGetFloat(&g_sISL29023Inst, &g_sSensorValues.fLight);
-		floatToString(g_sSensorValues.fLight, g_sSensorValues.cLightString);
 	}
 }
 
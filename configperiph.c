@@ -9,15 +9,34 @@
 #include <stdbool.h>
 #include "inc/hw_ints.h"
 #include "inc/hw_memmap.h"
+#include "driverlib/eeprom.h"
 #include "driverlib/gpio.h"
 #include "driverlib/pin_map.h"
 #include "driverlib/rom.h"
 #include "driverlib/sysctl.h"
+#include "driverlib/systick.h"
 #include "driverlib/timer.h"
 #include "driverlib/uart.h"
-#include "utils/uartstdio.h"
+#include "driverlib/udma.h"
+#include "lib_utils/uartstdio.h"
 #include "configperiph.h"
 
+// uDMA channel control table, aligned on 1024 bytes as the controller requires.
+#if defined(ccs)
+#pragma DATA_ALIGN(g_pui8DMAControlTable, 1024)
+uint8_t g_pui8DMAControlTable[1024];
+#else
+uint8_t g_pui8DMAControlTable[1024] __attribute__ ((aligned(1024)));
+#endif
+
+// UART0 console, buffered on its own so diagnostics never wait for the radio or block it.
+tUARTStdioInstance g_sUART0Stdio;
+static unsigned char g_pui8UART0RxBuffer[UART0_RX_BUFFER_SIZE];
+static unsigned char g_pui8UART0TxBuffer[UART0_TX_BUFFER_SIZE];
+
+// UART1 xbee link, the instance behind the UARTStdioConfig() functions used by the xbee driver.
+tUARTStdioInstance *g_psUART1Stdio;
+
 void ConfigureTimer0 (uint16_t timePeriod) {
 	// Enable Timer0
 	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
@@ -28,6 +47,13 @@ void ConfigureTimer0 (uint16_t timePeriod) {
 	ROM_TimerEnable(TIMER0_BASE, TIMER_A);
 }
 
+void ConfigureSysTick(uint32_t ui32TicksPerSecond){
+	// SysTick drives the millisecond timebase used for non-blocking deadlines.
+	ROM_SysTickPeriodSet(ROM_SysCtlClockGet() / ui32TicksPerSecond);
+	ROM_SysTickIntEnable();
+	ROM_SysTickEnable();
+}
+
 void ConfigureUART0(void){
     // Enable the GPIO Peripheral used by the UART.
     ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
@@ -41,10 +67,25 @@ void ConfigureUART0(void){
 
     // Configure UART clock using UART utils. The above line does not work by itself to enable the UART.
     ROM_UARTClockSourceSet(UART0_BASE, UART_CLOCK_PIOSC);
-    ROM_UARTConfigSetExpClk(UART0_BASE, 16000000, 115200, (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE));
+
+    // Console output is queued and sent by the UART0 interrupt.
+    UARTStdioInit(&g_sUART0Stdio, 0, 115200, UART0_CLOCK_HZ,
+                  g_pui8UART0RxBuffer, UART0_RX_BUFFER_SIZE,
+                  g_pui8UART0TxBuffer, UART0_TX_BUFFER_SIZE);
+}
+
+void UART0IntHandler(void){
+	UARTStdioInstIntHandler(&g_sUART0Stdio);
 }
 
-void ConfigureUART1(void){
+void ConfigureUDMA(void){
+	// Enable the uDMA controller, used by UART1 reception.
+	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+	ROM_uDMAEnable();
+	ROM_uDMAControlBaseSet(g_pui8DMAControlTable);
+}
+
+void ConfigureUART1(uint32_t ui32Baud, bool bFlowControl, bool bRxDma){
     // Enable the GPIO Peripheral used by the UART.
     ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
     // Enable UART1
@@ -55,7 +96,17 @@ void ConfigureUART1(void){
 	ROM_GPIOPinConfigure(GPIO_PB1_U1TX);
 	ROM_GPIOPinTypeUART(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
 
+	// Set GPIO C4 as UART1 RTS, to the xbee RTS input (DIO6), and GPIO C5 as UART1 CTS, from
+	// the xbee CTS output (DIO7).
+	if(bFlowControl){
+		ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOC);
+		ROM_GPIOPinConfigure(GPIO_PC4_U1RTS);
+		ROM_GPIOPinConfigure(GPIO_PC5_U1CTS);
+		ROM_GPIOPinTypeUART(GPIO_PORTC_BASE, GPIO_PIN_4 | GPIO_PIN_5);
+	}
+
     // Configure UART clock using UART utils. The above line does not work by itself to enable the UART.
+    // PIOSC allows up to 1 Mbaud, above that the UART runs in high speed mode.
     ROM_UARTClockSourceSet(UART1_BASE, UART_CLOCK_PIOSC);
     /*
     ROM_UARTConfigSetExpClk(UART1_BASE, 16000000, 115200, (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE));
@@ -71,8 +122,22 @@ void ConfigureUART1(void){
 	ROM_UARTIntEnable(UART1_BASE, UART_INT_RX | UART_INT_RT);
 	*/
 
-	// Initialize the UART for console I/O.
-	UARTStdioConfig(1, 115200, 16000000);
+	// Initialize the UART for buffered I/O.
+	g_psUART1Stdio = UARTStdioConfig(1, ui32Baud, UART1_CLOCK_HZ);
+
+	// UART1 carries binary API frames. Raw mode stores them unchanged, while echo would inject
+	// received bytes in the middle of frames being transmitted to the xbee module.
+	UARTStdioRawModeSet(g_psUART1Stdio, true);
+
+	// With RTS/CTS a full receive buffer pauses the xbee instead of losing bytes.
+	UARTStdioFlowControlSet(g_psUART1Stdio, bFlowControl);
+
+	// Received bytes stored by the uDMA in blocks, one interrupt per block. ConfigureUDMA() must
+	// have been called.
+	if(bRxDma){
+		ROM_uDMAChannelAssign(UDMA_CH22_UART1RX);
+		UARTStdioRxDmaEnable(g_psUART1Stdio, UDMA_CHANNEL_UART1RX);
+	}
 }
 
 void ConfigureI2C3(void){
@@ -89,3 +154,18 @@ void ConfigureI2C3(void){
     ROM_GPIOPinTypeI2CSCL(GPIO_PORTD_BASE, GPIO_PIN_0);
     ROM_GPIOPinTypeI2C(GPIO_PORTD_BASE, GPIO_PIN_1);
 }
+
+uint32_t BootCountUpdate(void){
+	uint32_t ui32Count;
+
+	// The count lives in the first EEPROM word. An erased word reads 0xFFFFFFFF, so the first
+	// boot counts 0.
+	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+	if(EEPROMInit() != EEPROM_INIT_OK){
+		return 0;
+	}
+	EEPROMRead(&ui32Count, BOOT_COUNT_EEPROM_ADDR, sizeof(ui32Count));
+	ui32Count++;
+	EEPROMProgram(&ui32Count, BOOT_COUNT_EEPROM_ADDR, sizeof(ui32Count));
+	return ui32Count;
+}
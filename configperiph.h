@@ -8,6 +8,19 @@
 #ifndef INIT_CONFIG_H_
 #define INIT_CONFIG_H_
 
+#include "lib_utils/uartstdio.h"
+
+// UART0 and UART1 run from the 16 MHz precision internal oscillator.
+#define UART0_CLOCK_HZ		16000000
+#define UART1_CLOCK_HZ		16000000
+
+// UART0 console buffers. Console input is not used, output is a few lines at a time.
+#define UART0_RX_BUFFER_SIZE	64
+#define UART0_TX_BUFFER_SIZE	1024
+
+// EEPROM address of the boot counter.
+#define BOOT_COUNT_EEPROM_ADDR	0
+
 //*****************************************************************************
 // If building with a C++ compiler, make all of the definitions in this header
 // have a C binding.
@@ -17,10 +30,17 @@ extern "C"
 {
 #endif
 
+extern tUARTStdioInstance g_sUART0Stdio;		// UART0 console.
+extern tUARTStdioInstance *g_psUART1Stdio;		// UART1 xbee link.
+
 void ConfigureTimer0(uint16_t timePeriod);
+void ConfigureSysTick(uint32_t ui32TicksPerSecond);
 void ConfigureUART0(void);
-void ConfigureUART1(void);
+void UART0IntHandler(void);
+void ConfigureUDMA(void);
+void ConfigureUART1(uint32_t ui32Baud, bool bFlowControl, bool bRxDma);
 void ConfigureI2C3(void);
+uint32_t BootCountUpdate(void);
 
 //*****************************************************************************
 // Mark the end of the C bindings section for C++ compilers.
@@ -0,0 +1,33 @@
+/*
+ * timebase.c - Millisecond system tick used for non-blocking deadlines.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lib_utils/timebase.h"
+
+//*****************************************************************************
+// Milliseconds elapsed since SysTick was started. Wraps every ~49 days.
+static volatile uint32_t g_vui32TimebaseMs = 0;
+
+//*****************************************************************************
+// Get the current millisecond count.
+uint32_t TimebaseMsGet(void){
+	return g_vui32TimebaseMs;
+}
+
+//*****************************************************************************
+// Return true when ui32NowMs is at or past ui32DeadlineMs. Signed difference
+// keeps the comparison valid across the 32 bit counter wrap.
+bool TimebaseDeadlineReached(uint32_t ui32NowMs, uint32_t ui32DeadlineMs){
+	return ((int32_t)(ui32NowMs - ui32DeadlineMs) >= 0);
+}
+
+//*****************************************************************************
+// SysTick interrupt handler. Called every 1/TIMEBASE_TICKS_PER_SECOND seconds.
+void TimebaseIntHandler(void){
+	g_vui32TimebaseMs++;
+}
@@ -0,0 +1,35 @@
+/*
+ * timebase.h - Millisecond system tick used for non-blocking deadlines.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+//*****************************************************************************
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+// SysTick rate used by the timebase. One tick every millisecond.
+#define TIMEBASE_TICKS_PER_SECOND	1000
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern uint32_t TimebaseMsGet(void);
+extern bool TimebaseDeadlineReached(uint32_t ui32NowMs, uint32_t ui32DeadlineMs);
+extern void TimebaseIntHandler(void);
+
+//*****************************************************************************
+// Mark the end of the C bindings section for C++ compilers.
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMEBASE_H_ */
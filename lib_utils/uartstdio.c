@@ -35,7 +35,8 @@
 #include "driverlib/rom_map.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/uart.h"
-#include "utils/uartstdio.h"
+#include "driverlib/udma.h"
+#include "lib_utils/uartstdio.h"
 
 //*****************************************************************************
 //
@@ -46,82 +47,69 @@
 
 //*****************************************************************************
 //
-// If buffered mode is defined, set aside RX and TX buffers and read/write
-// pointers to control them.
+// If buffered mode is defined, set aside RX and TX buffers for the instance
+// configured with UARTStdioConfig(), which the functions without instance
+// argument use.
 //
 //*****************************************************************************
 #ifdef UART_BUFFERED
-
-//*****************************************************************************
-//
-// This global controls whether or not we are echoing characters back to the
-// transmitter.  By default, echo is enabled but if using this module as a
-// convenient method of implementing a buffered serial interface over which
-// you will be running an application protocol, you are likely to want to
-// disable echo by calling UARTEchoSet(false).
-//
-//*****************************************************************************
-static bool g_bDisableEcho;
-
-//*****************************************************************************
-//
-// Output ring buffer.  Buffer is full if g_ui32UARTTxReadIndex is one ahead of
-// g_ui32UARTTxWriteIndex.  Buffer is empty if the two indices are the same.
-//
-//*****************************************************************************
 static unsigned char g_pcUARTTxBuffer[UART_TX_BUFFER_SIZE];
-static volatile uint32_t g_ui32UARTTxWriteIndex = 0;
-static volatile uint32_t g_ui32UARTTxReadIndex = 0;
-
+static unsigned char g_pcUARTRxBuffer[UART_RX_BUFFER_SIZE];
+#endif
 //*****************************************************************************
 //
-// Input ring buffer.  Buffer is full if g_ui32UARTTxReadIndex is one ahead of
-// g_ui32UARTTxWriteIndex.  Buffer is empty if the two indices are the same.
+// The instance configured with UARTStdioConfig().
 //
 //*****************************************************************************
-static unsigned char g_pcUARTRxBuffer[UART_RX_BUFFER_SIZE];
-static volatile uint32_t g_ui32UARTRxWriteIndex = 0;
-static volatile uint32_t g_ui32UARTRxReadIndex = 0;
+static tUARTStdioInstance g_sUARTStdio;
 
+#ifdef UART_BUFFERED
 //*****************************************************************************
 //
 // Macros to determine number of free and used bytes in the transmit buffer.
 //
 //*****************************************************************************
-#define TX_BUFFER_USED          (GetBufferCount(&g_ui32UARTTxReadIndex,  \
-                                                &g_ui32UARTTxWriteIndex, \
-                                                UART_TX_BUFFER_SIZE))
-#define TX_BUFFER_FREE          (UART_TX_BUFFER_SIZE - TX_BUFFER_USED)
-#define TX_BUFFER_EMPTY         (IsBufferEmpty(&g_ui32UARTTxReadIndex,   \
-                                               &g_ui32UARTTxWriteIndex))
-#define TX_BUFFER_FULL          (IsBufferFull(&g_ui32UARTTxReadIndex,  \
-                                              &g_ui32UARTTxWriteIndex, \
-                                              UART_TX_BUFFER_SIZE))
-#define ADVANCE_TX_BUFFER_INDEX(Index) \
-                                (Index) = ((Index) + 1) % UART_TX_BUFFER_SIZE
+#define TX_BUFFER_USED(psInst) (GetBufferCount(&(psInst)->ui32TxReadIndex,  \
+                                                &(psInst)->ui32TxWriteIndex, \
+                                                (psInst)->ui32TxSize))
+#define TX_BUFFER_FREE(psInst) ((psInst)->ui32TxSize - TX_BUFFER_USED(psInst))
+#define TX_BUFFER_EMPTY(psInst) (IsBufferEmpty(&(psInst)->ui32TxReadIndex,   \
+                                               &(psInst)->ui32TxWriteIndex))
+#define TX_BUFFER_FULL(psInst) (IsBufferFull(&(psInst)->ui32TxReadIndex,  \
+                                              &(psInst)->ui32TxWriteIndex, \
+                                              (psInst)->ui32TxSize))
+#define ADVANCE_TX_BUFFER_INDEX(psInst, Index) \
+                                (Index) = ((Index) + 1) % (psInst)->ui32TxSize
 
 //*****************************************************************************
 //
 // Macros to determine number of free and used bytes in the receive buffer.
 //
 //*****************************************************************************
-#define RX_BUFFER_USED          (GetBufferCount(&g_ui32UARTRxReadIndex,  \
-                                                &g_ui32UARTRxWriteIndex, \
-                                                UART_RX_BUFFER_SIZE))
-#define RX_BUFFER_FREE          (UART_RX_BUFFER_SIZE - RX_BUFFER_USED)
-#define RX_BUFFER_EMPTY         (IsBufferEmpty(&g_ui32UARTRxReadIndex,   \
-                                               &g_ui32UARTRxWriteIndex))
-#define RX_BUFFER_FULL          (IsBufferFull(&g_ui32UARTRxReadIndex,  \
-                                              &g_ui32UARTRxWriteIndex, \
-                                              UART_RX_BUFFER_SIZE))
-#define ADVANCE_RX_BUFFER_INDEX(Index) \
-                                (Index) = ((Index) + 1) % UART_RX_BUFFER_SIZE
+#define RX_BUFFER_USED(psInst) (GetBufferCount(&(psInst)->ui32RxReadIndex,  \
+                                                &(psInst)->ui32RxWriteIndex, \
+                                                (psInst)->ui32RxSize))
+#define RX_BUFFER_FREE(psInst) ((psInst)->ui32RxSize - RX_BUFFER_USED(psInst))
+#define RX_BUFFER_EMPTY(psInst) (IsBufferEmpty(&(psInst)->ui32RxReadIndex,   \
+                                               &(psInst)->ui32RxWriteIndex))
+#define RX_BUFFER_FULL(psInst) (IsBufferFull(&(psInst)->ui32RxReadIndex,  \
+                                              &(psInst)->ui32RxWriteIndex, \
+                                              (psInst)->ui32RxSize))
+#define ADVANCE_RX_BUFFER_INDEX(psInst, Index) \
+                                (Index) = ((Index) + 1) % (psInst)->ui32RxSize
 #endif
 
-//**************************************************************************************
-// The base address of the chosen UART.
-//**************************************************************************************
-static uint32_t g_ui32Base = 0;
+//*****************************************************************************
+//
+// Cortex-M4 cycle counter, used to measure the time spent in the interrupt
+// handler.
+//
+//*****************************************************************************
+#define DEM_CR                  0xE000EDFC
+#define DEM_CR_TRCENA           0x01000000
+#define DWT_CTRL                0xE0001000
+#define DWT_CTRL_CYCCNTENA      0x00000001
+#define DWT_CYCCNT              0xE0001004
 
 //**************************************************************************************
 // A mapping from an integer between 0 and 15 to its ASCII character equivalent.
@@ -129,28 +117,21 @@ static uint32_t g_ui32Base = 0;
 static const char * const g_pcHex = "0123456789abcdef";
 
 //**************************************************************************************
-// The list of possible base addresses for the console UART.
+// The list of possible base addresses for the UARTs.
 //**************************************************************************************
 static const uint32_t g_ui32UARTBase[3] =
 {
     UART0_BASE, UART1_BASE, UART2_BASE
 };
 
-#ifdef UART_BUFFERED
 //**************************************************************************************
-// The list of possible interrupts for the console UART.
+// The list of possible interrupts for the UARTs.
 //**************************************************************************************
 static const uint32_t g_ui32UARTInt[3] =
 {
     INT_UART0, INT_UART1, INT_UART2
 };
 
-//**************************************************************************************
-// The port number in use.
-//**************************************************************************************
-static uint32_t g_ui32PortNum;
-#endif
-
 //**************************************************************************************
 // The list of UART peripherals.
 //**************************************************************************************
@@ -248,101 +229,470 @@ static uint32_t GetBufferCount(volatile uint32_t *pui32Read,
 // them into the UART transmit FIFO.
 //**************************************************************************************
 #ifdef UART_BUFFERED
-static void UARTPrimeTransmit(uint32_t ui32Base){
+static void UARTPrimeTransmit(tUARTStdioInstance *psInst){
     // Do we have any data to transmit?
-    if(!TX_BUFFER_EMPTY){
+    if(!TX_BUFFER_EMPTY(psInst)){
         // Disable the UART interrupt.  If we don't do this there is a race
         // condition which can cause the read index to be corrupted.
-        MAP_IntDisable(g_ui32UARTInt[g_ui32PortNum]);
+        MAP_IntDisable(psInst->ui32Int);
 
         // Yes - take some characters out of the transmit buffer and feed
         // them to the UART transmit FIFO.
-        while(MAP_UARTSpaceAvail(ui32Base) && !TX_BUFFER_EMPTY){
-            MAP_UARTCharPutNonBlocking(ui32Base, g_pcUARTTxBuffer[g_ui32UARTTxReadIndex]);
-            ADVANCE_TX_BUFFER_INDEX(g_ui32UARTTxReadIndex);
+        while(MAP_UARTSpaceAvail(psInst->ui32Base) && !TX_BUFFER_EMPTY(psInst)){
+            MAP_UARTCharPutNonBlocking(psInst->ui32Base, psInst->pui8TxBuffer[psInst->ui32TxReadIndex]);
+            ADVANCE_TX_BUFFER_INDEX(psInst, psInst->ui32TxReadIndex);
         }
 
         // Reenable the UART interrupt.
-        MAP_IntEnable(g_ui32UARTInt[g_ui32PortNum]);
+        MAP_IntEnable(psInst->ui32Int);
     }
 }
 #endif
 
 //**************************************************************************************
-//! Configures the UART console.
+// Raw mode version of UARTRxDrain(). The bytes are copied as received, with
+// no echo and no line editing, straight from the UART registers instead of
+// through the driver library. The inner loop copies up to the contiguous room
+// left in the receive buffer; its only test is the FIFO empty flag, and the
+// error flags are counted arithmetically. The write index is published once
+// per run of bytes.
+//**************************************************************************************
+#ifdef UART_BUFFERED
+static void UARTRxDrainRaw(tUARTStdioInstance *psInst){
+    unsigned char *pui8Buf;
+    uint32_t ui32Base;
+    uint32_t ui32Size;
+    uint32_t ui32Read;
+    uint32_t ui32Write;
+    uint32_t ui32Room;
+    uint32_t ui32Count;
+    uint32_t ui32Data;
+    uint32_t ui32Overruns;
+    uint32_t ui32Errors;
+    uint32_t ui32Used;
+
+    pui8Buf = psInst->pui8RxBuffer;
+    ui32Base = psInst->ui32Base;
+    ui32Size = psInst->ui32RxSize;
+    ui32Write = psInst->ui32RxWriteIndex;
+    ui32Overruns = 0;
+    ui32Errors = 0;
+
+    while(!(HWREG(ui32Base + UART_O_FR) & UART_FR_RXFE)){
+        // Room up to the read index, one byte short so a full buffer does
+        // not look empty, or up to the end of the buffer.
+        ui32Read = psInst->ui32RxReadIndex;
+        ui32Room = (ui32Read > ui32Write) ? (ui32Read - ui32Write - 1) :
+                   (ui32Size - ui32Write - (ui32Read == 0));
+
+        if(ui32Room == 0){
+            // With flow control the byte stays in the FIFO, which fills and
+            // deasserts RTS, until the reader frees space.
+            if(psInst->bFlowControl){
+                MAP_UARTIntDisable(ui32Base, UART_INT_RX | UART_INT_RT);
+                psInst->bRxHeld = true;
+                psInst->sStats.ui32RxHolds++;
+                break;
+            }
+            ui32Data = HWREG(ui32Base + UART_O_DR);
+            ui32Overruns += (ui32Data & UART_DR_OE) / UART_DR_OE;
+            ui32Errors += ((ui32Data & (UART_DR_FE | UART_DR_PE | UART_DR_BE)) + UART_DR_OE - UART_DR_FE) /
+                          UART_DR_OE;
+            psInst->sStats.ui32RxBytes++;
+            psInst->sStats.ui32RxDropped++;
+            continue;
+        }
+
+        // Copy while bytes are waiting and there is room. OE is the top error
+        // flag and FE the lowest; adding OE - FE carries any of FE, PE or BE
+        // into the OE bit.
+        ui32Count = 0;
+        do{
+            ui32Data = HWREG(ui32Base + UART_O_DR);
+            pui8Buf[ui32Write + ui32Count] = (unsigned char)ui32Data;
+            ui32Overruns += (ui32Data & UART_DR_OE) / UART_DR_OE;
+            ui32Errors += ((ui32Data & (UART_DR_FE | UART_DR_PE | UART_DR_BE)) + UART_DR_OE - UART_DR_FE) /
+                          UART_DR_OE;
+            ui32Count++;
+        }while((ui32Count < ui32Room) && !(HWREG(ui32Base + UART_O_FR) & UART_FR_RXFE));
+
+        // Publish the run to the reader.
+        ui32Write += ui32Count;
+        if(ui32Write == ui32Size){
+            ui32Write = 0;
+        }
+        psInst->ui32RxWriteIndex = ui32Write;
+        psInst->sStats.ui32RxBytes += ui32Count;
+
+        // A short run means the FIFO is empty.
+        if(ui32Count < ui32Room){
+            break;
+        }
+    }
+
+    psInst->sStats.ui32RxOverruns += ui32Overruns;
+    psInst->sStats.ui32RxErrors += ui32Errors;
+
+    // Keep the deepest fill level seen, to size the buffer.
+    ui32Used = RX_BUFFER_USED(psInst);
+    if(ui32Used > psInst->sStats.ui32RxMaxUsed){
+        psInst->sStats.ui32RxMaxUsed = ui32Used;
+    }
+}
+#endif
+
+//**************************************************************************************
+// Move the bytes waiting in the UART receive FIFO into the receive buffer. A
+// byte that finds the receive buffer full is thrown away, or, with flow control
+// enabled, left in the FIFO with the receive interrupts off until the reader
+// frees space. Called from the interrupt handler, or with its interrupt off.
+//**************************************************************************************
+#ifdef UART_BUFFERED
+static void UARTRxDrain(tUARTStdioInstance *psInst){
+    int8_t cChar;
+    int32_t i32Char;
+    uint32_t ui32Used;
+
+    // Binary data skips the per byte line discipline.
+    if(psInst->bRaw){
+        UARTRxDrainRaw(psInst);
+        return;
+    }
+
+    while(MAP_UARTCharsAvail(psInst->ui32Base)){
+        // With flow control the byte stays in the FIFO, which fills and
+        // deasserts RTS, until the reader frees space.
+        if(RX_BUFFER_FULL(psInst) && psInst->bFlowControl){
+            MAP_UARTIntDisable(psInst->ui32Base, UART_INT_RX | UART_INT_RT);
+            psInst->bRxHeld = true;
+            psInst->sStats.ui32RxHolds++;
+            break;
+        }
+
+        // Read a character
+        i32Char = MAP_UARTCharGetNonBlocking(psInst->ui32Base);
+        cChar = (unsigned char)(i32Char & 0xFF);
+        psInst->sStats.ui32RxBytes++;
+
+        // The error flags come with the byte they apply to. An overrun means
+        // bytes before this one were lost in the FIFO.
+        if(i32Char & UART_DR_OE){
+            psInst->sStats.ui32RxOverruns++;
+        }
+        if(i32Char & (UART_DR_FE | UART_DR_PE | UART_DR_BE)){
+            psInst->sStats.ui32RxErrors++;
+        }
+
+        // If echo is disabled, we skip the various text filtering operations
+        // that would typically be required when supporting a command line.
+        if(!psInst->bDisableEcho){
+            // Handle backspace by erasing the last character in the
+            // buffer.
+            if(cChar == '\b'){
+                // If there are any characters already in the buffer, then
+                // delete the last.
+                if(!RX_BUFFER_EMPTY(psInst)){
+                    // Rub out the previous character on the users terminal.
+                    UARTStdioWrite(psInst, "\b \b", 3);
+
+                    // Decrement the number of characters in the buffer.
+                    if(psInst->ui32RxWriteIndex == 0){
+                        psInst->ui32RxWriteIndex = psInst->ui32RxSize - 1;
+                    }
+                    else{
+                        psInst->ui32RxWriteIndex--;
+                    }
+                }
+
+                // Skip ahead to read the next character.
+                continue;
+            }
+
+            // If this character is LF and last was CR, then just gobble up
+            // the character since we already echoed the previous CR and we
+            // don't want to store 2 characters in the buffer if we don't need to.
+            if((cChar == '\n') && psInst->bLastWasCR){
+                psInst->bLastWasCR = false;
+                continue;
+            }
+
+            // See if a newline or escape character was received.
+            if((cChar == '\r') || (cChar == '\n') || (cChar == 0x1b)){
+                // If the character is a CR, then it may be followed by an
+                // LF which should be paired with the CR.  So remember that
+                // a CR was received.
+                if(cChar == '\r'){
+                    psInst->bLastWasCR = 1;
+                }
+
+                // Regardless of the line termination character received,
+                // put a CR in the receive buffer as a marker telling
+                // UARTgets() where the line ends.  We also send an
+                // additional LF to ensure that the local terminal echo
+                // receives both CR and LF.
+                cChar = '\r';
+                UARTStdioWrite(psInst, "\n", 1);
+            }
+        }
+
+        // If there is space in the receive buffer, put the character
+        // there, otherwise throw it away.
+        if(!RX_BUFFER_FULL(psInst)){
+            // Store the new character in the receive buffer
+            psInst->pui8RxBuffer[psInst->ui32RxWriteIndex] =
+                (unsigned char)(i32Char & 0xFF);
+            ADVANCE_RX_BUFFER_INDEX(psInst, psInst->ui32RxWriteIndex);
+
+            // Keep the deepest fill level seen, to size the buffer.
+            ui32Used = RX_BUFFER_USED(psInst);
+            if(ui32Used > psInst->sStats.ui32RxMaxUsed){
+                psInst->sStats.ui32RxMaxUsed = ui32Used;
+            }
+
+            // If echo is enabled, write the character to the transmit
+            // buffer so that the user gets some immediate feedback.
+            if(!psInst->bDisableEcho){
+                UARTStdioWrite(psInst, (const char *)&cChar, 1);
+            }
+        }
+        else{
+            psInst->sStats.ui32RxDropped++;
+        }
+    }
+}
+#endif
+
+//**************************************************************************************
+// Bring the uDMA receive state up to date: retire the blocks the uDMA
+// completed, move the write index to the last byte it stored, and hand it the
+// next blocks while the receive buffer has room for them. A block is only
+// handed over if filling it leaves the write index short of the read index,
+// otherwise the buffer would look empty. When no block is left the channel
+// stops and the bytes wait in the FIFO; with flow control RTS then holds the
+// sender off. Called from the interrupt handler, or with its interrupt off.
+//**************************************************************************************
+#ifdef UART_BUFFERED
+static void UARTRxDmaUpdate(tUARTStdioInstance *psInst){
+    uint32_t ui32Write;
+    uint32_t ui32Block;
+    uint32_t ui32Select;
+    uint32_t ui32Need;
+
+    while(1){
+        // Retire completed blocks. The uDMA switches to the other control
+        // structure by itself.
+        while(psInst->ui32RxDmaArmed &&
+              (MAP_uDMAChannelModeGet(psInst->ui32RxDmaChannel | psInst->ui32RxDmaSelect) == UDMA_MODE_STOP)){
+            psInst->ui32RxDmaBlock = (psInst->ui32RxDmaBlock + 1) % (psInst->ui32RxSize / UART_RX_DMA_BLOCK_SIZE);
+            psInst->ui32RxDmaSelect ^= UDMA_ALT_SELECT;
+            psInst->ui32RxDmaArmed--;
+            psInst->sStats.ui32RxDmaBlocks++;
+        }
+
+        // Bytes already stored in the block being filled.
+        ui32Write = psInst->ui32RxDmaBlock * UART_RX_DMA_BLOCK_SIZE;
+        if(psInst->ui32RxDmaArmed){
+            ui32Write += UART_RX_DMA_BLOCK_SIZE -
+                         MAP_uDMAChannelSizeGet(psInst->ui32RxDmaChannel | psInst->ui32RxDmaSelect);
+        }
+        ui32Write %= psInst->ui32RxSize;
+        psInst->sStats.ui32RxBytes += (ui32Write + psInst->ui32RxSize - psInst->ui32RxWriteIndex) %
+                                    psInst->ui32RxSize;
+        psInst->ui32RxWriteIndex = ui32Write;
+        if(RX_BUFFER_USED(psInst) > psInst->sStats.ui32RxMaxUsed){
+            psInst->sStats.ui32RxMaxUsed = RX_BUFFER_USED(psInst);
+        }
+
+        // Keep both control structures busy.
+        while(psInst->ui32RxDmaArmed < 2){
+            ui32Block = (psInst->ui32RxDmaBlock + psInst->ui32RxDmaArmed) % (psInst->ui32RxSize / UART_RX_DMA_BLOCK_SIZE);
+            ui32Need = ((ui32Block + 1) * UART_RX_DMA_BLOCK_SIZE + psInst->ui32RxSize - ui32Write) %
+                       psInst->ui32RxSize;
+            if(ui32Need >= RX_BUFFER_FREE(psInst)){
+                break;
+            }
+            ui32Select = psInst->ui32RxDmaArmed ? (psInst->ui32RxDmaSelect ^ UDMA_ALT_SELECT) : psInst->ui32RxDmaSelect;
+            MAP_uDMAChannelTransferSet(psInst->ui32RxDmaChannel | ui32Select, UDMA_MODE_PINGPONG,
+                                       (void *)(uintptr_t)(psInst->ui32Base + UART_O_DR),
+                                       &psInst->pui8RxBuffer[ui32Block * UART_RX_DMA_BLOCK_SIZE],
+                                       UART_RX_DMA_BLOCK_SIZE);
+            psInst->ui32RxDmaArmed++;
+        }
+
+        if(!psInst->ui32RxDmaArmed){
+            if(!psInst->bRxHeld){
+                psInst->bRxHeld = true;
+                psInst->sStats.ui32RxHolds++;
+            }
+            return;
+        }
+        psInst->bRxHeld = false;
+
+        if(MAP_uDMAChannelIsEnabled(psInst->ui32RxDmaChannel)){
+            return;
+        }
+
+        // The channel stopped on an empty control structure, possibly while
+        // the next block was being handed over. Retire what completed, then
+        // restart it on the control structure of psInst->ui32RxDmaBlock.
+        if(MAP_uDMAChannelModeGet(psInst->ui32RxDmaChannel | psInst->ui32RxDmaSelect) != UDMA_MODE_STOP){
+            if(psInst->ui32RxDmaSelect == UDMA_ALT_SELECT){
+                MAP_uDMAChannelAttributeEnable(psInst->ui32RxDmaChannel, UDMA_ATTR_ALTSELECT);
+            }
+            else{
+                MAP_uDMAChannelAttributeDisable(psInst->ui32RxDmaChannel, UDMA_ATTR_ALTSELECT);
+            }
+            MAP_uDMAChannelEnable(psInst->ui32RxDmaChannel);
+            return;
+        }
+    }
+}
+#endif
+
+//**************************************************************************************
+// Update the uDMA receive state from outside the interrupt handler, so the
+// bytes of a block still being filled can be read before it completes.
+//**************************************************************************************
+#ifdef UART_BUFFERED
+static void UARTRxDmaPoll(tUARTStdioInstance *psInst){
+    if(psInst->bRxDma){
+        MAP_IntDisable(psInst->ui32Int);
+        UARTRxDmaUpdate(psInst);
+        MAP_IntEnable(psInst->ui32Int);
+    }
+}
+#endif
+
+//**************************************************************************************
+// Called after the reader freed space in the receive buffer. If reception was
+// held by flow control, drain the FIFO and turn the receive interrupts back on.
+//**************************************************************************************
+#ifdef UART_BUFFERED
+static void UARTRxResume(tUARTStdioInstance *psInst){
+    // In uDMA mode blocks are handed back as soon as there is room.
+    if(psInst->bRxDma){
+        UARTRxDmaPoll(psInst);
+        return;
+    }
+    if(!psInst->bRxHeld){
+        return;
+    }
+
+    MAP_IntDisable(psInst->ui32Int);
+    psInst->bRxHeld = false;
+    UARTRxDrain(psInst);
+    if(!psInst->bRxHeld){
+        MAP_UARTIntEnable(psInst->ui32Base, UART_INT_RX | UART_INT_RT);
+    }
+    MAP_IntEnable(psInst->ui32Int);
+}
+#endif
+
+//**************************************************************************************
+//! Configures a UART instance.
 //!
-//! \param ui32PortNum is the number of UART port to use for the serial console
-//! (0-2)
+//! \param psInst points to the instance structure to fill.
+//! \param ui32PortNum is the number of UART port to use (0-2)
 //! \param ui32Baud is the bit rate that the UART is to be configured to use.
 //! \param ui32SrcClock is the frequency of the source clock for the UART
 //! module.
+//! \param pui8RxBuffer points to the receive ring buffer.
+//! \param ui32RxSize is the size of the receive ring buffer in bytes.
+//! \param pui8TxBuffer points to the transmit ring buffer.
+//! \param ui32TxSize is the size of the transmit ring buffer in bytes.
 //!
-//! This function will configure the specified serial port to be used as a
-//! serial console.  The serial parameters are set to the baud rate
-//! specified by the \e ui32Baud parameter and use 8 bit, no parity, and 1 stop
-//! bit.
+//! This function will configure the specified serial port.  The serial
+//! parameters are set to the baud rate specified by the \e ui32Baud parameter
+//! and use 8 bit, no parity, and 1 stop bit.  Each instance owns its port,
+//! ring buffers and statistics, so several UARTs can be buffered at once; the
+//! interrupt vector of the port must call UARTStdioInstIntHandler() with
+//! \e psInst.  The ring buffers are not used in non-buffered mode.
 //!
-//! This function must be called prior to using any of the other UART console
-//! functions: UARTprintf() or UARTgets().  This function assumes that the
-//! caller has previously configured the relevant UART pins for operation as a
-//! UART rather than as GPIOs.
+//! This function must be called prior to using any of the other functions on
+//! the instance.  This function assumes that the caller has previously
+//! configured the relevant UART pins for operation as a UART rather than as
+//! GPIOs.
 //!
 //! \return None.
 //**************************************************************************************
-void UARTStdioConfig(uint32_t ui32PortNum, uint32_t ui32Baud, uint32_t ui32SrcClock){
+void UARTStdioInit(tUARTStdioInstance *psInst, uint32_t ui32PortNum, uint32_t ui32Baud, uint32_t ui32SrcClock,
+                   unsigned char *pui8RxBuffer, uint32_t ui32RxSize,
+                   unsigned char *pui8TxBuffer, uint32_t ui32TxSize){
     // Check the arguments.
     ASSERT((ui32PortNum == 0) || (ui32PortNum == 1) ||
            (ui32PortNum == 2));
 
-#ifdef UART_BUFFERED
-    // In buffered mode, we only allow a single instance to be opened.
-    ASSERT(g_ui32Base == 0);
-#endif
-
     // Check to make sure the UART peripheral is present.
     if(!MAP_SysCtlPeripheralPresent(g_ui32UARTPeriph[ui32PortNum])){
         return;
     }
 
-    // Select the base address of the UART.
-    g_ui32Base = g_ui32UARTBase[ui32PortNum];
+    // Select the base address and interrupt of the UART.
+    psInst->ui32Base = g_ui32UARTBase[ui32PortNum];
+    psInst->ui32Int = g_ui32UARTInt[ui32PortNum];
+    psInst->ui32PortNum = ui32PortNum;
 
     // Enable the UART peripheral for use.
     MAP_SysCtlPeripheralEnable(g_ui32UARTPeriph[ui32PortNum]);
 
     // Configure the UART for 115200, n, 8, 1
-    MAP_UARTConfigSetExpClk(g_ui32Base, ui32SrcClock, ui32Baud,
+    MAP_UARTConfigSetExpClk(psInst->ui32Base, ui32SrcClock, ui32Baud,
                             (UART_CONFIG_PAR_NONE | UART_CONFIG_STOP_ONE |
                              UART_CONFIG_WLEN_8));
 
 #ifdef UART_BUFFERED
     // Set the UART to interrupt whenever the TX FIFO is almost empty or
     // when any character is received.
-    MAP_UARTFIFOLevelSet(g_ui32Base, UART_FIFO_TX1_8, UART_FIFO_RX1_8);
-
-    // Flush both the buffers.
-    UARTFlushRx();
-    UARTFlushTx(true);
-
-    // Remember which interrupt we are dealing with.
-    g_ui32PortNum = ui32PortNum;
+    MAP_UARTFIFOLevelSet(psInst->ui32Base, UART_FIFO_TX1_8, UART_FIFO_RX1_8);
+
+    // Hook up the ring buffers and flush them.
+    ASSERT(pui8RxBuffer && ui32RxSize);
+    ASSERT(pui8TxBuffer && ui32TxSize);
+    psInst->pui8RxBuffer = pui8RxBuffer;
+    psInst->ui32RxSize = ui32RxSize;
+    psInst->pui8TxBuffer = pui8TxBuffer;
+    psInst->ui32TxSize = ui32TxSize;
+    psInst->ui32RxReadIndex = 0;
+    psInst->ui32RxWriteIndex = 0;
+    psInst->ui32TxReadIndex = 0;
+    psInst->ui32TxWriteIndex = 0;
+    UARTStdioFlushRx(psInst);
+    UARTStdioFlushTx(psInst, true);
+
+    // Echo on, no completion callback.
+    psInst->bDisableEcho = false;
+    psInst->bLastWasCR = false;
+    psInst->pfnTxDone = 0;
+    psInst->bTxDonePending = false;
+
+    // Raw mode, flow control and uDMA reception stay off until enabled.
+    psInst->bRaw = false;
+    psInst->bFlowControl = false;
+    psInst->bRxHeld = false;
+    psInst->bRxDma = false;
+    UARTStdioStatsClear(psInst);
+
+    // Start the cycle counter used to measure the interrupt handler.
+    HWREG(DEM_CR) |= DEM_CR_TRCENA;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
 
     // We are configured for buffered output so enable the master interrupt
     // for this UART and the receive interrupts.  We don't actually enable the
     // transmit interrupt in the UART itself until some data has been placed
     // in the transmit buffer.
-    MAP_UARTIntDisable(g_ui32Base, 0xFFFFFFFF);
-    MAP_UARTIntEnable(g_ui32Base, UART_INT_RX | UART_INT_RT);
-    MAP_IntEnable(g_ui32UARTInt[ui32PortNum]);
+    MAP_UARTIntDisable(psInst->ui32Base, 0xFFFFFFFF);
+    MAP_UARTIntEnable(psInst->ui32Base, UART_INT_RX | UART_INT_RT);
+    MAP_IntEnable(psInst->ui32Int);
 #endif
 
     // Enable the UART operation.
-    MAP_UARTEnable(g_ui32Base);
+    MAP_UARTEnable(psInst->ui32Base);
 }
 
 //**************************************************************************************
 //! Writes a string of characters to the UART output.
 //!
+//! \param psInst points to the UART instance.
 //! \param pcBuf points to a buffer containing the string to transmit.
 //! \param ui32Len is the length of the string to transmit.
 //!
@@ -362,22 +712,22 @@ void UARTStdioConfig(uint32_t ui32PortNum, uint32_t ui32Baud, uint32_t ui32SrcCl
 //!
 //! \return Returns the count of characters written.
 //**************************************************************************************
-int UARTwrite(const char *pcBuf, uint32_t ui32Len){
+int UARTStdioWrite(tUARTStdioInstance *psInst, const char *pcBuf, uint32_t ui32Len){
 #ifdef UART_BUFFERED
     unsigned int uIdx;
 
     // Check for valid arguments.
     ASSERT(pcBuf != 0);
-    ASSERT(g_ui32Base != 0);
+    ASSERT(psInst->ui32Base != 0);
 
     // Send the characters
     for(uIdx = 0; uIdx < ui32Len; uIdx++){
         // If the character to the UART is \n, then add a \r before it so that
         // \n is translated to \n\r in the output.
         if(pcBuf[uIdx] == '\n'){
-            if(!TX_BUFFER_FULL){
-                g_pcUARTTxBuffer[g_ui32UARTTxWriteIndex] = '\r';
-                ADVANCE_TX_BUFFER_INDEX(g_ui32UARTTxWriteIndex);
+            if(!TX_BUFFER_FULL(psInst)){
+                psInst->pui8TxBuffer[psInst->ui32TxWriteIndex] = '\r';
+                ADVANCE_TX_BUFFER_INDEX(psInst, psInst->ui32TxWriteIndex);
             }
             else{
                 // Buffer is full - discard remaining characters and return.
@@ -386,9 +736,9 @@ int UARTwrite(const char *pcBuf, uint32_t ui32Len){
         }
 
         // Send the character to the UART output.
-        if(!TX_BUFFER_FULL){
-            g_pcUARTTxBuffer[g_ui32UARTTxWriteIndex] = pcBuf[uIdx];
-            ADVANCE_TX_BUFFER_INDEX(g_ui32UARTTxWriteIndex);
+        if(!TX_BUFFER_FULL(psInst)){
+            psInst->pui8TxBuffer[psInst->ui32TxWriteIndex] = pcBuf[uIdx];
+            ADVANCE_TX_BUFFER_INDEX(psInst, psInst->ui32TxWriteIndex);
         }
         else{
             // Buffer is full - discard remaining characters and return.
@@ -396,10 +746,14 @@ int UARTwrite(const char *pcBuf, uint32_t ui32Len){
         }
     }
 
+    // Count what did not fit.
+    psInst->sStats.ui32TxDropped += ui32Len - uIdx;
+
     // If we have anything in the buffer, make sure that the UART is set up to transmit it.
-    if(!TX_BUFFER_EMPTY){
-        UARTPrimeTransmit(g_ui32Base);
-        MAP_UARTIntEnable(g_ui32Base, UART_INT_TX);
+    if(!TX_BUFFER_EMPTY(psInst)){
+        UARTPrimeTransmit(psInst);
+        MAP_UARTTxIntModeSet(psInst->ui32Base, UART_TXINT_MODE_FIFO);
+        MAP_UARTIntEnable(psInst->ui32Base, UART_INT_TX);
     }
 
     // Return the number of characters written.
@@ -408,7 +762,7 @@ int UARTwrite(const char *pcBuf, uint32_t ui32Len){
     unsigned int uIdx;
 
     // Check for valid UART base address, and valid arguments.
-    ASSERT(g_ui32Base != 0);
+    ASSERT(psInst->ui32Base != 0);
     ASSERT(pcBuf != 0);
 
     // Send the characters
@@ -418,11 +772,11 @@ int UARTwrite(const char *pcBuf, uint32_t ui32Len){
         // \n is translated to \n\r in the output.
         //
         if(pcBuf[uIdx] == '\n'){
-            MAP_UARTCharPut(g_ui32Base, '\r');
+            MAP_UARTCharPut(psInst->ui32Base, '\r');
         }
 
         // Send the character to the UART output.
-        MAP_UARTCharPut(g_ui32Base, pcBuf[uIdx]);
+        MAP_UARTCharPut(psInst->ui32Base, pcBuf[uIdx]);
     }
 
     // Return the number of characters written.
@@ -430,9 +784,78 @@ int UARTwrite(const char *pcBuf, uint32_t ui32Len){
 #endif
 }
 
+//**************************************************************************************
+//! Writes a block of binary data to the UART output.
+//!
+//! \param psInst points to the UART instance.
+//! \param pui8Buf points to the data to transmit.
+//! \param ui32Len is the number of bytes to transmit.
+//!
+//! This function, available only when the module is built to operate in
+//! buffered mode using \b UART_BUFFERED, copies the block to the transmit
+//! buffer and returns immediately. Unlike UARTStdioWrite(), no character is
+//! translated and a null character does not end the block. The block is
+//! either queued completely or not at all, so a protocol frame is never split.
+//!
+//! When the last byte of the block has been shifted out of the UART, the
+//! function registered with UARTTxDoneCallbackSet() is called from interrupt
+//! context.
+//!
+//! \return Returns \e ui32Len if the block was queued or 0 if there was not
+//! enough space in the transmit buffer.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+int UARTStdioWriteRaw(tUARTStdioInstance *psInst, const uint8_t *pui8Buf, uint32_t ui32Len){
+    uint32_t ui32Idx;
+    uint32_t ui32Write;
+
+    // Check for valid arguments.
+    ASSERT(pui8Buf != 0);
+    ASSERT(psInst->ui32Base != 0);
+
+    // The buffer holds at most one byte less than its size.
+    if(ui32Len >= TX_BUFFER_FREE(psInst)){
+        psInst->sStats.ui32TxDropped += ui32Len;
+        return(0);
+    }
+
+    // Copy the block, then publish it to the interrupt handler in one store.
+    ui32Write = psInst->ui32TxWriteIndex;
+    for(ui32Idx = 0; ui32Idx < ui32Len; ui32Idx++){
+        psInst->pui8TxBuffer[ui32Write] = pui8Buf[ui32Idx];
+        ADVANCE_TX_BUFFER_INDEX(psInst, ui32Write);
+    }
+    psInst->bTxDonePending = true;
+    psInst->ui32TxWriteIndex = ui32Write;
+
+    // Make sure that the UART is set up to transmit it.
+    UARTPrimeTransmit(psInst);
+    MAP_UARTTxIntModeSet(psInst->ui32Base, UART_TXINT_MODE_FIFO);
+    MAP_UARTIntEnable(psInst->ui32Base, UART_INT_TX);
+
+    return(ui32Len);
+}
+#endif
+
+//**************************************************************************************
+//! Registers the transmit complete notification.
+//!
+//! \param psInst points to the UART instance.
+//! \param pfnCallback is the function called from interrupt context once all
+//! data queued with UARTwriteRaw() has left the transmitter, or 0 for none.
+//!
+//! \return None.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+void UARTStdioTxDoneCallbackSet(tUARTStdioInstance *psInst, void (*pfnCallback)(void)){
+    psInst->pfnTxDone = pfnCallback;
+}
+#endif
+
 //**************************************************************************************
 //! A simple UART based get string function, with some line processing.
 //!
+//! \param psInst points to the UART instance.
 //! \param pcBuf points to a buffer for the incoming string from the UART.
 //! \param ui32Len is the length of the buffer for storage of the string,
 //! including the trailing 0.
@@ -456,7 +879,7 @@ int UARTwrite(const char *pcBuf, uint32_t ui32Len){
 //!
 //! \return Returns the count of characters that were stored, not including the trailing 0.
 //**************************************************************************************
-int UARTgets(char *pcBuf, uint32_t ui32Len){
+int UARTStdioGets(tUARTStdioInstance *psInst, char *pcBuf, uint32_t ui32Len){
 #ifdef UART_BUFFERED
     uint32_t ui32Count = 0;
     int8_t cChar;
@@ -464,7 +887,7 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
     // Check the arguments.
     ASSERT(pcBuf != 0);
     ASSERT(ui32Len != 0);
-    ASSERT(g_ui32Base != 0);
+    ASSERT(psInst->ui32Base != 0);
 
     // Adjust the length back by 1 to leave space for the trailing null terminator.
     ui32Len--;
@@ -472,9 +895,11 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
     // Process characters until a newline is received.
     while(1){
         // Read the next character from the receive buffer.
-        if(!RX_BUFFER_EMPTY){
-            cChar = g_pcUARTRxBuffer[g_ui32UARTRxReadIndex];
-            ADVANCE_RX_BUFFER_INDEX(g_ui32UARTRxReadIndex);
+        UARTRxDmaPoll(psInst);
+        if(!RX_BUFFER_EMPTY(psInst)){
+            cChar = psInst->pui8RxBuffer[psInst->ui32RxReadIndex];
+            ADVANCE_RX_BUFFER_INDEX(psInst, psInst->ui32RxReadIndex);
+            UARTRxResume(psInst);
 
             // See if a newline or escape character was received.
             if((cChar == '\r') || (cChar == '\n') || (cChar == 0x1b)){
@@ -503,12 +928,11 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
 #else
     uint32_t ui32Count = 0;
     int8_t cChar;
-    static int8_t bLastWasCR = 0;
 
     // Check the arguments.
     ASSERT(pcBuf != 0);
     ASSERT(ui32Len != 0);
-    ASSERT(g_ui32Base != 0);
+    ASSERT(psInst->ui32Base != 0);
 
     // Adjust the length back by 1 to leave space for the trailing null terminator.
     ui32Len--;
@@ -516,14 +940,14 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
     // Process characters until a newline is received.
     while(1){
         // Read the next character from the console.
-        cChar = MAP_UARTCharGet(g_ui32Base);
+        cChar = MAP_UARTCharGet(psInst->ui32Base);
 
         // See if the backspace key was pressed.
         if(cChar == '\b'){
             // If there are any characters already in the buffer, then delete the last.
             if(ui32Count){
                 // Rub out the previous character.
-                UARTwrite("\b \b", 3);
+                UARTStdioWrite(psInst, "\b \b", 3);
 
                 // Decrement the number of characters in the buffer.
                 ui32Count--;
@@ -535,8 +959,8 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
 
         // If this character is LF and last was CR, then just gobble up the
         // character because the EOL processing was taken care of with the CR.
-        if((cChar == '\n') && bLastWasCR){
-            bLastWasCR = 0;
+        if((cChar == '\n') && psInst->bLastWasCR){
+            psInst->bLastWasCR = 0;
             continue;
         }
 
@@ -545,7 +969,7 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
             // If the character is a CR, then it may be followed by a LF which
             // should be paired with the CR.  So remember that a CR was received.
             if(cChar == '\r'){
-                bLastWasCR = 1;
+                psInst->bLastWasCR = 1;
             }
 
             // Stop processing the input and end the line.
@@ -563,7 +987,7 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
             ui32Count++;
 
             // Reflect the character back to the user.
-            MAP_UARTCharPut(g_ui32Base, cChar);
+            MAP_UARTCharPut(psInst->ui32Base, cChar);
         }
     }
 
@@ -571,7 +995,7 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
     pcBuf[ui32Count] = 0;
 
     // Send a CRLF pair to the terminal to end the line.
-    UARTwrite("\r\n", 2);
+    UARTStdioWrite(psInst, "\r\n", 2);
 
     // Return the count of int8_ts in the buffer, not counting the trailing 0.
     return(ui32Count);
@@ -581,6 +1005,8 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
 //**************************************************************************************
 //! Read a single character from the UART, blocking if necessary.
 //!
+//! \param psInst points to the UART instance.
+//!
 //! This function will receive a single character from the UART and store it at
 //! the supplied address.
 //!
@@ -591,24 +1017,26 @@ int UARTgets(char *pcBuf, uint32_t ui32Len){
 //!
 //! \return Returns the character read.
 //**************************************************************************************
-unsigned char UARTgetc(void){
+unsigned char UARTStdioGetc(tUARTStdioInstance *psInst){
 #ifdef UART_BUFFERED
     unsigned char cChar;
 
     // Wait for a character to be received.
-    while(RX_BUFFER_EMPTY){
+    while(RX_BUFFER_EMPTY(psInst)){
         // Block waiting for a character to be received (if the buffer is currently empty).
+        UARTRxDmaPoll(psInst);
     }
 
     // Read a character from the buffer.
-    cChar = g_pcUARTRxBuffer[g_ui32UARTRxReadIndex];
-    ADVANCE_RX_BUFFER_INDEX(g_ui32UARTRxReadIndex);
+    cChar = psInst->pui8RxBuffer[psInst->ui32RxReadIndex];
+    ADVANCE_RX_BUFFER_INDEX(psInst, psInst->ui32RxReadIndex);
+    UARTRxResume(psInst);
 
     // Return the character to the caller.
     return(cChar);
 #else
     // Block until a character is received by the UART then return it to the caller.
-    return(MAP_UARTCharGet(g_ui32Base));
+    return(MAP_UARTCharGet(psInst->ui32Base));
 #endif
 }
 
@@ -616,6 +1044,7 @@ unsigned char UARTgetc(void){
 //! A simple UART based vprintf function supporting \%c, \%d, \%p, \%s, \%u,
 //! \%x, and \%X.
 //!
+//! \param psInst points to the UART instance.
 //! \param pcString is the format string.
 //! \param vaArgP is a variable argument list pointer whose content will depend
 //! upon the format string passed in \e pcString.
@@ -648,7 +1077,7 @@ unsigned char UARTgetc(void){
 //!
 //! \return None.
 //**************************************************************************************
-void UARTvprintf(const char *pcString, va_list vaArgP){
+void UARTStdioVPrintf(tUARTStdioInstance *psInst, const char *pcString, va_list vaArgP){
     uint32_t ui32Idx, ui32Value, ui32Pos, ui32Count, ui32Base, ui32Neg;
     char *pcStr, pcBuf[16], cFill;
 
@@ -674,7 +1103,7 @@ void UARTvprintf(const char *pcString, va_list vaArgP){
         //
         // Write this portion of the string.
         //
-        UARTwrite(pcString, ui32Idx);
+        UARTStdioWrite(psInst, pcString, ui32Idx);
 
         //
         // Skip the portion of the string that was written.
@@ -758,7 +1187,7 @@ again:
                     //
                     // Print out the character.
                     //
-                    UARTwrite((char *)&ui32Value, 1);
+                    UARTStdioWrite(psInst, (char *)&ui32Value, 1);
 
                     //
                     // This command has been handled.
@@ -838,7 +1267,7 @@ again:
                     //
                     // Write the string.
                     //
-                    UARTwrite(pcStr, ui32Idx);
+                    UARTStdioWrite(psInst, pcStr, ui32Idx);
 
                     //
                     // Write any required padding spaces
@@ -848,7 +1277,7 @@ again:
                         ui32Count -= ui32Idx;
                         while(ui32Count--)
                         {
-                            UARTwrite(" ", 1);
+                            UARTStdioWrite(psInst, " ", 1);
                         }
                     }
 
@@ -996,7 +1425,7 @@ convert:
                     //
                     // Write the string.
                     //
-                    UARTwrite(pcBuf, ui32Pos);
+                    UARTStdioWrite(psInst, pcBuf, ui32Pos);
 
                     //
                     // This command has been handled.
@@ -1012,7 +1441,7 @@ convert:
                     //
                     // Simply write a single %.
                     //
-                    UARTwrite(pcString - 1, 1);
+                    UARTStdioWrite(psInst, pcString - 1, 1);
 
                     //
                     // This command has been handled.
@@ -1028,7 +1457,7 @@ convert:
                     //
                     // Indicate an error.
                     //
-                    UARTwrite("ERROR", 5);
+                    UARTStdioWrite(psInst, "ERROR", 5);
 
                     //
                     // This command has been handled.
@@ -1044,6 +1473,7 @@ convert:
 //! A simple UART based printf function supporting \%c, \%d, \%p, \%s, \%u,
 //! \%x, and \%X.
 //!
+//! \param psInst points to the UART instance.
 //! \param pcString is the format string.
 //! \param ... are the optional arguments, which depend on the contents of the
 //! format string.
@@ -1076,13 +1506,13 @@ convert:
 //!
 //! \return None.
 //**************************************************************************************
-void UARTprintf(const char *pcString, ...){
+void UARTStdioPrintf(tUARTStdioInstance *psInst, const char *pcString, ...){
     va_list vaArgP;
 
     // Start the varargs processing.
     va_start(vaArgP, pcString);
 
-    UARTvprintf(pcString, vaArgP);
+    UARTStdioVPrintf(psInst, pcString, vaArgP);
 
     // We're finished with the varargs now.
     va_end(vaArgP);
@@ -1091,6 +1521,8 @@ void UARTprintf(const char *pcString, ...){
 //**************************************************************************************
 //! Returns the number of bytes available in the receive buffer.
 //!
+//! \param psInst points to the UART instance.
+//!
 //! This function, available only when the module is built to operate in
 //! buffered mode using \b UART_BUFFERED, may be used to determine the number
 //! of bytes of data currently available in the receive buffer.
@@ -1098,8 +1530,9 @@ void UARTprintf(const char *pcString, ...){
 //! \return Returns the number of available bytes.
 //**************************************************************************************
 #if defined(UART_BUFFERED) || defined(DOXYGEN)
-int UARTRxBytesAvail(void){
-    return(RX_BUFFER_USED);
+int UARTStdioRxBytesAvail(tUARTStdioInstance *psInst){
+    UARTRxDmaPoll(psInst);
+    return(RX_BUFFER_USED(psInst));
 }
 #endif
 
@@ -1107,20 +1540,82 @@ int UARTRxBytesAvail(void){
 //**************************************************************************************
 //! Returns the number of bytes free in the transmit buffer.
 //!
+//! \param psInst points to the UART instance.
+//!
 //! This function, available only when the module is built to operate in
 //! buffered mode using \b UART_BUFFERED, may be used to determine the amount
 //! of space currently available in the transmit buffer.
 //!
 //! \return Returns the number of free bytes.
 //**************************************************************************************
-int UARTTxBytesFree(void){
-    return(TX_BUFFER_FREE);
+int UARTStdioTxBytesFree(tUARTStdioInstance *psInst){
+    return(TX_BUFFER_FREE(psInst));
+}
+#endif
+
+//**************************************************************************************
+//! Gives direct access to the receive ring buffer.
+//!
+//! \param psInst points to the UART instance.
+//!
+//! This function, available only when the module is built to operate in
+//! buffered mode using \b UART_BUFFERED, lets a protocol parser work on the
+//! received bytes in place instead of copying them out with UARTgetc(). The
+//! buffer is \b psInst->ui32RxSize bytes long. Bytes from the read index up
+//! to, but excluding, the write index are valid and belong to the caller until
+//! released with UARTRxBufferRelease(); the caller may rewrite them in place.
+//!
+//! \return Returns a pointer to the receive ring buffer.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+unsigned char *UARTStdioRxBufferGet(tUARTStdioInstance *psInst){
+    return(psInst->pui8RxBuffer);
+}
+#endif
+
+//**************************************************************************************
+//! Returns the ring index of the oldest byte not yet released.
+//!
+//! \param psInst points to the UART instance.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+uint32_t UARTStdioRxReadIndexGet(tUARTStdioInstance *psInst){
+    return(psInst->ui32RxReadIndex);
+}
+#endif
+
+//**************************************************************************************
+//! Returns the ring index where the interrupt handler stores the next byte.
+//!
+//! \param psInst points to the UART instance.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+uint32_t UARTStdioRxWriteIndexGet(tUARTStdioInstance *psInst){
+    UARTRxDmaPoll(psInst);
+    return(psInst->ui32RxWriteIndex);
+}
+#endif
+
+//**************************************************************************************
+//! Releases received bytes back to the interrupt handler.
+//!
+//! \param psInst points to the UART instance.
+//! \param ui32ReadIndex is the ring index of the first byte still in use. It
+//! must lie between the current read and write indices.
+//!
+//! \return None.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+void UARTStdioRxBufferRelease(tUARTStdioInstance *psInst, uint32_t ui32ReadIndex){
+    psInst->ui32RxReadIndex = ui32ReadIndex;
+    UARTRxResume(psInst);
 }
 #endif
 
 //**************************************************************************************
 //! Looks ahead in the receive buffer for a particular character.
 //!
+//! \param psInst points to the UART instance.
 //! \param ucChar is the character that is to be searched for.
 //!
 //! This function, available only when the module is built to operate in
@@ -1136,24 +1631,25 @@ int UARTTxBytesFree(void){
 //! of \e ucChar relative to the receive buffer read pointer.
 //**************************************************************************************
 #if defined(UART_BUFFERED) || defined(DOXYGEN)
-int UARTPeek(unsigned char ucChar){
+int UARTStdioPeek(tUARTStdioInstance *psInst, unsigned char ucChar){
     int iCount;
     int iAvail;
     uint32_t ui32ReadIndex;
 
     // How many characters are there in the receive buffer?
-    iAvail = (int)RX_BUFFER_USED;
-    ui32ReadIndex = g_ui32UARTRxReadIndex;
+    UARTRxDmaPoll(psInst);
+    iAvail = (int)RX_BUFFER_USED(psInst);
+    ui32ReadIndex = psInst->ui32RxReadIndex;
 
     // Check all the unread characters looking for the one passed.
     for(iCount = 0; iCount < iAvail; iCount++){
-        if(g_pcUARTRxBuffer[ui32ReadIndex] == ucChar){
+        if(psInst->pui8RxBuffer[ui32ReadIndex] == ucChar){
             // We found it so return the index
             return(iCount);
         }
         else{
             // This one didn't match so move on to the next character.
-            ADVANCE_RX_BUFFER_INDEX(ui32ReadIndex);
+            ADVANCE_RX_BUFFER_INDEX(psInst, ui32ReadIndex);
         }
     }
 
@@ -1165,6 +1661,8 @@ int UARTPeek(unsigned char ucChar){
 //**************************************************************************************
 //! Flushes the receive buffer.
 //!
+//! \param psInst points to the UART instance.
+//!
 //! This function, available only when the module is built to operate in
 //! buffered mode using \b UART_BUFFERED, may be used to discard any data
 //! received from the UART but not yet read using UARTgets().
@@ -1173,26 +1671,38 @@ int UARTPeek(unsigned char ucChar){
 //
 //**************************************************************************************
 #if defined(UART_BUFFERED) || defined(DOXYGEN)
-void UARTFlushRx(void){
+void UARTStdioFlushRx(tUARTStdioInstance *psInst){
     uint32_t ui32Int;
 
+    // In uDMA mode the write index follows the uDMA, so everything received
+    // so far is released instead.
+    if(psInst->bRxDma){
+        UARTRxDmaPoll(psInst);
+        UARTStdioRxBufferRelease(psInst, psInst->ui32RxWriteIndex);
+        return;
+    }
+
     // Temporarily turn off interrupts.
     ui32Int = MAP_IntMasterDisable();
 
     // Flush the receive buffer.
-    g_ui32UARTRxReadIndex = 0;
-    g_ui32UARTRxWriteIndex = 0;
+    psInst->ui32RxReadIndex = 0;
+    psInst->ui32RxWriteIndex = 0;
 
     // If interrupts were enabled when we turned them off, turn them back on again.
     if(!ui32Int){
         MAP_IntMasterEnable();
     }
+
+    // Bytes held back by flow control can now be received.
+    UARTRxResume(psInst);
 }
 #endif
 
 //**************************************************************************************
 //! Flushes the transmit buffer.
 //!
+//! \param psInst points to the UART instance.
 //! \param bDiscard indicates whether any remaining data in the buffer should
 //! be discarded (\b true) or transmitted (\b false).
 //!
@@ -1205,7 +1715,7 @@ void UARTFlushRx(void){
 //! \return None.
 //**************************************************************************************
 #if defined(UART_BUFFERED) || defined(DOXYGEN)
-void UARTFlushTx(bool bDiscard){
+void UARTStdioFlushTx(tUARTStdioInstance *psInst, bool bDiscard){
     uint32_t ui32Int;
 
     // Should the remaining data be discarded or transmitted?
@@ -1214,8 +1724,8 @@ void UARTFlushTx(bool bDiscard){
         ui32Int = MAP_IntMasterDisable();
 
         // Flush the transmit buffer.
-        g_ui32UARTTxReadIndex = 0;
-        g_ui32UARTTxWriteIndex = 0;
+        psInst->ui32TxReadIndex = 0;
+        psInst->ui32TxWriteIndex = 0;
 
         // If interrupts were enabled when we turned them off, turn them back on again.
         if(!ui32Int){
@@ -1224,7 +1734,7 @@ void UARTFlushTx(bool bDiscard){
     }
     else{
         // Wait for all remaining data to be transmitted before returning.
-        while(!TX_BUFFER_EMPTY){
+        while(!TX_BUFFER_EMPTY(psInst)){
         }
     }
 }
@@ -1233,6 +1743,7 @@ void UARTFlushTx(bool bDiscard){
 //**************************************************************************************
 //! Enables or disables echoing of received characters to the transmitter.
 //!
+//! \param psInst points to the UART instance.
 //! \param bEnable must be set to \b true to enable echo or \b false to
 //! disable it.
 //!
@@ -1249,14 +1760,222 @@ void UARTFlushTx(bool bDiscard){
 //! \return None.
 //**************************************************************************************
 #if defined(UART_BUFFERED) || defined(DOXYGEN)
-void UARTEchoSet(bool bEnable){
-    g_bDisableEcho = !bEnable;
+void UARTStdioEchoSet(tUARTStdioInstance *psInst, bool bEnable){
+    psInst->bDisableEcho = !bEnable;
+}
+#endif
+
+//**************************************************************************************
+//! Enables or disables raw mode.
+//!
+//! \param psInst points to the UART instance.
+//! \param bEnable must be set to \b true to receive binary data or \b false to
+//! go back to the command line handling.
+//!
+//! This function, available only when the module is built to operate in
+//! buffered mode using \b UART_BUFFERED, is for ports carrying a binary
+//! protocol.  In raw mode received bytes are stored unchanged: they are not
+//! echoed, whatever UARTStdioEchoSet() selected, and backspace, CR, LF and
+//! escape get no special handling.  The interrupt handler then copies the
+//! receive FIFO with a minimal loop instead of testing each byte.
+//!
+//! \return None.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+void UARTStdioRawModeSet(tUARTStdioInstance *psInst, bool bEnable){
+    ASSERT(psInst->ui32Base != 0);
+
+    MAP_IntDisable(psInst->ui32Int);
+    psInst->bRaw = bEnable;
+    psInst->bLastWasCR = false;
+    MAP_IntEnable(psInst->ui32Int);
+}
+#endif
+
+//**************************************************************************************
+//! Enables or disables RTS/CTS hardware flow control.
+//!
+//! \param psInst points to the UART instance.
+//! \param bEnable must be set to \b true to enable flow control or \b false to
+//! disable it.
+//!
+//! This function, available only when the module is built to operate in
+//! buffered mode using \b UART_BUFFERED, turns on both directions of hardware
+//! flow control.  The UART stops transmitting while CTS is deasserted, and
+//! deasserts RTS when its receive FIFO fills.  While the receive buffer is full,
+//! received bytes are left in the FIFO so RTS holds the sender off, instead of
+//! being thrown away.  Only UART1 has the flow control signals on TM4C123
+//! devices; the caller must configure the RTS and CTS pins beforehand.
+//!
+//! \return None.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+void UARTStdioFlowControlSet(tUARTStdioInstance *psInst, bool bEnable){
+    ASSERT(psInst->ui32Base != 0);
+
+    // RTS is deasserted once the receive FIFO reaches its interrupt level. At
+    // half full the sender still has room for the bytes it sends before it
+    // sees RTS, and the FIFO is drained in larger blocks.
+    MAP_UARTFIFOLevelSet(psInst->ui32Base, UART_FIFO_TX1_8, bEnable ? UART_FIFO_RX4_8 : UART_FIFO_RX1_8);
+    MAP_UARTFlowControlSet(psInst->ui32Base, bEnable ? (UART_FLOWCONTROL_TX | UART_FLOWCONTROL_RX) :
+                                                 UART_FLOWCONTROL_NONE);
+    psInst->bFlowControl = bEnable;
+
+    // Without flow control, held bytes are received again, or dropped if
+    // there is still no room.
+    if(!bEnable){
+        UARTRxResume(psInst);
+    }
+}
+#endif
+
+//**************************************************************************************
+//! Changes the bit rate of the console UART.
+//!
+//! \param psInst points to the UART instance.
+//! \param ui32Baud is the new bit rate.
+//! \param ui32SrcClock is the frequency of the source clock for the UART
+//! module.
+//!
+//! This function, available only when the module is built to operate in
+//! buffered mode using \b UART_BUFFERED, waits for the transmit buffer to
+//! empty and the last byte to leave the UART, then reprograms the bit rate.
+//! Bit rates above ui32SrcClock / 16 use the UART high speed mode.  The
+//! receive buffer, flow control and statistics are kept.
+//!
+//! \return None.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+void UARTStdioBaudSet(tUARTStdioInstance *psInst, uint32_t ui32Baud, uint32_t ui32SrcClock){
+    ASSERT(psInst->ui32Base != 0);
+
+    // Let pending output leave at the old rate.
+    UARTStdioFlushTx(psInst, false);
+    while(MAP_UARTBusy(psInst->ui32Base)){
+    }
+
+    // Reconfiguring disables the UART for a moment; interrupts stay enabled.
+    MAP_UARTConfigSetExpClk(psInst->ui32Base, ui32SrcClock, ui32Baud,
+                            (UART_CONFIG_PAR_NONE | UART_CONFIG_STOP_ONE |
+                             UART_CONFIG_WLEN_8));
+}
+#endif
+
+//**************************************************************************************
+//! Gets the statistics of an instance.
+//!
+//! \param psInst points to the UART instance.
+//! \param psStats points to the structure to fill.
+//!
+//! This function, available only when the module is built to operate in
+//! buffered mode using \b UART_BUFFERED, reports how many bytes were received
+//! and how many were lost, either in the UART receive FIFO (overruns) or
+//! because the receive buffer was full (dropped).  With flow control working
+//! both stay at zero.  Bytes refused because the transmit buffer was full
+//! are counted too.  The interrupt handler runs and the processor cycles
+//! spent in it, counted with the Cortex-M4 cycle counter, give the interrupt
+//! load; the cycles exclude the exception entry and return.
+//!
+//! \return None.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+void UARTStdioStatsGet(tUARTStdioInstance *psInst, tUARTStdioStats *psStats){
+    MAP_IntDisable(psInst->ui32Int);
+    *psStats = psInst->sStats;
+    MAP_IntEnable(psInst->ui32Int);
+}
+#endif
+
+//**************************************************************************************
+//! Clears the statistics of an instance.
+//!
+//! \param psInst points to the UART instance.
+//!
+//! \return None.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+void UARTStdioStatsClear(tUARTStdioInstance *psInst){
+    MAP_IntDisable(psInst->ui32Int);
+    psInst->sStats.ui32RxBytes = 0;
+    psInst->sStats.ui32RxOverruns = 0;
+    psInst->sStats.ui32RxErrors = 0;
+    psInst->sStats.ui32RxDropped = 0;
+    psInst->sStats.ui32RxHolds = 0;
+    psInst->sStats.ui32RxMaxUsed = 0;
+    psInst->sStats.ui32TxDropped = 0;
+    psInst->sStats.ui32RxDmaBlocks = 0;
+    psInst->sStats.ui32Interrupts = 0;
+    psInst->sStats.ui64InterruptCycles = 0;
+    MAP_IntEnable(psInst->ui32Int);
+}
+#endif
+
+//**************************************************************************************
+//! Switches reception to the uDMA.
+//!
+//! \param psInst points to the UART instance.
+//! \param ui32Channel is the uDMA channel of the UART receive requests, such
+//! as \b UDMA_CHANNEL_UART1RX.
+//!
+//! This function, available only when the module is built to operate in
+//! buffered mode using \b UART_BUFFERED, makes the uDMA store received bytes
+//! straight into the receive buffer, in ping-pong blocks of
+//! \b UART_RX_DMA_BLOCK_SIZE bytes, instead of the interrupt handler reading
+//! them one by one.  The interrupt handler then runs once per block instead of
+//! once per receive FIFO interrupt level.  Bytes of a block still being filled
+//! are found by UARTRxWriteIndexGet() and the other receive functions from the
+//! uDMA transfer count, so a frame shorter than a block is seen without
+//! waiting for the block to complete or for a receive timeout.
+//!
+//! Received bytes are stored unchanged, so raw mode must be enabled with
+//! UARTStdioRawModeSet().  The caller
+//! must have enabled the uDMA controller, set its control table and assigned
+//! \e ui32Channel to the UART.
+//!
+//! \return None.
+//**************************************************************************************
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+void UARTStdioRxDmaEnable(tUARTStdioInstance *psInst, uint32_t ui32Channel){
+    ASSERT(psInst->ui32Base != 0);
+    ASSERT(psInst->bRaw);
+    ASSERT((psInst->ui32RxSize % UART_RX_DMA_BLOCK_SIZE) == 0);
+
+    // Stop interrupt driven reception and start from an empty buffer.
+    MAP_IntDisable(psInst->ui32Int);
+    MAP_UARTIntDisable(psInst->ui32Base, UART_INT_RX | UART_INT_RT);
+    psInst->ui32RxReadIndex = 0;
+    psInst->ui32RxWriteIndex = 0;
+    psInst->bRxHeld = false;
+
+    // Bytes from the data register to consecutive buffer bytes, two per
+    // arbitration. The UART makes a burst request once the receive FIFO
+    // reaches its level, which is 2 bytes at 1/8 without flow control; a
+    // longer burst would read the empty FIFO and store garbage.
+    psInst->ui32RxDmaChannel = ui32Channel;
+    psInst->ui32RxDmaBlock = 0;
+    psInst->ui32RxDmaSelect = UDMA_PRI_SELECT;
+    psInst->ui32RxDmaArmed = 0;
+    MAP_uDMAChannelAttributeDisable(ui32Channel, UDMA_ATTR_ALL);
+    MAP_uDMAChannelControlSet(ui32Channel | UDMA_PRI_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_2);
+    MAP_uDMAChannelControlSet(ui32Channel | UDMA_ALT_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_2);
+    psInst->bRxDma = true;
+    UARTRxDmaUpdate(psInst);
+
+    // The UART now requests the uDMA, and only interrupts for errors and
+    // completed blocks.
+    MAP_UARTDMAEnable(psInst->ui32Base, UART_DMA_RX);
+    MAP_UARTIntEnable(psInst->ui32Base, UART_INT_OE | UART_INT_FE | UART_INT_PE | UART_INT_BE);
+    MAP_IntEnable(psInst->ui32Int);
 }
 #endif
 
 //**************************************************************************************
 //! Handles UART interrupts.
 //!
+//! \param psInst points to the UART instance.
+//!
 //! This function handles interrupts from the UART.  It will copy data from the
 //! transmit buffer to the UART transmit FIFO if space is available, and it
 //! will copy data from the UART receive FIFO to the receive buffer if data is
@@ -1265,108 +1984,188 @@ void UARTEchoSet(bool bEnable){
 //! \return None.
 //**************************************************************************************
 #if defined(UART_BUFFERED) || defined(DOXYGEN)
-void UARTStdioIntHandler(void){
+void UARTStdioInstIntHandler(tUARTStdioInstance *psInst){
     uint32_t ui32Ints;
-    int8_t cChar;
-    int32_t i32Char;
-    static bool bLastWasCR = false;
+    uint32_t ui32Start;
+
+    // Cycle count at entry, to account the time spent here.
+    ui32Start = HWREG(DWT_CYCCNT);
 
     // Get and clear the current interrupt source(s)
-    ui32Ints = MAP_UARTIntStatus(g_ui32Base, true);
-    MAP_UARTIntClear(g_ui32Base, ui32Ints);
+    ui32Ints = MAP_UARTIntStatus(psInst->ui32Base, true);
+    MAP_UARTIntClear(psInst->ui32Base, ui32Ints);
+
+    // In uDMA mode receive errors are reported by interrupt, as the uDMA
+    // only moves the data bits.
+    if(ui32Ints & UART_INT_OE){
+        psInst->sStats.ui32RxOverruns++;
+    }
+    if(ui32Ints & (UART_INT_FE | UART_INT_PE | UART_INT_BE)){
+        psInst->sStats.ui32RxErrors++;
+    }
 
     // Are we being interrupted because the TX FIFO has space available?
     if(ui32Ints & UART_INT_TX){
         // Move as many bytes as we can into the transmit FIFO.
-        UARTPrimeTransmit(g_ui32Base);
-
-        // If the output buffer is empty, turn off the transmit interrupt.
-        if(TX_BUFFER_EMPTY){
-            MAP_UARTIntDisable(g_ui32Base, UART_INT_TX);
+        UARTPrimeTransmit(psInst);
+
+        // If the output buffer is empty, turn off the transmit interrupt. When a
+        // UARTwriteRaw() block is still in the FIFO, switch to end of
+        // transmission mode and notify once the last bit has been sent.
+        if(TX_BUFFER_EMPTY(psInst)){
+            if(psInst->bTxDonePending && MAP_UARTBusy(psInst->ui32Base)){
+                MAP_UARTTxIntModeSet(psInst->ui32Base, UART_TXINT_MODE_EOT);
+            }
+            else{
+                MAP_UARTTxIntModeSet(psInst->ui32Base, UART_TXINT_MODE_FIFO);
+                MAP_UARTIntDisable(psInst->ui32Base, UART_INT_TX);
+                if(psInst->bTxDonePending){
+                    psInst->bTxDonePending = false;
+                    if(psInst->pfnTxDone){
+                        psInst->pfnTxDone();
+                    }
+                }
+            }
         }
     }
 
+    // In uDMA mode, completed blocks raise the UART interrupt without a
+    // status bit.
+    if(psInst->bRxDma){
+        UARTRxDmaUpdate(psInst);
+    }
+
     // Are we being interrupted due to a received character?
     if(ui32Ints & (UART_INT_RX | UART_INT_RT)){
         // Get all the available characters from the UART.
-        while(MAP_UARTCharsAvail(g_ui32Base)){
-            // Read a character
-            i32Char = MAP_UARTCharGetNonBlocking(g_ui32Base);
-            cChar = (unsigned char)(i32Char & 0xFF);
-
-            // If echo is disabled, we skip the various text filtering operations
-            // that would typically be required when supporting a command line.
-            if(!g_bDisableEcho){
-                // Handle backspace by erasing the last character in the
-                // buffer.
-                if(cChar == '\b'){
-                    // If there are any characters already in the buffer, then
-                    // delete the last.
-                    if(!RX_BUFFER_EMPTY){
-                        // Rub out the previous character on the users terminal.
-                        UARTwrite("\b \b", 3);
-
-                        // Decrement the number of characters in the buffer.
-                        if(g_ui32UARTRxWriteIndex == 0){
-                            g_ui32UARTRxWriteIndex = UART_RX_BUFFER_SIZE - 1;
-                        }
-                        else{
-                            g_ui32UARTRxWriteIndex--;
-                        }
-                    }
+        UARTRxDrain(psInst);
 
-                    // Skip ahead to read the next character.
-                    continue;
-                }
+        // If we wrote anything to the transmit buffer, make sure it actually
+        // gets transmitted. Raw mode never echoes.
+        if(!psInst->bRaw){
+            UARTPrimeTransmit(psInst);
+            MAP_UARTIntEnable(psInst->ui32Base, UART_INT_TX);
+        }
+    }
 
-                // If this character is LF and last was CR, then just gobble up
-                // the character since we already echoed the previous CR and we
-                // don't want to store 2 characters in the buffer if we don't need to.
-                if((cChar == '\n') && bLastWasCR){
-                    bLastWasCR = false;
-                    continue;
-                }
+    psInst->sStats.ui32Interrupts++;
+    psInst->sStats.ui64InterruptCycles += HWREG(DWT_CYCCNT) - ui32Start;
+}
+#endif
 
-                // See if a newline or escape character was received.
-                if((cChar == '\r') || (cChar == '\n') || (cChar == 0x1b)){
-                    // If the character is a CR, then it may be followed by an
-                    // LF which should be paired with the CR.  So remember that
-                    // a CR was received.
-                    if(cChar == '\r'){
-                        bLastWasCR = 1;
-                    }
+//**************************************************************************************
+//! Configures the UART console.
+//!
+//! \param ui32PortNum is the number of UART port to use for the serial console
+//! (0-2)
+//! \param ui32Baud is the bit rate that the UART is to be configured to use.
+//! \param ui32SrcClock is the frequency of the source clock for the UART
+//! module.
+//!
+//! This function configures the instance used by the functions without
+//! instance argument, UARTprintf(), UARTgets() and the others below, with
+//! buffers of \b UART_RX_BUFFER_SIZE and \b UART_TX_BUFFER_SIZE bytes.  Its
+//! interrupt vector must be UARTStdioIntHandler().  In buffered mode only one
+//! such console can be configured; further ports use UARTStdioInit().
+//!
+//! \return Returns the instance, for the functions taking one.
+//**************************************************************************************
+tUARTStdioInstance *UARTStdioConfig(uint32_t ui32PortNum, uint32_t ui32Baud, uint32_t ui32SrcClock){
+#ifdef UART_BUFFERED
+    // In buffered mode, we only allow a single console to be opened.
+    ASSERT(g_sUARTStdio.ui32Base == 0);
 
-                    // Regardless of the line termination character received,
-                    // put a CR in the receive buffer as a marker telling
-                    // UARTgets() where the line ends.  We also send an
-                    // additional LF to ensure that the local terminal echo
-                    // receives both CR and LF.
-                    cChar = '\r';
-                    UARTwrite("\n", 1);
-                }
-            }
+    UARTStdioInit(&g_sUARTStdio, ui32PortNum, ui32Baud, ui32SrcClock,
+                  g_pcUARTRxBuffer, UART_RX_BUFFER_SIZE,
+                  g_pcUARTTxBuffer, UART_TX_BUFFER_SIZE);
+#else
+    UARTStdioInit(&g_sUARTStdio, ui32PortNum, ui32Baud, ui32SrcClock, 0, 0, 0, 0);
+#endif
+    return(&g_sUARTStdio);
+}
 
-            // If there is space in the receive buffer, put the character
-            // there, otherwise throw it away.
-            if(!RX_BUFFER_FULL){
-                // Store the new character in the receive buffer
-                g_pcUARTRxBuffer[g_ui32UARTRxWriteIndex] =
-                    (unsigned char)(i32Char & 0xFF);
-                ADVANCE_RX_BUFFER_INDEX(g_ui32UARTRxWriteIndex);
-
-                // If echo is enabled, write the character to the transmit
-                // buffer so that the user gets some immediate feedback.
-                if(!g_bDisableEcho){
-                    UARTwrite((const char *)&cChar, 1);
-                }
-            }
-        }
+//**************************************************************************************
+// The console versions of the instance functions, see the latter for details.
+//**************************************************************************************
+int UARTwrite(const char *pcBuf, uint32_t ui32Len){
+    return(UARTStdioWrite(&g_sUARTStdio, pcBuf, ui32Len));
+}
 
-        // If we wrote anything to the transmit buffer, make sure it actually
-        // gets transmitted.
-        UARTPrimeTransmit(g_ui32Base);
-        MAP_UARTIntEnable(g_ui32Base, UART_INT_TX);
-    }
+int UARTgets(char *pcBuf, uint32_t ui32Len){
+    return(UARTStdioGets(&g_sUARTStdio, pcBuf, ui32Len));
+}
+
+unsigned char UARTgetc(void){
+    return(UARTStdioGetc(&g_sUARTStdio));
+}
+
+void UARTvprintf(const char *pcString, va_list vaArgP){
+    UARTStdioVPrintf(&g_sUARTStdio, pcString, vaArgP);
+}
+
+void UARTprintf(const char *pcString, ...){
+    va_list vaArgP;
+
+    // Start the varargs processing.
+    va_start(vaArgP, pcString);
+
+    UARTStdioVPrintf(&g_sUARTStdio, pcString, vaArgP);
+
+    // We're finished with the varargs now.
+    va_end(vaArgP);
+}
+
+#if defined(UART_BUFFERED) || defined(DOXYGEN)
+int UARTwriteRaw(const uint8_t *pui8Buf, uint32_t ui32Len){
+    return(UARTStdioWriteRaw(&g_sUARTStdio, pui8Buf, ui32Len));
+}
+
+void UARTTxDoneCallbackSet(void (*pfnCallback)(void)){
+    UARTStdioTxDoneCallbackSet(&g_sUARTStdio, pfnCallback);
+}
+
+int UARTRxBytesAvail(void){
+    return(UARTStdioRxBytesAvail(&g_sUARTStdio));
+}
+
+int UARTTxBytesFree(void){
+    return(UARTStdioTxBytesFree(&g_sUARTStdio));
+}
+
+unsigned char *UARTRxBufferGet(void){
+    return(UARTStdioRxBufferGet(&g_sUARTStdio));
+}
+
+uint32_t UARTRxReadIndexGet(void){
+    return(UARTStdioRxReadIndexGet(&g_sUARTStdio));
+}
+
+uint32_t UARTRxWriteIndexGet(void){
+    return(UARTStdioRxWriteIndexGet(&g_sUARTStdio));
+}
+
+void UARTRxBufferRelease(uint32_t ui32ReadIndex){
+    UARTStdioRxBufferRelease(&g_sUARTStdio, ui32ReadIndex);
+}
+
+int UARTPeek(unsigned char ucChar){
+    return(UARTStdioPeek(&g_sUARTStdio, ucChar));
+}
+
+void UARTFlushRx(void){
+    UARTStdioFlushRx(&g_sUARTStdio);
+}
+
+void UARTFlushTx(bool bDiscard){
+    UARTStdioFlushTx(&g_sUARTStdio, bDiscard);
+}
+
+void UARTEchoSet(bool bEnable){
+    UARTStdioEchoSet(&g_sUARTStdio, bEnable);
+}
+
+void UARTStdioIntHandler(void){
+    UARTStdioInstIntHandler(&g_sUARTStdio);
 }
 #endif
 
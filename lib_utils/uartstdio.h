@@ -29,17 +29,110 @@ extern "C"
 //**************************************************************************************
 #ifdef UART_BUFFERED
 #ifndef UART_RX_BUFFER_SIZE
-#define UART_RX_BUFFER_SIZE      512
+#define UART_RX_BUFFER_SIZE     1024
 #endif
 #ifndef UART_TX_BUFFER_SIZE
 #define UART_TX_BUFFER_SIZE     1024
 #endif
+#ifndef UART_RX_DMA_BLOCK_SIZE
+#define UART_RX_DMA_BLOCK_SIZE  64      // Bytes per uDMA block, see UARTStdioRxDmaEnable().
+#endif
+#endif
+
+//**************************************************************************************
+// Statistics of a buffered UART, see UARTStdioStatsGet().
+//**************************************************************************************
+#ifdef UART_BUFFERED
+typedef struct
+{
+    uint32_t ui32RxBytes;       // Bytes read from the receive FIFO.
+    uint32_t ui32RxOverruns;    // Receive FIFO overruns, each losing one or more bytes.
+    uint32_t ui32RxErrors;      // Bytes with framing, parity or break errors.
+    uint32_t ui32RxDropped;     // Bytes thrown away with the receive buffer full.
+    uint32_t ui32RxHolds;       // Times flow control held reception with the buffer full.
+    uint32_t ui32RxMaxUsed;     // Deepest receive buffer fill level seen.
+    uint32_t ui32RxDmaBlocks;   // Receive blocks completed by the uDMA.
+    uint32_t ui32TxDropped;     // Bytes refused with the transmit buffer full.
+    uint32_t ui32Interrupts;    // Interrupt handler runs.
+    uint64_t ui64InterruptCycles;   // Processor cycles spent in the interrupt handler.
+}
+tUARTStdioStats;
+#endif
+
+//**************************************************************************************
+// The state of one UART, see UARTStdioInit(). The members are private to the
+// driver; each buffered instance has its own ring buffers, so one port never
+// waits for another.
+//**************************************************************************************
+typedef struct
+{
+    uint32_t ui32Base;                      // Base address of the UART.
+    uint32_t ui32Int;                       // Interrupt number of the UART.
+    uint32_t ui32PortNum;                   // UART number, 0-2.
+    bool bLastWasCR;                        // A CR ended the last line, swallow a following LF.
+#ifdef UART_BUFFERED
+    unsigned char *pui8TxBuffer;            // Transmit ring buffer.
+    uint32_t ui32TxSize;                    // Size of the transmit ring buffer.
+    volatile uint32_t ui32TxWriteIndex;     // Next byte written by the application.
+    volatile uint32_t ui32TxReadIndex;      // Next byte sent by the interrupt handler.
+    unsigned char *pui8RxBuffer;            // Receive ring buffer.
+    uint32_t ui32RxSize;                    // Size of the receive ring buffer.
+    volatile uint32_t ui32RxWriteIndex;     // Next byte stored by the interrupt handler or uDMA.
+    volatile uint32_t ui32RxReadIndex;      // Oldest byte not yet read or released.
+    bool bDisableEcho;                      // Received characters are not echoed.
+    bool bRaw;                              // Binary data, no echo nor line editing.
+    void (*pfnTxDone)(void);                // Called once a UARTStdioWriteRaw() block is sent.
+    volatile bool bTxDonePending;           // A UARTStdioWriteRaw() block is still in flight.
+    bool bFlowControl;                      // RTS/CTS flow control is enabled.
+    volatile bool bRxHeld;                  // Reception held in the FIFO, buffer full.
+    bool bRxDma;                            // Reception is done by the uDMA.
+    uint32_t ui32RxDmaChannel;              // uDMA channel of the receive requests.
+    uint32_t ui32RxDmaBlock;                // Ring block the active uDMA structure fills.
+    uint32_t ui32RxDmaSelect;               // Active uDMA control structure, primary or alternate.
+    uint32_t ui32RxDmaArmed;                // Blocks handed to the uDMA, 0-2.
+    tUARTStdioStats sStats;                 // Statistics, see UARTStdioStatsGet().
+#endif
+}
+tUARTStdioInstance;
+
+//**************************************************************************************
+// Prototypes for the APIs working on an instance.
+//**************************************************************************************
+extern void UARTStdioInit(tUARTStdioInstance *psInst, uint32_t ui32PortNum, uint32_t ui32Baud,
+                          uint32_t ui32SrcClock, unsigned char *pui8RxBuffer, uint32_t ui32RxSize,
+                          unsigned char *pui8TxBuffer, uint32_t ui32TxSize);
+extern int UARTStdioGets(tUARTStdioInstance *psInst, char *pcBuf, uint32_t ui32Len);
+extern unsigned char UARTStdioGetc(tUARTStdioInstance *psInst);
+extern void UARTStdioPrintf(tUARTStdioInstance *psInst, const char *pcString, ...);
+extern void UARTStdioVPrintf(tUARTStdioInstance *psInst, const char *pcString, va_list vaArgP);
+extern int UARTStdioWrite(tUARTStdioInstance *psInst, const char *pcBuf, uint32_t ui32Len);
+#ifdef UART_BUFFERED
+extern int UARTStdioPeek(tUARTStdioInstance *psInst, unsigned char ucChar);
+extern void UARTStdioFlushTx(tUARTStdioInstance *psInst, bool bDiscard);
+extern void UARTStdioFlushRx(tUARTStdioInstance *psInst);
+extern int UARTStdioRxBytesAvail(tUARTStdioInstance *psInst);
+extern int UARTStdioTxBytesFree(tUARTStdioInstance *psInst);
+extern void UARTStdioEchoSet(tUARTStdioInstance *psInst, bool bEnable);
+extern void UARTStdioRawModeSet(tUARTStdioInstance *psInst, bool bEnable);
+extern int UARTStdioWriteRaw(tUARTStdioInstance *psInst, const uint8_t *pui8Buf, uint32_t ui32Len);
+extern void UARTStdioTxDoneCallbackSet(tUARTStdioInstance *psInst, void (*pfnCallback)(void));
+extern unsigned char *UARTStdioRxBufferGet(tUARTStdioInstance *psInst);
+extern uint32_t UARTStdioRxReadIndexGet(tUARTStdioInstance *psInst);
+extern uint32_t UARTStdioRxWriteIndexGet(tUARTStdioInstance *psInst);
+extern void UARTStdioRxBufferRelease(tUARTStdioInstance *psInst, uint32_t ui32ReadIndex);
+extern void UARTStdioFlowControlSet(tUARTStdioInstance *psInst, bool bEnable);
+extern void UARTStdioBaudSet(tUARTStdioInstance *psInst, uint32_t ui32Baud, uint32_t ui32SrcClock);
+extern void UARTStdioStatsGet(tUARTStdioInstance *psInst, tUARTStdioStats *psStats);
+extern void UARTStdioStatsClear(tUARTStdioInstance *psInst);
+extern void UARTStdioRxDmaEnable(tUARTStdioInstance *psInst, uint32_t ui32Channel);
+extern void UARTStdioInstIntHandler(tUARTStdioInstance *psInst);
 #endif
 
 //**************************************************************************************
-// Prototypes for the APIs.
+// Prototypes for the APIs working on the instance set up by UARTStdioConfig(),
+// with the buffers sized above.
 //**************************************************************************************
-extern void UARTStdioConfig(uint32_t ui32Port, uint32_t ui32Baud, uint32_t ui32SrcClock);
+extern tUARTStdioInstance *UARTStdioConfig(uint32_t ui32Port, uint32_t ui32Baud, uint32_t ui32SrcClock);
 extern int UARTgets(char *pcBuf, uint32_t ui32Len);
 extern unsigned char UARTgetc(void);
 extern void UARTprintf(const char *pcString, ...);
@@ -52,6 +145,13 @@ extern void UARTFlushRx(void);
 extern int UARTRxBytesAvail(void);
 extern int UARTTxBytesFree(void);
 extern void UARTEchoSet(bool bEnable);
+extern int UARTwriteRaw(const uint8_t *pui8Buf, uint32_t ui32Len);
+extern void UARTTxDoneCallbackSet(void (*pfnCallback)(void));
+extern unsigned char *UARTRxBufferGet(void);
+extern uint32_t UARTRxReadIndexGet(void);
+extern uint32_t UARTRxWriteIndexGet(void);
+extern void UARTRxBufferRelease(uint32_t ui32ReadIndex);
+extern void UARTStdioIntHandler(void);
 #endif
 
 //**************************************************************************************
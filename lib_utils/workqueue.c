@@ -0,0 +1,64 @@
+/*
+ * workqueue.c - Deferred work posted from interrupt context and run from main.
+ *
+ * Interrupt handlers only post a work item id; the matching function runs
+ * later from main context in WorkQueueRun(). Pending items are bits of a word
+ * in SRAM, set and cleared through the bit-band alias so posting is a single
+ * atomic store and never masks interrupts.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_types.h"
+#include "lib_utils/workqueue.h"
+
+//*****************************************************************************
+// Bit per posted work item, and the function run for each item.
+static volatile uint32_t g_vui32WorkPending = 0;
+static tWorkFunction *g_ppfnWork[WORKQUEUE_MAX_ITEMS];
+
+//*****************************************************************************
+// Set the function run when work item ui32Id is posted.
+void WorkQueueRegister(uint32_t ui32Id, tWorkFunction *pfnWork){
+	if(ui32Id < WORKQUEUE_MAX_ITEMS){
+		g_ppfnWork[ui32Id] = pfnWork;
+	}
+}
+
+//*****************************************************************************
+// Mark work item ui32Id pending. Safe to call from any interrupt context.
+// Posting an item that is already pending runs it only once.
+void WorkQueuePost(uint32_t ui32Id){
+	if(ui32Id < WORKQUEUE_MAX_ITEMS){
+		HWREGBITW(&g_vui32WorkPending, ui32Id) = 1;
+	}
+}
+
+//*****************************************************************************
+// Return true if any work item is pending.
+bool WorkQueuePending(void){
+	return (g_vui32WorkPending != 0);
+}
+
+//*****************************************************************************
+// Run every pending work item, lowest id first. Call from main context only.
+void WorkQueueRun(void){
+	uint32_t ui32Id;
+
+	if(g_vui32WorkPending == 0){
+		return;
+	}
+
+	for(ui32Id = 0; ui32Id < WORKQUEUE_MAX_ITEMS; ui32Id++){
+		if(HWREGBITW(&g_vui32WorkPending, ui32Id)){
+			// Clear before running so a post during the work is not lost.
+			HWREGBITW(&g_vui32WorkPending, ui32Id) = 0;
+			if(g_ppfnWork[ui32Id]){
+				g_ppfnWork[ui32Id]();
+			}
+		}
+	}
+}
@@ -0,0 +1,40 @@
+/*
+ * workqueue.h - Deferred work posted from interrupt context and run from main.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef WORKQUEUE_H_
+#define WORKQUEUE_H_
+
+//*****************************************************************************
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+// Number of work items. Item id is also its priority, lower ids run first.
+#define WORKQUEUE_MAX_ITEMS		8
+
+//*****************************************************************************
+// Prototype for a deferred work function.
+typedef void (tWorkFunction)(void);
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern void WorkQueueRegister(uint32_t ui32Id, tWorkFunction *pfnWork);
+extern void WorkQueuePost(uint32_t ui32Id);
+extern bool WorkQueuePending(void);
+extern void WorkQueueRun(void);
+
+//*****************************************************************************
+// Mark the end of the C bindings section for C++ compilers.
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORKQUEUE_H_ */
@@ -12,204 +12,625 @@
 #include "lib_utils/ustdlib.h"
 #include "lib_utils/uartstdio.h"
 #include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
 
-struct tXbee tXbeeFrame;
+struct tXbeeTx tXbeeTxFrame;
+struct tXbeeRx tXbeeRxFrame;
+static struct tXbeeTxHeader g_sCoordinatorTxHeader;	// Header of frames sent to the coordinator.
+
+// 64 bit address of the coordinator.
+const uint8_t g_pui8ZBCoordinatorAddr64[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+// A fully escaped frame must fit in the UART1 receive ring buffer, which holds one byte less than its size.
+#if UART_RX_BUFFER_SIZE < (2 * MAX_FRAME_SIZE)
+#error "UART_RX_BUFFER_SIZE too small to hold an escaped xbee frame"
+#endif
+
+//**************************************************************************************************
+// Called from UART1 interrupt context when all queued bytes have left the transmitter.
+static void xbeeTxDone(void){
+	tXbeeTxFrame.txBusy = false;
+}
 
 //**************************************************************************************************
-// Constructor will initialize tXbee frame struct.
+// Constructor will initialize transmit and receive frame structs. It runs before main(), so the
+// UART1 receive buffer and transmit callback are bound later by begin().
 XbeeZB :: XbeeZB(){
-	resetXbeeFrameInfo();
+	tXbeeTxFrame.txLength = 0;
+	tXbeeTxFrame.txBusy = false;
+	tXbeeTxFrame.frameId = 0;
+	tXbeeTxFrame.apiMode = API_MODE_ESCAPED;
+	tXbeeRxFrame.apiMode = API_MODE_ESCAPED;
+	buildTxHeader(&g_sCoordinatorTxHeader, g_pui8ZBCoordinatorAddr64, ZB_UNKNOWN_ADDR16, 0x00, 0x00);
+	tXbeeRxFrame.ring = 0;
+	tXbeeRxFrame.scan = 0;
+	tXbeeRxFrame.pos = 0;
+	tXbeeRxFrame.errorCode = NO_ERROR;
+	tXbeeRxFrame.errorCount = 0;
+	tXbeeRxFrame.head = 0;
+	tXbeeRxFrame.tail = 0;
+	tXbeeRxFrame.highWater = 0;
 }
 
 //**************************************************************************************************
-// Clear all frame data.
-void XbeeZB :: resetXbeeFrameInfo() {
-	uint8_t i;
-	for (i = 0; i<MAX_FRAME_SIZE; i++) {
-		tXbeeFrame.rxFrameData[i] = 0;
-		// Clear message array of length (MAX_FRAME_DATA_SIZE - 16).
-		if(i < MAX_FRAME_SIZE - 16)   tXbeeFrame.message[i] = 0;
-	}
-	tXbeeFrame.pos = 0;
-	tXbeeFrame.lsbRxFrameLength = 0;
-	tXbeeFrame.frameType = 0;
-	tXbeeFrame.rxChecksumTotal = 0;
-	tXbeeFrame.messageIdx = 0;
-	tXbeeFrame.errorCode = 0;
-	tXbeeFrame.escape = false;
-	tXbeeFrame.rxComplete = false;
-	rxMsgPayloadComplete = false;
+// Bind the parser to the UART1 receive buffer and register the transmit complete callback. Call it
+// once UART1 is configured, since configuring UART1 clears the callback, and before any frame is
+// sent or received.
+void XbeeZB :: begin(void){
+	tXbeeTxFrame.txBusy = false;
+	UARTTxDoneCallbackSet(xbeeTxDone);
+	tXbeeRxFrame.ring = UARTRxBufferGet();
+	tXbeeRxFrame.scan = UARTRxReadIndexGet();
+	tXbeeRxFrame.pos = 0;
 }
 
 //**************************************************************************************************
-// Send frame byte via UART to the xbee module.
+// Append frame byte to the transmit frame buffer. Bytes are only escaped in API_MODE_ESCAPED.
 uint8_t XbeeZB :: xbeeByteTx(uint8_t b, bool escapeMode) {
-	if (escapeMode && (b == START_BYTE || b == ESCAPE_BYTE || b == XON_BYTE || b == XOFF_BYTE)) {
-		ROM_UARTCharPut(UART1_BASE, ESCAPE_BYTE);
-		ROM_UARTCharPut(UART1_BASE, b ^ 0x20);
+	if (escapeMode && tXbeeTxFrame.apiMode == API_MODE_ESCAPED &&
+		(b == START_BYTE || b == ESCAPE_BYTE || b == XON_BYTE || b == XOFF_BYTE)) {
+		tXbeeTxFrame.txFrameData[tXbeeTxFrame.txLength++] = ESCAPE_BYTE;
+		tXbeeTxFrame.txFrameData[tXbeeTxFrame.txLength++] = b ^ 0x20;
 		return b;
 	}
 	else {
-		ROM_UARTCharPut(UART1_BASE, b);
+		tXbeeTxFrame.txFrameData[tXbeeTxFrame.txLength++] = b;
 		return b;
 	}
 }
 
 //**************************************************************************************************
-// Send data to coordinator via ZB Transmit Request frame.
-void XbeeZB :: ZBTransmitRequest(const uint8_t *payloadMsg) {
+// Send payloadLength bytes of data to coordinator via ZB Transmit Request frame. The payload may
+// contain any byte value, including 0x00. No transmit status is requested.
+bool XbeeZB :: ZBTransmitRequest(const uint8_t *payloadMsg, uint8_t dataTxLength) {
+	return ZBTransmitRequest(payloadMsg, dataTxLength, 0);
+}
+
+//**************************************************************************************************
+// Send payloadLength bytes of data to coordinator via ZB Transmit Request frame. A non zero frameId
+// makes the module answer with a ZB Transmit Status frame carrying the same id.
+bool XbeeZB :: ZBTransmitRequest(const uint8_t *payloadMsg, uint8_t dataTxLength, uint8_t frameId) {
+	struct tXbeeTxSegment sSegment;
+
+	sSegment.data = payloadMsg;
+	sSegment.length = dataTxLength;
+	return ZBTransmitRequest(&g_sCoordinatorTxHeader, &sSegment, 1, frameId);
+}
+
+//**************************************************************************************************
+// Send payloadLength bytes of data to the node with 64 bit address dstAddr64 via ZB Transmit Request
+// frame. dstAddr16 is the node 16 bit address, or ZB_UNKNOWN_ADDR16 to let the module find it.
+// Payloads longer than ZB_MAX_RF_PAYLOAD are refused, see xbee_fragment.h to send them.
+bool XbeeZB :: ZBTransmitRequest(const uint8_t *dstAddr64, uint16_t dstAddr16, const uint8_t *payloadMsg,
+								 uint8_t dataTxLength, uint8_t frameId) {
+	struct tXbeeTxSegment sSegment;
+
+	sSegment.data = payloadMsg;
+	sSegment.length = dataTxLength;
+	return ZBTransmitRequest(dstAddr64, dstAddr16, &sSegment, 1, frameId);
+}
+
+//**************************************************************************************************
+// Send the payload made of segmentCount segments, in order, via ZB Transmit Request frame. The
+// header is built for this frame only, use a cached tXbeeTxHeader for frequent destinations.
+bool XbeeZB :: ZBTransmitRequest(const uint8_t *dstAddr64, uint16_t dstAddr16, const struct tXbeeTxSegment *segments,
+								 uint8_t segmentCount, uint8_t frameId) {
+	struct tXbeeTxHeader sHeader;
+
+	buildTxHeader(&sHeader, dstAddr64, dstAddr16, 0x00, 0x00);
+	return ZBTransmitRequest(&sHeader, segments, segmentCount, frameId);
+}
+
+//**************************************************************************************************
+// Build the cached header of ZB Transmit Requests sent to the node with 64 bit address dstAddr64.
+// dstAddr16 is the node 16 bit address, or ZB_UNKNOWN_ADDR16 to let the module find it. Rebuild it
+// when any of the values change.
+void XbeeZB :: buildTxHeader(struct tXbeeTxHeader *header, const uint8_t *dstAddr64, uint16_t dstAddr16,
+							 uint8_t radius, uint8_t options) {
+	uint8_t headerBytes[ZB_TX_HEADER_SIZE];
+	uint8_t b;
+	uint8_t i;
+
+	for (i=0; i<8; i++) {
+		headerBytes[i] = dstAddr64[i];									// 5-12. 64 bit address, msb first
+	}
+	headerBytes[8] = dstAddr16 >> 8;									// 13. msb 16 address
+	headerBytes[9] = dstAddr16 & 0xff;									// 14. lsb 16 address
+	headerBytes[10] = radius;											// 15. Broadcast Radius
+	headerBytes[11] = options;											// 16. Options
+
+	header->checksum = ZB_TRANSMIT_REQUEST;
+	header->escapedLength = 0;
+	for (i=0; i<ZB_TX_HEADER_SIZE; i++) {
+		b = headerBytes[i];
+		header->raw[i] = b;
+		header->checksum += b;
+		if (b == START_BYTE || b == ESCAPE_BYTE || b == XON_BYTE || b == XOFF_BYTE) {
+			header->escaped[header->escapedLength++] = ESCAPE_BYTE;
+			b ^= 0x20;
+		}
+		header->escaped[header->escapedLength++] = b;
+	}
+}
+
+//**************************************************************************************************
+// Send the payload made of segmentCount segments, in order, via ZB Transmit Request frame with a
+// prebuilt header. Only the length, frame id and payload are escaped and added to the checksum.
+// The escaped frame is built in txFrameData and queued to the UART1 transmit buffer, so this
+// returns without waiting for the bytes to be sent. Return false if the transmit buffer has no
+// room for the frame or the payload is longer than ZB_MAX_RF_PAYLOAD.
+bool XbeeZB :: ZBTransmitRequest(const struct tXbeeTxHeader *header, const struct tXbeeTxSegment *segments,
+								 uint8_t segmentCount, uint8_t frameId) {
+	uint16_t dataTxLength = 0;
+	uint8_t checksum;
+	uint8_t i, j;
+
+	for (j=0; j<segmentCount; j++) {
+		dataTxLength += segments[j].length;
+	}
+	if(dataTxLength > ZB_MAX_RF_PAYLOAD){
+		return false;
+	}
+
+	tXbeeTxFrame.txLength = 0;
 	xbeeByteTx(START_BYTE, ESCAPE_OFF);									// 0. Start byte
 	xbeeByteTx(0x00, ESCAPE_ON);										// 1. msb length
-
-	// Get Tx data length.
-	uint8_t dataTxLength = ustrlen((char *)payloadMsg);
 	xbeeByteTx(14 + dataTxLength, ESCAPE_ON);							// 2. lsb length
 
+	// Frame type and header bytes are already in the header checksum.
+	xbeeByteTx(ZB_TRANSMIT_REQUEST, ESCAPE_ON);							// 3. Frame type
+	checksum = header->checksum + xbeeByteTx(frameId, ESCAPE_ON);		// 4. Frame Id number
+	if (tXbeeTxFrame.apiMode == API_MODE_ESCAPED) {
+		for (i=0; i<header->escapedLength; i++) {
+			tXbeeTxFrame.txFrameData[tXbeeTxFrame.txLength++] = header->escaped[i];	// 5-16. Header
+		}
+	}
+	else {
+		for (i=0; i<ZB_TX_HEADER_SIZE; i++) {
+			tXbeeTxFrame.txFrameData[tXbeeTxFrame.txLength++] = header->raw[i];
+		}
+	}
+
+	// Transmit data segments.
+	for (j=0; j<segmentCount; j++) {
+		for (i=0; i<segments[j].length; i++) {
+			checksum += xbeeByteTx(segments[j].data[i], ESCAPE_ON);		// 17. Start of data to send.
+		}
+	}
+
+	checksum = 0xff - checksum;
+	xbeeByteTx(checksum, ESCAPE_ON);
+
+	return frameQueue();
+}
+
+//**************************************************************************************************
+// Store a source route to the node with addresses dstAddr64 and dstAddr16 in the module via Create
+// Source Route frame. hops holds the 16 bit addresses of the hopCount intermediate nodes, starting
+// with the neighbor of the destination, the order used by Route Record Indicator frames. The module
+// sends no response. Return false if UART1 has no room or hopCount is above XBEE_MAX_ROUTE_HOPS.
+bool XbeeZB :: ZBCreateSourceRoute(const uint8_t *dstAddr64, uint16_t dstAddr16, const uint16_t *hops,
+								   uint8_t hopCount) {
 	uint8_t checksum = 0;
+	uint8_t i;
+
+	if(hopCount > XBEE_MAX_ROUTE_HOPS){
+		return false;
+	}
+
+	tXbeeTxFrame.txLength = 0;
+	xbeeByteTx(START_BYTE, ESCAPE_OFF);									// 0. Start byte
+	xbeeByteTx(0x00, ESCAPE_ON);										// 1. msb length
+	xbeeByteTx(14 + 2*hopCount, ESCAPE_ON);								// 2. lsb length
+
+	checksum += xbeeByteTx(CREATE_SOURCE_ROUTE, ESCAPE_ON);				// 3. Frame type
+	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 4. Frame Id, no response
+
+	for (i=0; i<8; i++) {
+		checksum += xbeeByteTx(dstAddr64[i], ESCAPE_ON);				// 5-12. 64 bit address, msb first
+	}
+
+	checksum += xbeeByteTx(dstAddr16 >> 8, ESCAPE_ON);					// 13. msb 16 address
+	checksum += xbeeByteTx(dstAddr16 & 0xff, ESCAPE_ON);				// 14. lsb 16 address
 
-	// Data frame and checksum start
-	checksum += xbeeByteTx(ZB_TRANSMIT_REQUEST, ESCAPE_ON);				// 3. Frame type
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 4. Frame Id number
+	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 15. Route options
+	checksum += xbeeByteTx(hopCount, ESCAPE_ON);						// 16. Number of addresses
 
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 5. msb 64 address
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 6. msb 64 address
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 7. msb 64 address
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 8. msb 64 address
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);   							// 9. lsb 64 address
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 10. lsb 64 address
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 11. lsb 64 address
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 12. lsb 64 address
+	for (i=0; i<hopCount; i++) {
+		checksum += xbeeByteTx(hops[i] >> 8, ESCAPE_ON);				// 17. Hop addresses, msb first.
+		checksum += xbeeByteTx(hops[i] & 0xff, ESCAPE_ON);
+	}
 
-	checksum += xbeeByteTx(0xff, ESCAPE_ON);							// 13. msb 16 address
-	checksum += xbeeByteTx(0xfe, ESCAPE_ON);							// 14. lsb 16 address
+	checksum = 0xff - checksum;
+	xbeeByteTx(checksum, ESCAPE_ON);
 
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 15. Broadcast Radius
-	checksum += xbeeByteTx(0x00, ESCAPE_ON);							// 16. Options
+	return frameQueue();
+}
 
-	// Transmit data buffer.
+//**************************************************************************************************
+// Send the two character AT command in command to the local module, with parameterLength bytes of
+// parameter, none to query the current value. AT Command frames apply the change at once, AT
+// Command Queue Parameter frames, when queue is true, hold it until an AC or another AT Command.
+// A non zero frameId makes the module answer with an AT Command Response frame carrying the same
+// id. Return false if UART1 has no room.
+bool XbeeZB :: ATCommandRequest(const uint8_t *command, const uint8_t *parameter, uint8_t parameterLength,
+								uint8_t frameId, bool queue) {
+	uint8_t checksum = 0;
 	uint8_t i;
-	for (i=0; i<dataTxLength; i++) {
-		checksum += xbeeByteTx(payloadMsg[i], ESCAPE_ON);				// 17. Start of data to send.
+
+	if(parameterLength > MAX_FRAME_SIZE - 4){
+		return false;
+	}
+
+	tXbeeTxFrame.txLength = 0;
+	xbeeByteTx(START_BYTE, ESCAPE_OFF);									// 0. Start byte
+	xbeeByteTx(0x00, ESCAPE_ON);										// 1. msb length
+	xbeeByteTx(4 + parameterLength, ESCAPE_ON);							// 2. lsb length
+
+	checksum += xbeeByteTx(queue ? AT_COMMAND_QUEUE_PARAMETER : AT_COMMAND, ESCAPE_ON);	// 3. Frame type
+	checksum += xbeeByteTx(frameId, ESCAPE_ON);							// 4. Frame Id number
+	checksum += xbeeByteTx(command[0], ESCAPE_ON);						// 5-6. AT command
+	checksum += xbeeByteTx(command[1], ESCAPE_ON);
+
+	for (i=0; i<parameterLength; i++) {
+		checksum += xbeeByteTx(parameter[i], ESCAPE_ON);				// 7. Parameter value, msb first.
 	}
 
 	checksum = 0xff - checksum;
 	xbeeByteTx(checksum, ESCAPE_ON);
+
+	return frameQueue();
 }
 
+//**************************************************************************************************
+// Send the two character AT command in command to the remote module with 64 bit address dstAddr64
+// via Remote AT Command Request frame, with parameterLength bytes of parameter, none to query the
+// current value. dstAddr16 is the module 16 bit address, or ZB_UNKNOWN_ADDR16. Without the
+// REMOTE_AT_APPLY_CHANGES option the remote module holds a change until a later command applies
+// it. A non zero frameId makes the remote module answer with a Remote Command Response frame
+// carrying the same id. Return false if UART1 has no room.
+bool XbeeZB :: RemoteATCommandRequest(const uint8_t *dstAddr64, uint16_t dstAddr16, const uint8_t *command,
+									  const uint8_t *parameter, uint8_t parameterLength, uint8_t frameId,
+									  uint8_t options) {
+	uint8_t checksum = 0;
+	uint8_t i;
+
+	if(parameterLength > MAX_FRAME_SIZE - 15){
+		return false;
+	}
+
+	tXbeeTxFrame.txLength = 0;
+	xbeeByteTx(START_BYTE, ESCAPE_OFF);									// 0. Start byte
+	xbeeByteTx(0x00, ESCAPE_ON);										// 1. msb length
+	xbeeByteTx(15 + parameterLength, ESCAPE_ON);						// 2. lsb length
+
+	checksum += xbeeByteTx(REMOTE_AT_COMMAND_REQUEST, ESCAPE_ON);		// 3. Frame type
+	checksum += xbeeByteTx(frameId, ESCAPE_ON);							// 4. Frame Id number
+
+	for (i=0; i<8; i++) {
+		checksum += xbeeByteTx(dstAddr64[i], ESCAPE_ON);				// 5-12. 64 bit address, msb first
+	}
+
+	checksum += xbeeByteTx(dstAddr16 >> 8, ESCAPE_ON);					// 13. msb 16 address
+	checksum += xbeeByteTx(dstAddr16 & 0xff, ESCAPE_ON);				// 14. lsb 16 address
+
+	checksum += xbeeByteTx(options, ESCAPE_ON);							// 15. Remote command options
+	checksum += xbeeByteTx(command[0], ESCAPE_ON);						// 16-17. AT command
+	checksum += xbeeByteTx(command[1], ESCAPE_ON);
+
+	for (i=0; i<parameterLength; i++) {
+		checksum += xbeeByteTx(parameter[i], ESCAPE_ON);				// 18. Parameter value, msb first.
+	}
+
+	checksum = 0xff - checksum;
+	xbeeByteTx(checksum, ESCAPE_ON);
+
+	return frameQueue();
+}
+
+//**************************************************************************************************
+// Set the API mode used to build and parse frames, read from the module with ATAP. Frames already
+// queued to UART1 keep the mode they were built with. Cached tXbeeTxHeader headers hold both forms
+// and stay valid.
+void XbeeZB :: setApiMode(uint8_t apiMode){
+	tXbeeTxFrame.apiMode = apiMode;
+	tXbeeRxFrame.apiMode = apiMode;
+}
+
+//**************************************************************************************************
+// Get the API mode used to build and parse frames.
+uint8_t XbeeZB :: getApiMode(void){
+	return tXbeeRxFrame.apiMode;
+}
 
 //**************************************************************************************************
-// ZB Receive Packet frame (0x90) handler executed with UART RX interrupt.
-void XbeeZB :: ZBReceivePacket(void){
-	uint8_t rxB;	// Received xbee byte.
+// Get frame id for a frame expecting a response. Ids roll over from 255 to 1 since 0 disables the
+// response frame. Every frame sent with an id, whatever its type, takes it from here.
+uint8_t XbeeZB :: nextFrameId(void){
+	tXbeeTxFrame.frameId++;
+	if(tXbeeTxFrame.frameId == 0){
+		tXbeeTxFrame.frameId = 1;
+	}
+	return tXbeeTxFrame.frameId;
+}
 
-	// Clear all old frame parameters when new frame arrive.
-	if(tXbeeFrame.rxComplete || tXbeeFrame.errorCode){
-		resetXbeeFrameInfo();
+//**************************************************************************************************
+// Queue the frame built in txFrameData to the UART1 transmit buffer, whole or not at all, and
+// return without waiting for it to be sent. Busy must be set before queuing, since a short frame
+// may be sent before UARTwriteRaw returns. Return false if the transmit buffer has no room.
+bool XbeeZB :: frameQueue(void){
+	bool previousBusy = tXbeeTxFrame.txBusy;
+
+	tXbeeTxFrame.txBusy = true;
+	if(UARTwriteRaw(tXbeeTxFrame.txFrameData, tXbeeTxFrame.txLength) == 0){
+		tXbeeTxFrame.txBusy = previousBusy;
+		return false;
 	}
+	return true;
+}
 
-	// Check if Rx ring buffer has some data packet.
-	while(UARTRxBytesAvail()){
-		rxB = (uint8_t)UARTgetc();						// Get character stored in Rx ring buffer.
-		ROM_UARTCharPutNonBlocking(UART0_BASE, rxB);	// Write back to UART0 for PC displaying
+//**************************************************************************************************
+// Ring index of the byte found offset bytes after ring index idx.
+static inline uint32_t xbeeRxIndex(uint32_t idx, uint32_t offset){
+	return (idx + offset) % UART_RX_BUFFER_SIZE;
+}
 
-		// Check if new packet start before previous packet completed. Discard previous packet and start over.
-		if(tXbeeFrame.pos > 0 && rxB == START_BYTE) {
-			tXbeeFrame.errorCode = UNEXPECTED_START_BYTE;
-			return;
-		}
+//**************************************************************************************************
+// Number of complete frames waiting in the receive queue.
+static inline uint8_t xbeeRxQueueCount(void){
+	return (uint8_t)(tXbeeRxFrame.head - tXbeeRxFrame.tail);
+}
 
-		if((tXbeeFrame.pos > 0) && (rxB == ESCAPE_BYTE)){
-			// Escape byte.  Next byte will be.
-			tXbeeFrame.escape = true;
-			continue;	// Re-execute while()
-		}
+//**************************************************************************************************
+// Give ring buffer bytes no longer needed back to UART1. Queued frames keep every byte from the
+// oldest frame on, otherwise bytes before ring index idx, the first one the parser still needs,
+// are released.
+static void xbeeRxRingRelease(uint32_t idx){
+	if(xbeeRxQueueCount() == 0){
+		UARTRxBufferRelease(idx);
+	}
+	else{
+		UARTRxBufferRelease(tXbeeRxFrame.slots[tXbeeRxFrame.tail & (XBEE_RX_QUEUE_SIZE - 1)].start);
+	}
+}
+
+//**************************************************************************************************
+// Discard the frame being parsed, giving its bytes before ring index idx back to UART1.
+static void xbeeRxDiscard(uint8_t errorCode, uint32_t idx){
+	tXbeeRxFrame.errorCode = errorCode;
+	tXbeeRxFrame.errorCount++;
+	tXbeeRxFrame.pos = 0;
+	xbeeRxRingRelease(idx);
+}
+
+//**************************************************************************************************
+// Drop the escape bytes of the frame between ring indices start and end, moving the following
+// bytes down so the unescaped frame is stored from the start byte on.
+static void xbeeRxUnescape(uint32_t start, uint32_t end){
+	uint32_t r = xbeeRxIndex(start, 1);
+	uint32_t w = r;
+	bool escape = false;
+	uint8_t b;
 
-		// If previous byte was an escape byte, then next byte must be XOR'ed.
-		if(tXbeeFrame.escape == true){
-			rxB = 0x20 ^ rxB;
-			tXbeeFrame.escape = false;
+	while(r != end){
+		b = tXbeeRxFrame.ring[r];
+		r = xbeeRxIndex(r, 1);
+		if(b == ESCAPE_BYTE){
+			escape = true;
+			continue;
 		}
+		if(escape){
+			b = 0x20 ^ b;
+			escape = false;
+		}
+		tXbeeRxFrame.ring[w] = b;
+		w = xbeeRxIndex(w, 1);
+	}
+}
+
+//**************************************************************************************************
+// Set view of length bytes of the unescaped frame starting at ring index start, from frame
+// position offset on.
+static void xbeeRxViewSet(struct tXbeeRxView *view, uint32_t start, uint16_t offset, uint16_t length){
+	uint32_t first = xbeeRxIndex(start, offset);
+
+	view->data1 = &tXbeeRxFrame.ring[first];
+	view->data2 = tXbeeRxFrame.ring;
+	if(first + length <= UART_RX_BUFFER_SIZE){
+		view->length1 = length;
+		view->length2 = 0;
+	}
+	else{
+		view->length1 = UART_RX_BUFFER_SIZE - first;
+		view->length2 = length - view->length1;
+	}
+}
+
+//**************************************************************************************************
+// Queue the frame just validated, ending before ring index end.
+static void xbeeRxQueuePush(uint32_t end){
+	struct tXbeeRxSlot *slot = &tXbeeRxFrame.slots[tXbeeRxFrame.head & (XBEE_RX_QUEUE_SIZE - 1)];
+	uint32_t start = tXbeeRxFrame.start;
+	uint16_t addrIdx;
+	uint8_t count;
+	uint8_t i;
+
+	if(tXbeeRxFrame.escaped){
+		xbeeRxUnescape(start, end);
+	}
+
+	slot->frameType = tXbeeRxFrame.frameType;
+	slot->start = start;
+	slot->end = end;
+	xbeeRxViewSet(&slot->data, start, FRAME_TYPE_IDX + 1, tXbeeRxFrame.frameLength - 1);
 
-		// Checksum includes all bytes after frame type byte.
-		if(tXbeeFrame.pos >= FRAME_TYPE_IDX){
-			tXbeeFrame.rxChecksumTotal += rxB;
+	// Remote frames start with the source addresses, after the frame id for a remote command response.
+	switch(slot->frameType){
+		case ZB_RECEIVE_PACKET:
+		case ZB_EXPLICIT_RX_INDICATOR:
+		case ZB_IO_DATA_SAMPLE_RX_INDICATOR:
+		case NODE_IDENTIFICATION_INDICATOR:
+		case ROUTE_RECORD_INDICATOR:
+		case MANY_TO_ONE_ROUTE_REQUEST_INDICATOR:
+			addrIdx = FRAME_TYPE_IDX + 1;
+			break;
+		case REMOTE_COMMAND_RESPONSE:
+			addrIdx = FRAME_TYPE_IDX + 2;
+			break;
+		default:
+			addrIdx = 0;
+	}
+	if(addrIdx && tXbeeRxFrame.frameLength + FRAME_TYPE_IDX >= addrIdx + 10){
+		for(i = 0; i < 8; i++){
+			slot->srcAddr64[i] = tXbeeRxFrame.ring[xbeeRxIndex(start, addrIdx + i)];
+		}
+		slot->srcAddr16 = ((uint16_t)tXbeeRxFrame.ring[xbeeRxIndex(start, addrIdx + 8)] << 8) |
+						  tXbeeRxFrame.ring[xbeeRxIndex(start, addrIdx + 9)];
+	}
+	else{
+		for(i = 0; i < 8; i++){
+			slot->srcAddr64[i] = 0;
 		}
+		slot->srcAddr16 = 0;
+	}
+
+	// Publish the slot once it is filled.
+	tXbeeRxFrame.head++;
+	count = xbeeRxQueueCount();
+	if(count > tXbeeRxFrame.highWater){
+		tXbeeRxFrame.highWater = count;
+	}
+}
+
+//**************************************************************************************************
+// Parse bytes received by UART1 where the UART interrupt stored them. Bytes are not copied:
+// complete frames stay in the receive ring buffer, with escape sequences removed in place, and are
+// queued until released with ZBRxFrameRelease(). Bytes outside frames and bad frames are released
+// right away. Parsing goes on until all received bytes are parsed or the queue is full.
+// Return the oldest queued frame, or 0 if there is none.
+const struct tXbeeRxSlot* XbeeZB :: ZBRxFrameReceive(void){
+	uint32_t writeIdx;
+	uint32_t spanEnd;
+	uint32_t idx;
+	uint8_t rxB;
+
+	writeIdx = UARTRxWriteIndexGet();
+	idx = tXbeeRxFrame.scan;
+	while(idx != writeIdx && xbeeRxQueueCount() < XBEE_RX_QUEUE_SIZE){
+		// Parse contiguous bytes up to the write index or up to the end of the ring.
+		spanEnd = (writeIdx > idx) ? writeIdx : UART_RX_BUFFER_SIZE;
+		for(; idx < spanEnd; idx++){
+			rxB = tXbeeRxFrame.ring[idx];
 
-		switch(tXbeeFrame.pos){
-			case 0:
-				if (rxB == START_BYTE) {
-					tXbeeFrame.rxFrameData[tXbeeFrame.pos] = rxB;
-					tXbeeFrame.pos++;
+			// A start byte always begins a new frame. If previous packet was not completed
+			// discard it and start over from here. Without escaping a start byte inside a
+			// frame is data, frames are only delimited by their length.
+			if(rxB == START_BYTE && (tXbeeRxFrame.pos == 0 || tXbeeRxFrame.apiMode == API_MODE_ESCAPED)){
+				if(tXbeeRxFrame.pos > 0){
+					xbeeRxDiscard(UNEXPECTED_START_BYTE, idx);
 				}
-				break;
-			case 1:
-				// msb length shouldn't be used because frames length will be short.
-				tXbeeFrame.rxFrameData[tXbeeFrame.pos] = rxB;
-				tXbeeFrame.pos++;
-				break;
-			case 2:
-				// lsb length
-				tXbeeFrame.lsbRxFrameLength = rxB;	//rxFrameLengthCalculation();
-				tXbeeFrame.rxFrameData[tXbeeFrame.pos] = rxB;
-				tXbeeFrame.pos++;
-				break;
-			case 3:
-				tXbeeFrame.frameType = rxB;
-				tXbeeFrame.rxFrameData[tXbeeFrame.pos] = rxB;
-				tXbeeFrame.pos++;
-				break;
-			default:
-				// Starts at fifth byte
-				if (tXbeeFrame.pos > MAX_FRAME_SIZE) {
-					// Exceed max size (Error code is 2).
-					tXbeeFrame.errorCode = PACKET_EXCEEDS_BYTE_ARRAY_LENGTH;
-					return;
+				else{
+					xbeeRxRingRelease(idx);
 				}
+				tXbeeRxFrame.start = idx;
+				tXbeeRxFrame.pos = 1;
+				tXbeeRxFrame.checksum = 0;
+				tXbeeRxFrame.escape = false;
+				tXbeeRxFrame.escaped = false;
+				continue;
+			}
 
-				// Store received data message from ZB Receive Packet frame (0x90)
-				if ((tXbeeFrame.pos >= RECEIVED_DATA_IDX) && (tXbeeFrame.pos < (tXbeeFrame.lsbRxFrameLength + FRAME_TYPE_IDX)) && (tXbeeFrame.frameType == 0x90)) {
-					// Fill array with data byte received.
-					tXbeeFrame.message[tXbeeFrame.messageIdx] = rxB;
-					tXbeeFrame.messageIdx++;
-				}
+			// Skip bytes outside a frame.
+			if(tXbeeRxFrame.pos == 0){
+				continue;
+			}
+
+			if(rxB == ESCAPE_BYTE && tXbeeRxFrame.apiMode == API_MODE_ESCAPED){
+				tXbeeRxFrame.escape = true;
+				tXbeeRxFrame.escaped = true;
+				continue;
+			}
+
+			// If previous byte was an escape byte, then next byte must be XOR'ed.
+			if(tXbeeRxFrame.escape){
+				rxB = 0x20 ^ rxB;
+				tXbeeRxFrame.escape = false;
+			}
 
-				// Check if we are at the end of the packet.
-				else if (tXbeeFrame.pos == (tXbeeFrame.lsbRxFrameLength + FRAME_TYPE_IDX)) {
-					// rxChecksumTotal has included the checksum byte in it.
-					if ((tXbeeFrame.rxChecksumTotal & 0xff) == 0xff) {
-						tXbeeFrame.rxComplete = true;
-						rxMsgPayloadComplete = true;	// Payload message is complete. Now xbee_cmdline can parse sended cmd.
-						tXbeeFrame.errorCode = NO_ERROR;
-						ROM_UARTCharPutNonBlocking(UART0_BASE, '\n');
-						ROM_UARTCharPutNonBlocking(UART0_BASE, '\r');
-						return;
+			switch(tXbeeRxFrame.pos){
+				case 1:
+					tXbeeRxFrame.frameLength = (uint16_t)rxB << 8;
+					break;
+				case 2:
+					tXbeeRxFrame.frameLength |= rxB;
+					// Start byte, length and checksum are not counted in frame length.
+					if(tXbeeRxFrame.frameLength == 0 || tXbeeRxFrame.frameLength > MAX_FRAME_SIZE - 4){
+						xbeeRxDiscard(PACKET_EXCEEDS_BYTE_ARRAY_LENGTH, xbeeRxIndex(idx, 1));
+						continue;
 					}
-					// Checksum failed.
-					else {
-						tXbeeFrame.errorCode = CHECKSUM_FAILURE;
-						return;
+					break;
+				case 3:
+					tXbeeRxFrame.frameType = rxB;
+					break;
+			}
+
+			// Checksum includes all bytes after frame length bytes.
+			if(tXbeeRxFrame.pos >= FRAME_TYPE_IDX){
+				tXbeeRxFrame.checksum += rxB;
+			}
+			tXbeeRxFrame.pos++;
+
+			// Check if we are at the end of the packet.
+			if(tXbeeRxFrame.pos == tXbeeRxFrame.frameLength + 4){
+				if(tXbeeRxFrame.checksum == 0xff){
+					tXbeeRxFrame.pos = 0;
+					tXbeeRxFrame.errorCode = NO_ERROR;
+					xbeeRxQueuePush(xbeeRxIndex(idx, 1));
+					if(xbeeRxQueueCount() == XBEE_RX_QUEUE_SIZE){
+						idx++;
+						break;
 					}
 				}
-				tXbeeFrame.rxFrameData[tXbeeFrame.pos] = rxB;
-				tXbeeFrame.pos++;
+				else{
+					xbeeRxDiscard(CHECKSUM_FAILURE, xbeeRxIndex(idx, 1));
+				}
+			}
+		}
+		if(idx == UART_RX_BUFFER_SIZE){
+			idx = 0;
 		}
 	}
+	tXbeeRxFrame.scan = idx;
+
+	// Bytes outside a frame are not needed anymore.
+	if(tXbeeRxFrame.pos == 0){
+		xbeeRxRingRelease(idx);
+	}
+
+	if(xbeeRxQueueCount() == 0){
+		return 0;
+	}
+	return &tXbeeRxFrame.slots[tXbeeRxFrame.tail & (XBEE_RX_QUEUE_SIZE - 1)];
 }
 
 //**************************************************************************************************
-// Get received message payload from frame packet.
-uint8_t* XbeeZB :: getRxMsgPayload(){
-	return tXbeeFrame.message;
+// Release the oldest queued frame, giving its ring buffer bytes back to UART1. Views of the frame
+// are no longer valid after this call.
+void XbeeZB :: ZBRxFrameRelease(void){
+	if(xbeeRxQueueCount() > 0){
+		tXbeeRxFrame.tail++;
+		xbeeRxRingRelease(tXbeeRxFrame.pos > 0 ? tXbeeRxFrame.start : tXbeeRxFrame.scan);
+	}
 }
 
 //**************************************************************************************************
-// Check if received data is complete and ready to be used and parsed. Return true when is complete.
-bool XbeeZB :: isRxComplete(){
-	return  tXbeeFrame.rxComplete;
+// Get largest number of frames queued at once.
+uint8_t XbeeZB :: getRxQueueHighWater(void){
+	return tXbeeRxFrame.highWater;
 }
-//**************************************************************************************************
-// It check if received payload message is complete.
-/*bool XbeeZB :: isRxMsgPayloadComplete(){
-	return tXbeeFrame.rxMsgPayloadComplete;
-}*/
 
+//**************************************************************************************************
+// Get number of received frames discarded because of errors.
+uint32_t XbeeZB :: getRxErrorCount(void){
+	return tXbeeRxFrame.errorCount;
+}
@@ -10,8 +10,15 @@
 
 // Xbee Defines
 #define MAX_FRAME_SIZE	      		      255
+#define ZB_MAX_RF_PAYLOAD		   			   84	// ZB Transmit Request payload limit without APS encryption.
+#define MAX_TX_FRAME_SIZE	  (2*MAX_FRAME_SIZE + 3)	// Frame with every byte escaped except start byte.
+#define ZB_UNKNOWN_ADDR16				   0xFFFE	// 16 bit address to use when it is not known.
+#define ZB_COORDINATOR_ADDR16			   0x0000	// The coordinator always has 16 bit address 0.
+#define REMOTE_AT_APPLY_CHANGES		    0x02	// Remote AT Command Request option, apply at once.
+#define ZB_TX_HEADER_SIZE				   12	// ZB Transmit Request addresses, radius and options.
 #define FRAME_TYPE_IDX		       		    3	// Position index of frame type byte in frame packet.
 #define RECEIVED_DATA_IDX		  		   15	// Idx for received data in ZB Receive Packet frame.
+#define XBEE_RX_QUEUE_SIZE				    4	// Received frames waiting to be processed. Power of 2.
 // Especial data frame bytes
 #define START_BYTE	 		  			 0x7E
 #define ESCAPE_BYTE				         0x7D
@@ -26,6 +33,9 @@
 #define ESCAPE_OFF 						    0
 #define ESCAPE_ON  							1
 #define ATAP	   							2
+// API modes, the ATAP value of the module.
+#define API_MODE_UNESCAPED					1	// Frames delimited by their length only.
+#define API_MODE_ESCAPED					2	// Special bytes escaped, start byte always starts a frame.
 // TX frame types API ids.
 #define AT_COMMAND								0x08	// Local
 #define AT_COMMAND_QUEUE_PARAMETER			    0x09	// Local
@@ -47,59 +57,158 @@
 
 
 
-// Data frame structure. Save frame parameters.
-struct tXbee{
-	uint8_t rxFrameData[MAX_FRAME_SIZE];	// Store frame packet data received from UART1.
-	uint8_t pos;							// Store received byte position in frame.
-	uint8_t lsbRxFrameLength;				// Store frame length. msb not used because frames are shorts.
+// View of frame bytes held in the UART1 receive ring buffer. When the bytes wrap around the end
+// of the ring they continue at data2, otherwise length2 is 0.
+struct tXbeeRxView{
+	const uint8_t *data1;
+	uint16_t length1;
+	const uint8_t *data2;
+	uint16_t length2;
+};
+
+// Received frame queued for processing. Its bytes stay in the UART1 receive ring buffer.
+struct tXbeeRxSlot{
 	uint8_t frameType;
-	uint16_t rxChecksumTotal;				// Save frame checksum.
-	uint8_t message[MAX_FRAME_SIZE - 16];	// Store message received from ZB Receive Packet frame.
-	uint8_t messageIdx;						// Index for each message byte.
-	uint8_t errorCode;
+	uint8_t srcAddr64[8];					// 64 bit source address, msb first. Zero if frame has none.
+	uint16_t srcAddr16;						// 16 bit source address. Zero if frame has none.
+	struct tXbeeRxView data;				// Frame data after frame type, see xbee_frames.h to decode it.
+	uint32_t start;							// Ring index of the frame start byte.
+	uint32_t end;							// Ring index following the frame checksum.
+};
+
+// Zero copy receive parser state. Frames are validated directly in the UART1 receive ring buffer
+// and stay there, unescaped in place, queued until released. The parser fills the queue at head
+// and the consumer releases frames at tail, in order.
+struct tXbeeRx{
+	uint8_t *ring;							// UART1 receive ring buffer.
+	uint32_t start;							// Ring index of the start byte of the frame being parsed.
+	uint32_t scan;							// Ring index of the next byte to parse.
+	uint16_t pos;							// Unescaped position of the next byte in frame.
+	uint16_t frameLength;					// Frame length field.
+	uint8_t frameType;
+	uint8_t checksum;
+	uint8_t errorCode;						// Last error found while parsing.
+	uint32_t errorCount;					// Frames discarded because of errors.
 	bool escape;							// True when next frame byte will be the original escaped byte.
-	bool rxComplete;						// True when all frame bytes were successfully received.
+	bool escaped;							// True when the frame contains escaped bytes.
+	uint8_t apiMode;						// API_MODE_ESCAPED or API_MODE_UNESCAPED.
+	struct tXbeeRxSlot slots[XBEE_RX_QUEUE_SIZE];
+	volatile uint8_t head;					// Free running count of queued frames.
+	volatile uint8_t tail;					// Free running count of released frames.
+	uint8_t highWater;						// Largest number of frames queued at once.
 };
 
+// Piece of a transmit payload. A payload may be gathered from several segments, so headers and
+// data held in different buffers are sent without copying them together first.
+struct tXbeeTxSegment{
+	const uint8_t *data;
+	uint8_t length;
+};
 
+// Prebuilt ZB Transmit Request header for one destination and option set. The addresses, radius
+// and options bytes are stored as is and escaped, one for each API mode, and checksum holds their
+// sum plus the frame type, so only the length, frame id and payload are escaped and summed when a
+// frame is sent.
+struct tXbeeTxHeader{
+	uint8_t raw[ZB_TX_HEADER_SIZE];
+	uint8_t escaped[2*ZB_TX_HEADER_SIZE];
+	uint8_t escapedLength;
+	uint8_t checksum;
+};
+
+// Transmit frame structure. Frames are built here, escaped, then queued to UART1 at once.
+struct tXbeeTx{
+	uint8_t txFrameData[MAX_TX_FRAME_SIZE];	// Escaped frame bytes ready for UART1.
+	uint16_t txLength;						// Number of bytes stored in txFrameData.
+	volatile bool txBusy;					// True until the last queued byte has left UART1.
+	uint8_t frameId;						// Last frame id given out.
+	uint8_t apiMode;						// API_MODE_ESCAPED or API_MODE_UNESCAPED.
+};
+
+
+
+// 64 bit address of the coordinator.
+extern const uint8_t g_pui8ZBCoordinatorAddr64[8];
 
 class XbeeZB {
 public:
 	//**************************************************************************************************
-	// Constructor will initialize tXbee frame struct.
+	// Constructor will initialize transmit and receive frame structs.
 	XbeeZB();
 
 	//**************************************************************************************************
-	// Clear all frame data.
-	void resetXbeeFrameInfo(void);
+	// Bind the frame parser and transmitter to UART1. Call once UART1 is configured.
+	void begin(void);
 
 	//**************************************************************************************************
-	// Send frame byte via UART to the xbee module.
+	// Append frame byte to the transmit frame buffer.
 	uint8_t xbeeByteTx(uint8_t b, bool escapeMode);
 
 	//**************************************************************************************************
-	// Send data to coordinator via ZB Transmit Request frame.
-	void ZBTransmitRequest(const uint8_t *payloadMsg);
+	// Send data via ZB Transmit Request frame. Payloads are binary, their length is always given.
+	// Return false if UART1 has no room or the payload is longer than ZB_MAX_RF_PAYLOAD.
+	bool ZBTransmitRequest(const uint8_t *payloadMsg, uint8_t payloadLength);
+	bool ZBTransmitRequest(const uint8_t *payloadMsg, uint8_t payloadLength, uint8_t frameId);
+	bool ZBTransmitRequest(const uint8_t *dstAddr64, uint16_t dstAddr16, const uint8_t *payloadMsg,
+						   uint8_t payloadLength, uint8_t frameId);
+	bool ZBTransmitRequest(const uint8_t *dstAddr64, uint16_t dstAddr16, const struct tXbeeTxSegment *segments,
+						   uint8_t segmentCount, uint8_t frameId);
+
+	//**************************************************************************************************
+	// Build the cached header of ZB Transmit Requests sent to one destination with given options.
+	void buildTxHeader(struct tXbeeTxHeader *header, const uint8_t *dstAddr64, uint16_t dstAddr16,
+					   uint8_t radius, uint8_t options);
+
+	//**************************************************************************************************
+	// Send the payload made of segments via ZB Transmit Request frame with a prebuilt header.
+	bool ZBTransmitRequest(const struct tXbeeTxHeader *header, const struct tXbeeTxSegment *segments,
+						   uint8_t segmentCount, uint8_t frameId);
+
+	//**************************************************************************************************
+	// Store a source route to a node in the module via Create Source Route frame.
+	bool ZBCreateSourceRoute(const uint8_t *dstAddr64, uint16_t dstAddr16, const uint16_t *hops,
+							 uint8_t hopCount);
+
+	//**************************************************************************************************
+	// Send a local AT command, applied at once or queued until AC. Return false if UART1 has no room.
+	bool ATCommandRequest(const uint8_t *command, const uint8_t *parameter, uint8_t parameterLength,
+						  uint8_t frameId, bool queue);
+
+	//**************************************************************************************************
+	// Send an AT command to a remote module. Return false if UART1 has no room.
+	bool RemoteATCommandRequest(const uint8_t *dstAddr64, uint16_t dstAddr16, const uint8_t *command,
+								const uint8_t *parameter, uint8_t parameterLength, uint8_t frameId,
+								uint8_t options);
+
+	//**************************************************************************************************
+	// Set the API mode used to build and parse frames, which must match the module ATAP value.
+	void setApiMode(uint8_t apiMode);
+	uint8_t getApiMode(void);
+
+	//**************************************************************************************************
+	// Get frame id for a frame expecting a response. Ids roll over from 255 to 1, 0 means no response.
+	uint8_t nextFrameId(void);
 
 	//**************************************************************************************************
-	// ZB Receive Packet frame (0x90) handler executed with UART RX interrupt.
-	void ZBReceivePacket(void);
+	// Parse bytes received by UART1 in place. Return oldest queued frame, or 0 if there is none.
+	const struct tXbeeRxSlot* ZBRxFrameReceive(void);
 
 	//**************************************************************************************************
-	// Get received message payload from frame packet.
-	uint8_t* getRxMsgPayload(void);
+	// Release the oldest queued frame, giving its ring buffer bytes back to UART1.
+	void ZBRxFrameRelease(void);
 
 	//**************************************************************************************************
-	// It check if received data is complete and ready to be used and parsed.
-	bool isRxComplete(void);
+	// Get largest number of frames queued at once.
+	uint8_t getRxQueueHighWater(void);
 
 	//**************************************************************************************************
-	// It check if received payload message is complete.
-	//bool isRxMsgPayloadComplete(void);
+	// Get number of received frames discarded because of errors.
+	uint32_t getRxErrorCount(void);
 
+private:
 	//**************************************************************************************************
-	// Variables
-	bool rxMsgPayloadComplete;	// True when payload message is completelly received.
+	// Queue the frame built in the transmit buffer to UART1. Return false if UART1 has no room.
+	bool frameQueue(void);
 };
 
 
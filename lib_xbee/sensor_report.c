@@ -0,0 +1,360 @@
+/*
+ * sensor_report.c - Compact binary encoding of sensor reports sent in ZB
+ * 					 Transmit Request payloads.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lib_xbee/sensor_report.h"
+
+//*****************************************************************************
+// Payload format used for the periodic report.
+static uint8_t g_ui8ReportFormat = REPORT_FORMAT_ASCII;
+
+//*****************************************************************************
+// True when the periodic report waits for the gateway acknowledge.
+static bool g_bReportReliable = false;
+
+//*****************************************************************************
+// Smallest tag width able to hold i32Value.
+static uint8_t reportWidthGet(int32_t i32Value){
+	if(i32Value >= -128 && i32Value <= 127){
+		return REPORT_WIDTH_8;
+	}
+	if(i32Value >= -32768 && i32Value <= 32767){
+		return REPORT_WIDTH_16;
+	}
+	return REPORT_WIDTH_32;
+}
+
+//*****************************************************************************
+// Number of value bytes following a tag of width ui8Width.
+static uint8_t reportWidthBytes(uint8_t ui8Width){
+	switch(ui8Width){
+		case REPORT_WIDTH_8:	return 1;
+		case REPORT_WIDTH_16:	return 2;
+		case REPORT_WIDTH_32:	return 4;
+		default:				return 0;
+	}
+}
+
+//*****************************************************************************
+// Convert a sensor reading to hundredths of its unit, rounded to nearest.
+int32_t SensorReportFixedPoint(float fValue){
+	if(fValue < 0.0f){
+		return (int32_t)(fValue * 100.0f - 0.5f);
+	}
+	return (int32_t)(fValue * 100.0f + 0.5f);
+}
+
+//*****************************************************************************
+// Encoded size of a value.
+static uint8_t reportValueSize(const tReportValue *psValue){
+	return 1 + reportWidthBytes(reportWidthGet(psValue->i32Value));
+}
+
+//*****************************************************************************
+// Encode ui8Count values at pui8Buf[ui16Idx]. Return the index following the
+// last value, or 0 if ui16Size is too small.
+static uint16_t reportValuesEncode(uint8_t *pui8Buf, uint16_t ui16Idx, uint16_t ui16Size,
+								   const tReportValue *psValues, uint8_t ui8Count){
+	uint8_t ui8Value;
+	uint8_t ui8Width;
+	uint8_t ui8Bytes;
+	uint8_t ui8Byte;
+	uint32_t ui32Raw;
+
+	for(ui8Value = 0; ui8Value < ui8Count; ui8Value++){
+		ui8Width = reportWidthGet(psValues[ui8Value].i32Value);
+		ui8Bytes = reportWidthBytes(ui8Width);
+		if(ui16Idx + 1 + ui8Bytes > ui16Size){
+			return 0;
+		}
+
+		pui8Buf[ui16Idx++] = ui8Width | (psValues[ui8Value].ui8Sensor & REPORT_SENSOR_M);
+		ui32Raw = (uint32_t)psValues[ui8Value].i32Value;
+		for(ui8Byte = 0; ui8Byte < ui8Bytes; ui8Byte++){
+			pui8Buf[ui16Idx++] = (uint8_t)(ui32Raw >> (8 * ui8Byte));
+		}
+	}
+
+	return ui16Idx;
+}
+
+//*****************************************************************************
+// Decode ui8Count values at pui8Buf[ui16Idx]. Up to ui8MaxCount values are
+// stored in psValues. Return the index following the last value, or 0 if the
+// values run past ui16Len.
+static uint16_t reportValuesDecode(const uint8_t *pui8Buf, uint16_t ui16Idx, uint16_t ui16Len,
+								   uint8_t ui8Count, tReportValue *psValues, uint8_t ui8MaxCount){
+	uint8_t ui8Value;
+	uint8_t ui8Bytes;
+	uint8_t ui8Byte;
+	uint32_t ui32Raw;
+
+	for(ui8Value = 0; ui8Value < ui8Count; ui8Value++){
+		if(ui16Idx >= ui16Len){
+			return 0;
+		}
+		ui8Bytes = reportWidthBytes(pui8Buf[ui16Idx] & REPORT_WIDTH_M);
+		if(ui8Bytes == 0 || ui16Idx + 1 + ui8Bytes > ui16Len){
+			return 0;
+		}
+
+		// Sign extend from the most significant stored byte.
+		ui32Raw = (pui8Buf[ui16Idx + ui8Bytes] & 0x80) ? 0xFFFFFFFF : 0;
+		for(ui8Byte = ui8Bytes; ui8Byte > 0; ui8Byte--){
+			ui32Raw = (ui32Raw << 8) | pui8Buf[ui16Idx + ui8Byte];
+		}
+
+		if(ui8Value < ui8MaxCount){
+			psValues[ui8Value].ui8Sensor = pui8Buf[ui16Idx] & REPORT_SENSOR_M;
+			psValues[ui8Value].i32Value = (int32_t)ui32Raw;
+		}
+		ui16Idx += 1 + ui8Bytes;
+	}
+
+	return ui16Idx;
+}
+
+//*****************************************************************************
+// Check the header of a record of type ui8Type.
+static bool reportHeaderValid(const uint8_t *pui8Buf, uint16_t ui16Len, uint8_t ui8Type){
+	return (ui16Len >= REPORT_HEADER_SIZE &&
+			(pui8Buf[0] & REPORT_MAGIC_M) == REPORT_MAGIC &&
+			(pui8Buf[0] & REPORT_VERSION_M) == REPORT_VERSION &&
+			pui8Buf[1] == ui8Type);
+}
+
+//*****************************************************************************
+// Encode ui8Count values as a REPORT_TYPE_SAMPLE record into pui8Buf. Each
+// value uses the smallest width able to hold it. Return the number of bytes
+// written, or 0 if ui16Size is too small.
+uint16_t SensorReportEncode(uint8_t *pui8Buf, uint16_t ui16Size,
+							const tReportValue *psValues, uint8_t ui8Count){
+	if(ui16Size < REPORT_HEADER_SIZE){
+		return 0;
+	}
+	pui8Buf[0] = REPORT_MAGIC | REPORT_VERSION;
+	pui8Buf[1] = REPORT_TYPE_SAMPLE;
+	pui8Buf[2] = ui8Count;
+
+	return reportValuesEncode(pui8Buf, REPORT_HEADER_SIZE, ui16Size, psValues, ui8Count);
+}
+
+//*****************************************************************************
+// Decode a REPORT_TYPE_SAMPLE record. Up to ui8MaxCount values are stored in
+// psValues. Return the number of values in the record, or -1 if the buffer is
+// not a valid record of a supported version.
+int16_t SensorReportDecode(const uint8_t *pui8Buf, uint16_t ui16Len,
+						   tReportValue *psValues, uint8_t ui8MaxCount){
+	if(!reportHeaderValid(pui8Buf, ui16Len, REPORT_TYPE_SAMPLE)){
+		return -1;
+	}
+	if(reportValuesDecode(pui8Buf, REPORT_HEADER_SIZE, ui16Len, pui8Buf[2],
+						  psValues, ui8MaxCount) == 0){
+		return -1;
+	}
+
+	return pui8Buf[2];
+}
+
+//*****************************************************************************
+// Encoded size of a sample inside a REPORT_TYPE_BATCH record.
+static uint16_t reportSampleSize(const tReportSample *psSample){
+	uint16_t ui16Size = 3;		// Time offset and value count.
+	uint8_t ui8Value;
+
+	for(ui8Value = 0; ui8Value < psSample->ui8Count; ui8Value++){
+		ui16Size += reportValueSize(&psSample->psValues[ui8Value]);
+	}
+
+	return ui16Size;
+}
+
+//*****************************************************************************
+// Prepare an empty batch. A record is sent once it would reach ui16MaxPayload
+// bytes, or once the oldest sample is ui32MaxAgeMs old, whichever is first.
+void SensorReportBatchInit(tReportBatch *psBatch, uint16_t ui16MaxPayload, uint32_t ui32MaxAgeMs){
+	psBatch->ui8Read = 0;
+	psBatch->ui8Count = 0;
+	psBatch->ui16EncodedSize = REPORT_BATCH_HEADER_SIZE;
+	psBatch->ui16MaxPayload = ui16MaxPayload;
+	psBatch->ui32MaxAgeMs = ui32MaxAgeMs;
+	psBatch->ui32Dropped = 0;
+}
+
+//*****************************************************************************
+// Store a sample. When the ring is full the oldest sample is dropped.
+void SensorReportBatchAdd(tReportBatch *psBatch, const tReportSample *psSample){
+	uint8_t ui8Write;
+
+	if(psBatch->ui8Count == REPORT_BATCH_SIZE){
+		psBatch->ui16EncodedSize -= reportSampleSize(&psBatch->psSamples[psBatch->ui8Read]);
+		psBatch->ui8Read = (psBatch->ui8Read + 1) % REPORT_BATCH_SIZE;
+		psBatch->ui8Count--;
+		psBatch->ui32Dropped++;
+	}
+
+	ui8Write = (psBatch->ui8Read + psBatch->ui8Count) % REPORT_BATCH_SIZE;
+	psBatch->psSamples[ui8Write] = *psSample;
+	if(psBatch->psSamples[ui8Write].ui8Count > REPORT_MAX_VALUES){
+		psBatch->psSamples[ui8Write].ui8Count = REPORT_MAX_VALUES;
+	}
+	psBatch->ui16EncodedSize += reportSampleSize(&psBatch->psSamples[ui8Write]);
+	psBatch->ui8Count++;
+}
+
+//*****************************************************************************
+// Return true when a record should be sent now: the stored samples fill the
+// maximum payload, the ring is full, or the oldest sample reached its maximum age.
+bool SensorReportBatchReady(tReportBatch *psBatch, uint32_t ui32NowMs){
+	const tReportSample *psOldest;
+
+	if(psBatch->ui8Count == 0){
+		return false;
+	}
+	psOldest = &psBatch->psSamples[psBatch->ui8Read];
+
+	// Another sample of the same shape would not fit in the payload.
+	if(psBatch->ui16EncodedSize + reportSampleSize(psOldest) > psBatch->ui16MaxPayload){
+		return true;
+	}
+	if(psBatch->ui8Count == REPORT_BATCH_SIZE){
+		return true;
+	}
+	return ((ui32NowMs - psOldest->ui32TimeMs) >= psBatch->ui32MaxAgeMs);
+}
+
+//*****************************************************************************
+// Encode the oldest samples that fit in ui16Size bytes as a REPORT_TYPE_BATCH
+// record. The samples stay in the batch, and the number encoded is stored in
+// *pui8Samples so they can be removed with SensorReportBatchDiscard() once the
+// record is sent. Return the record size, or 0 if the batch is empty or
+// ui16Size cannot hold a single sample.
+uint16_t SensorReportBatchEncode(const tReportBatch *psBatch, uint8_t *pui8Buf, uint16_t ui16Size,
+								 uint8_t *pui8Samples){
+	const tReportSample *psSample;
+	uint32_t ui32BaseTick;
+	uint32_t ui32Offset;
+	uint16_t ui16Idx = REPORT_BATCH_HEADER_SIZE;
+	uint16_t ui16Next;
+	uint8_t ui8Samples = 0;
+
+	*pui8Samples = 0;
+
+	if(psBatch->ui8Count == 0 || ui16Size < REPORT_BATCH_HEADER_SIZE){
+		return 0;
+	}
+
+	psSample = &psBatch->psSamples[psBatch->ui8Read];
+	ui32BaseTick = psSample->ui32TimeMs / REPORT_BATCH_TICK_MS;
+	pui8Buf[0] = REPORT_MAGIC | REPORT_VERSION;
+	pui8Buf[1] = REPORT_TYPE_BATCH;
+	pui8Buf[3] = (uint8_t)ui32BaseTick;
+	pui8Buf[4] = (uint8_t)(ui32BaseTick >> 8);
+	pui8Buf[5] = (uint8_t)(ui32BaseTick >> 16);
+	pui8Buf[6] = (uint8_t)(ui32BaseTick >> 24);
+
+	while(ui8Samples < psBatch->ui8Count){
+		psSample = &psBatch->psSamples[(psBatch->ui8Read + ui8Samples) % REPORT_BATCH_SIZE];
+		ui32Offset = psSample->ui32TimeMs / REPORT_BATCH_TICK_MS - ui32BaseTick;
+		if(ui32Offset > 0xFFFF || ui16Idx + 3 > ui16Size){
+			break;
+		}
+		pui8Buf[ui16Idx] = (uint8_t)ui32Offset;
+		pui8Buf[ui16Idx + 1] = (uint8_t)(ui32Offset >> 8);
+		pui8Buf[ui16Idx + 2] = psSample->ui8Count;
+		ui16Next = reportValuesEncode(pui8Buf, ui16Idx + 3, ui16Size,
+									  psSample->psValues, psSample->ui8Count);
+		if(ui16Next == 0){
+			break;
+		}
+		ui16Idx = ui16Next;
+		ui8Samples++;
+	}
+
+	if(ui8Samples == 0){
+		return 0;
+	}
+	pui8Buf[2] = ui8Samples;
+	*pui8Samples = ui8Samples;
+	return ui16Idx;
+}
+
+//*****************************************************************************
+// Remove the ui8Samples oldest samples, once the record encoding them was
+// accepted for transmission.
+void SensorReportBatchDiscard(tReportBatch *psBatch, uint8_t ui8Samples){
+	while(ui8Samples && psBatch->ui8Count){
+		psBatch->ui16EncodedSize -= reportSampleSize(&psBatch->psSamples[psBatch->ui8Read]);
+		psBatch->ui8Read = (psBatch->ui8Read + 1) % REPORT_BATCH_SIZE;
+		psBatch->ui8Count--;
+		ui8Samples--;
+	}
+}
+
+//*****************************************************************************
+// Decode a REPORT_TYPE_BATCH record. Up to ui8MaxCount samples are stored in
+// psSamples, with ui32TimeMs rebuilt from the record timestamps. Return the
+// number of samples in the record, or -1 if the buffer is not a valid record.
+int16_t SensorReportBatchDecode(const uint8_t *pui8Buf, uint16_t ui16Len,
+								tReportSample *psSamples, uint8_t ui8MaxCount){
+	tReportSample sDiscard;
+	tReportSample *psSample;
+	uint32_t ui32BaseTick;
+	uint16_t ui16Idx = REPORT_BATCH_HEADER_SIZE;
+	uint8_t ui8Sample;
+	uint8_t ui8Count;
+
+	if(!reportHeaderValid(pui8Buf, ui16Len, REPORT_TYPE_BATCH) || ui16Len < REPORT_BATCH_HEADER_SIZE){
+		return -1;
+	}
+	ui32BaseTick = (uint32_t)pui8Buf[3] | ((uint32_t)pui8Buf[4] << 8) |
+				   ((uint32_t)pui8Buf[5] << 16) | ((uint32_t)pui8Buf[6] << 24);
+
+	for(ui8Sample = 0; ui8Sample < pui8Buf[2]; ui8Sample++){
+		if(ui16Idx + 3 > ui16Len){
+			return -1;
+		}
+		psSample = (ui8Sample < ui8MaxCount) ? &psSamples[ui8Sample] : &sDiscard;
+		psSample->ui32TimeMs = (ui32BaseTick + ((uint32_t)pui8Buf[ui16Idx] |
+							   ((uint32_t)pui8Buf[ui16Idx + 1] << 8))) * REPORT_BATCH_TICK_MS;
+		ui8Count = pui8Buf[ui16Idx + 2];
+		psSample->ui8Count = (ui8Count > REPORT_MAX_VALUES) ? REPORT_MAX_VALUES : ui8Count;
+		ui16Idx = reportValuesDecode(pui8Buf, ui16Idx + 3, ui16Len, ui8Count,
+									 psSample->psValues, REPORT_MAX_VALUES);
+		if(ui16Idx == 0){
+			return -1;
+		}
+	}
+
+	return pui8Buf[2];
+}
+
+//*****************************************************************************
+// Select the payload format of the periodic report.
+void SensorReportFormatSet(uint8_t ui8Format){
+	g_ui8ReportFormat = ui8Format;
+}
+
+//*****************************************************************************
+// Get the payload format of the periodic report.
+uint8_t SensorReportFormatGet(void){
+	return g_ui8ReportFormat;
+}
+
+//*****************************************************************************
+// Select whether the periodic report is sent with acknowledge and retransmit.
+void SensorReportReliableSet(bool bReliable){
+	g_bReportReliable = bReliable;
+}
+
+//*****************************************************************************
+// Check whether the periodic report is sent with acknowledge and retransmit.
+bool SensorReportReliableGet(void){
+	return g_bReportReliable;
+}
@@ -0,0 +1,137 @@
+/*
+ * sensor_report.h - Compact binary encoding of sensor reports sent in ZB
+ * 					 Transmit Request payloads.
+ *
+ * The module only depends on stdint/stdbool so the gateway can build the same
+ * encoder and decoder on the host.
+ *
+ * Report layout (multi-byte values little endian):
+ *   0      Header: REPORT_MAGIC in high nibble, REPORT_VERSION in low nibble.
+ *   1      Record type (REPORT_TYPE_*).
+ *   2      Number of values that follow.
+ *   3..    Values, each a tag byte followed by a fixed-point value. The tag
+ *          carries the sensor type in bits 0-5 and the value width in bits
+ *          6-7 (REPORT_WIDTH_*), so unknown sensor types can be skipped.
+ *          Values are signed, in hundredths of the sensor unit.
+ *
+ * A REPORT_TYPE_BATCH record carries several timestamped samples:
+ *   0-2    Header, record type and number of samples.
+ *   3-6    Time of the first sample, in REPORT_BATCH_TICK_MS units.
+ *   7..    Samples, each a 16 bit time offset from the first sample in
+ *          REPORT_BATCH_TICK_MS units, a value count, then the values
+ *          encoded as in a REPORT_TYPE_SAMPLE record.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef SENSOR_REPORT_H_
+#define SENSOR_REPORT_H_
+
+//*****************************************************************************
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+// Report header.
+#define REPORT_MAGIC				0xB0
+#define REPORT_MAGIC_M				0xF0
+#define REPORT_VERSION				1
+#define REPORT_VERSION_M			0x0F
+#define REPORT_HEADER_SIZE			3
+
+//*****************************************************************************
+// Record types.
+#define REPORT_TYPE_SAMPLE			0x01	// One value per sensor.
+#define REPORT_TYPE_BATCH			0x02	// Several timestamped samples.
+
+//*****************************************************************************
+// Sensor types stored in bits 0-5 of a value tag.
+#define REPORT_SENSOR_TEMP			0x01	// Temperature, 0.01 degC.
+#define REPORT_SENSOR_PRESSURE		0x02	// Pressure, 0.01 Pa.
+#define REPORT_SENSOR_HUMIDITY		0x03	// Relative humidity, 0.01 %.
+#define REPORT_SENSOR_LIGHT			0x04	// Visible light, 0.01 lux.
+#define REPORT_SENSOR_M				0x3F
+
+//*****************************************************************************
+// Value widths stored in bits 6-7 of a value tag.
+#define REPORT_WIDTH_8				0x00
+#define REPORT_WIDTH_16				0x40
+#define REPORT_WIDTH_32				0x80
+#define REPORT_WIDTH_M				0xC0
+
+//*****************************************************************************
+// Report payload formats selectable at runtime.
+#define REPORT_FORMAT_ASCII			0		// "t20.51|p101325.12|h50.22|l180.50"
+#define REPORT_FORMAT_BINARY		1		// Layout described above.
+#define REPORT_FORMAT_BATCH			2		// Samples batched in REPORT_TYPE_BATCH records.
+
+//*****************************************************************************
+// Batching parameters.
+#define REPORT_MAX_VALUES			4		// Values per sample.
+#define REPORT_BATCH_SIZE			8		// Samples held in RAM before the oldest is dropped.
+#define REPORT_BATCH_TICK_MS		100		// Resolution of batch timestamps.
+#define REPORT_BATCH_HEADER_SIZE	7
+
+//*****************************************************************************
+// A sensor value in hundredths of its unit.
+typedef struct{
+	uint8_t ui8Sensor;				// REPORT_SENSOR_*.
+	int32_t i32Value;				// Fixed-point value, 2 decimals.
+}
+tReportValue;
+
+//*****************************************************************************
+// A set of values read at the same time.
+typedef struct{
+	uint32_t ui32TimeMs;			// Time at which the values were read.
+	uint8_t ui8Count;				// Number of values used in psValues.
+	tReportValue psValues[REPORT_MAX_VALUES];
+}
+tReportSample;
+
+//*****************************************************************************
+// Ring buffer of samples waiting to be sent in a REPORT_TYPE_BATCH record.
+typedef struct{
+	tReportSample psSamples[REPORT_BATCH_SIZE];
+	uint8_t ui8Read;				// Index of the oldest sample.
+	uint8_t ui8Count;				// Number of samples stored.
+	uint16_t ui16EncodedSize;		// Record size if every stored sample was sent.
+	uint16_t ui16MaxPayload;		// Largest record sent in one frame.
+	uint32_t ui32MaxAgeMs;			// Oldest sample age that forces a send.
+	uint32_t ui32Dropped;			// Samples overwritten because the ring was full.
+}
+tReportBatch;
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern int32_t SensorReportFixedPoint(float fValue);
+extern uint16_t SensorReportEncode(uint8_t *pui8Buf, uint16_t ui16Size,
+								   const tReportValue *psValues, uint8_t ui8Count);
+extern int16_t SensorReportDecode(const uint8_t *pui8Buf, uint16_t ui16Len,
+								  tReportValue *psValues, uint8_t ui8MaxCount);
+extern void SensorReportBatchInit(tReportBatch *psBatch, uint16_t ui16MaxPayload,
+								  uint32_t ui32MaxAgeMs);
+extern void SensorReportBatchAdd(tReportBatch *psBatch, const tReportSample *psSample);
+extern bool SensorReportBatchReady(tReportBatch *psBatch, uint32_t ui32NowMs);
+extern uint16_t SensorReportBatchEncode(const tReportBatch *psBatch, uint8_t *pui8Buf,
+										uint16_t ui16Size, uint8_t *pui8Samples);
+extern void SensorReportBatchDiscard(tReportBatch *psBatch, uint8_t ui8Samples);
+extern int16_t SensorReportBatchDecode(const uint8_t *pui8Buf, uint16_t ui16Len,
+									   tReportSample *psSamples, uint8_t ui8MaxCount);
+extern void SensorReportFormatSet(uint8_t ui8Format);
+extern uint8_t SensorReportFormatGet(void);
+extern void SensorReportReliableSet(bool bReliable);
+extern bool SensorReportReliableGet(void);
+
+//*****************************************************************************
+// Mark the end of the C bindings section for C++ compilers.
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_REPORT_H_ */
@@ -0,0 +1,143 @@
+/*
+ * xbee_addr_table.cpp - Learn the 16 bit network addresses of the nodes we
+ * 						 talk to, so ZB Transmit Requests carry them instead
+ * 						 of ZB_UNKNOWN_ADDR16.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_addr_table.h"
+
+static XbeeZB *g_psAddrTableXbee;
+static struct tXbeeAddrEntry g_psAddrTable[XBEE_ADDR_TABLE_SIZE];
+static uint32_t g_ui32AddrTableUses;
+static struct tXbeeAddrStats g_sAddrTableStats;
+
+//*****************************************************************************
+// Find the entry of pui8Addr64. When bAdd is true an entry with an unknown
+// address is made for a new node, replacing the least recently used one if
+// the table is full. Return 0 if not found and not added.
+static struct tXbeeAddrEntry *addrTableFind(const uint8_t *pui8Addr64, bool bAdd){
+	struct tXbeeAddrEntry *psVictim = 0;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_ADDR_TABLE_SIZE; i++){
+		if(!g_psAddrTable[i].inUse){
+			if(!psVictim || psVictim->inUse){
+				psVictim = &g_psAddrTable[i];
+			}
+		}
+		else if(memcmp(g_psAddrTable[i].addr64, pui8Addr64, 8) == 0){
+			return &g_psAddrTable[i];
+		}
+		else if(!psVictim || (psVictim->inUse && g_psAddrTable[i].lastUsed < psVictim->lastUsed)){
+			psVictim = &g_psAddrTable[i];
+		}
+	}
+	if(!bAdd){
+		return 0;
+	}
+
+	if(psVictim->inUse){
+		g_sAddrTableStats.evictions++;
+	}
+	psVictim->inUse = true;
+	memcpy(psVictim->addr64, pui8Addr64, 8);
+	psVictim->addr16 = ZB_UNKNOWN_ADDR16;
+	psVictim->lastUsed = g_ui32AddrTableUses;
+	g_psAddrTableXbee->buildTxHeader(&psVictim->txHeader, pui8Addr64, ZB_UNKNOWN_ADDR16, 0x00, 0x00);
+	return psVictim;
+}
+
+//*****************************************************************************
+// Set the address of an entry, rebuilding its header when it changes.
+static void addrTableSet(struct tXbeeAddrEntry *psEntry, uint16_t ui16Addr16){
+	if(psEntry->addr16 != ui16Addr16){
+		psEntry->addr16 = ui16Addr16;
+		g_psAddrTableXbee->buildTxHeader(&psEntry->txHeader, psEntry->addr64, ui16Addr16, 0x00, 0x00);
+	}
+}
+
+//*****************************************************************************
+// Initialize the table, with no address known.
+void XbeeAddrTableInit(XbeeZB *psXbee){
+	uint8_t i;
+
+	g_psAddrTableXbee = psXbee;
+	for(i = 0; i < XBEE_ADDR_TABLE_SIZE; i++){
+		g_psAddrTable[i].inUse = false;
+	}
+	g_ui32AddrTableUses = 0;
+	memset(&g_sAddrTableStats, 0, sizeof(g_sAddrTableStats));
+}
+
+//*****************************************************************************
+// Record that the node with 64 bit address pui8Addr64 has 16 bit address
+// ui16Addr16, as seen in a received frame. ZB_UNKNOWN_ADDR16 is ignored.
+// Frames from the coordinator also teach the entry of the reserved coordinator
+// address g_pui8ZBCoordinatorAddr64, which frames to the coordinator use.
+void XbeeAddrLearn(const uint8_t *pui8Addr64, uint16_t ui16Addr16){
+	struct tXbeeAddrEntry *psEntry;
+
+	if(ui16Addr16 == ZB_UNKNOWN_ADDR16){
+		return;
+	}
+
+	psEntry = addrTableFind(pui8Addr64, true);
+	if(psEntry->addr16 != ui16Addr16){
+		g_sAddrTableStats.learned++;
+	}
+	addrTableSet(psEntry, ui16Addr16);
+
+	if(ui16Addr16 == ZB_COORDINATOR_ADDR16 && memcmp(pui8Addr64, g_pui8ZBCoordinatorAddr64, 8) != 0){
+		psEntry = addrTableFind(g_pui8ZBCoordinatorAddr64, true);
+		addrTableSet(psEntry, ZB_COORDINATOR_ADDR16);
+	}
+}
+
+//*****************************************************************************
+// Forget the 16 bit address of pui8Addr64 after a failed delivery, so the
+// next frames let the module resolve it again.
+void XbeeAddrInvalidate(const uint8_t *pui8Addr64){
+	struct tXbeeAddrEntry *psEntry = addrTableFind(pui8Addr64, false);
+
+	if(psEntry && psEntry->addr16 != ZB_UNKNOWN_ADDR16){
+		g_sAddrTableStats.invalidated++;
+		addrTableSet(psEntry, ZB_UNKNOWN_ADDR16);
+	}
+}
+
+//*****************************************************************************
+// Get the 16 bit address of pui8Addr64, or ZB_UNKNOWN_ADDR16 if not known.
+uint16_t XbeeAddrLookup(const uint8_t *pui8Addr64){
+	struct tXbeeAddrEntry *psEntry = addrTableFind(pui8Addr64, false);
+
+	return psEntry ? psEntry->addr16 : ZB_UNKNOWN_ADDR16;
+}
+
+//*****************************************************************************
+// Get the ZB Transmit Request header to pui8Addr64, with its 16 bit address
+// if known. The header stays valid until the next call of the table APIs.
+const struct tXbeeTxHeader *XbeeAddrTxHeaderGet(const uint8_t *pui8Addr64){
+	struct tXbeeAddrEntry *psEntry = addrTableFind(pui8Addr64, true);
+
+	psEntry->lastUsed = ++g_ui32AddrTableUses;
+	if(psEntry->addr16 == ZB_UNKNOWN_ADDR16){
+		g_sAddrTableStats.misses++;
+	}
+	else{
+		g_sAddrTableStats.hits++;
+	}
+	return &psEntry->txHeader;
+}
+
+//*****************************************************************************
+// Get table statistics.
+void XbeeAddrStatsGet(struct tXbeeAddrStats *psStats){
+	*psStats = g_sAddrTableStats;
+}
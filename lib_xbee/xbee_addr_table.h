@@ -0,0 +1,59 @@
+/*
+ * xbee_addr_table.h - Learn the 16 bit network addresses of the nodes we talk
+ * 					   to, so ZB Transmit Requests carry them instead of
+ * 					   ZB_UNKNOWN_ADDR16.
+ *
+ * A frame sent with ZB_UNKNOWN_ADDR16 makes the module resolve the 64 bit
+ * address first, which may take a network address discovery. Addresses are
+ * learned from the source of ZB Receive Packets and from the destination
+ * reported by ZB Transmit Status frames. An entry falls back to
+ * ZB_UNKNOWN_ADDR16 when a delivery to its node fails, since the node may have
+ * rejoined with a new network address.
+ *
+ * Each entry keeps a prebuilt ZB Transmit Request header, rebuilt only when
+ * the learned address changes. The least recently used entry is replaced when
+ * the table is full.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef XBEE_ADDR_TABLE_H_
+#define XBEE_ADDR_TABLE_H_
+
+#include "lib_xbee/XbeeZB.h"
+
+//*****************************************************************************
+// Table parameters.
+#define XBEE_ADDR_TABLE_SIZE			    8		// Nodes with a cached address.
+
+//*****************************************************************************
+// Cached address of a node.
+struct tXbeeAddrEntry{
+	bool inUse;
+	uint8_t addr64[8];
+	uint16_t addr16;						// ZB_UNKNOWN_ADDR16 until learned.
+	uint32_t lastUsed;						// Table use count at last use, for replacement.
+	struct tXbeeTxHeader txHeader;			// ZB Transmit Request header to addr64 and addr16.
+};
+
+//*****************************************************************************
+// Table statistics.
+struct tXbeeAddrStats{
+	uint32_t learned;						// Addresses learned or changed.
+	uint32_t invalidated;					// Addresses dropped after a delivery failure.
+	uint32_t hits;							// Headers given out with a known address.
+	uint32_t misses;						// Headers given out with ZB_UNKNOWN_ADDR16.
+	uint32_t evictions;
+};
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern void XbeeAddrTableInit(XbeeZB *psXbee);
+extern void XbeeAddrLearn(const uint8_t *pui8Addr64, uint16_t ui16Addr16);
+extern void XbeeAddrInvalidate(const uint8_t *pui8Addr64);
+extern uint16_t XbeeAddrLookup(const uint8_t *pui8Addr64);
+extern const struct tXbeeTxHeader *XbeeAddrTxHeaderGet(const uint8_t *pui8Addr64);
+extern void XbeeAddrStatsGet(struct tXbeeAddrStats *psStats);
+
+#endif /* XBEE_ADDR_TABLE_H_ */
@@ -0,0 +1,414 @@
+/*
+ * xbee_at.cpp - Non blocking local and remote AT command client.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lib_utils/timebase.h"
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_addr_table.h"
+#include "lib_xbee/xbee_at.h"
+
+static XbeeZB *g_psAtXbee;
+static struct tXbeeAtEntry g_psAtQueue[XBEE_AT_QUEUE_SIZE];
+static uint8_t g_ui8AtQueuedSeq;				// Free running count of commands queued.
+static uint8_t g_ui8AtSentSeq;					// Free running count of commands sent.
+static struct tXbeeAtBatch g_sAtBatch;
+static struct tXbeeAtStats g_sAtStats;
+
+//*****************************************************************************
+// Number of free queue entries.
+static uint8_t atFreeCount(void){
+	uint8_t ui8Count = 0;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_AT_QUEUE_SIZE; i++){
+		if(g_psAtQueue[i].state == XBEE_AT_FREE){
+			ui8Count++;
+		}
+	}
+	return ui8Count;
+}
+
+//*****************************************************************************
+// Take a free entry and give it the next send order. Return 0 if none.
+static struct tXbeeAtEntry *atEntryTake(const char *pcCommand, const uint8_t *pui8Parameter, uint8_t ui8Length,
+										tXbeeAtCallback *pfnCallback, struct tXbeeAtFuture *psFuture){
+	struct tXbeeAtEntry *psEntry = 0;
+	uint8_t i;
+
+	if(ui8Length > XBEE_AT_MAX_PARAMETER){
+		return 0;
+	}
+	for(i = 0; i < XBEE_AT_QUEUE_SIZE; i++){
+		if(g_psAtQueue[i].state == XBEE_AT_FREE){
+			psEntry = &g_psAtQueue[i];
+			break;
+		}
+	}
+	if(!psEntry){
+		return 0;
+	}
+
+	psEntry->state = XBEE_AT_QUEUED;
+	psEntry->seq = g_ui8AtQueuedSeq++;
+	psEntry->queue = false;
+	psEntry->remote = false;
+	psEntry->options = 0;
+	psEntry->batchSlot = XBEE_AT_BATCH_IN_FLIGHT;
+	psEntry->command[0] = pcCommand[0];
+	psEntry->command[1] = pcCommand[1];
+	for(i = 0; i < ui8Length; i++){
+		psEntry->parameter[i] = pui8Parameter[i];
+	}
+	psEntry->parameterLength = ui8Length;
+	psEntry->queuedMs = TimebaseMsGet();
+	psEntry->pfnCallback = pfnCallback;
+	psEntry->psFuture = psFuture;
+	if(psFuture){
+		psFuture->done = false;
+	}
+	g_sAtStats.commands++;
+	return psEntry;
+}
+
+//*****************************************************************************
+// Send queued commands, in the order they were queued, while UART1 has room.
+static void atSendQueued(uint32_t ui32Now){
+	struct tXbeeAtEntry *psEntry;
+	uint8_t ui8FrameId;
+	bool bSent;
+	uint8_t i;
+
+	while(g_ui8AtSentSeq != g_ui8AtQueuedSeq){
+		for(i = 0; i < XBEE_AT_QUEUE_SIZE; i++){
+			if(g_psAtQueue[i].state == XBEE_AT_QUEUED && g_psAtQueue[i].seq == g_ui8AtSentSeq){
+				break;
+			}
+		}
+		psEntry = &g_psAtQueue[i];
+
+		ui8FrameId = g_psAtXbee->nextFrameId();
+		if(psEntry->remote){
+			bSent = g_psAtXbee->RemoteATCommandRequest(psEntry->addr64, XbeeAddrLookup(psEntry->addr64),
+													   psEntry->command, psEntry->parameter,
+													   psEntry->parameterLength, ui8FrameId, psEntry->options);
+		}
+		else{
+			bSent = g_psAtXbee->ATCommandRequest(psEntry->command, psEntry->parameter, psEntry->parameterLength,
+												 ui8FrameId, psEntry->queue);
+		}
+		if(!bSent){
+			return;
+		}
+		psEntry->frameId = ui8FrameId;
+		psEntry->sentMs = ui32Now;
+		psEntry->state = XBEE_AT_SENT;
+		g_ui8AtSentSeq++;
+	}
+}
+
+//*****************************************************************************
+// Count the result of a batch command, completing its node after the last one.
+static void atBatchResult(uint8_t ui8Slot, uint8_t ui8Status){
+	struct tXbeeAtBatchNode *psNode = &g_sAtBatch.inFlight[ui8Slot];
+
+	if(psNode->status == XBEE_AT_STATUS_OK){
+		psNode->status = ui8Status;
+	}
+	if(--psNode->remaining){
+		return;
+	}
+
+	psNode->inUse = false;
+	g_sAtStats.batchNodes++;
+	if(psNode->status != XBEE_AT_STATUS_OK){
+		g_sAtStats.batchFailed++;
+	}
+	if(g_sAtBatch.pfnDone){
+		g_sAtBatch.pfnDone(psNode->node, g_sAtBatch.nodes[psNode->node], psNode->status);
+	}
+}
+
+//*****************************************************************************
+// Hand the result of a command to its callback and future, and free its entry.
+static void atComplete(struct tXbeeAtEntry *psEntry, uint8_t ui8Status, const struct tXbeeRxView *psValue,
+					   uint32_t ui32Now){
+	struct tXbeeAtResult sResult;
+	uint16_t ui16Length = psValue ? XbeeViewLength(psValue) : 0;
+
+	if(ui16Length > XBEE_AT_MAX_VALUE){
+		ui16Length = XBEE_AT_MAX_VALUE;
+	}
+	sResult.command[0] = psEntry->command[0];
+	sResult.command[1] = psEntry->command[1];
+	sResult.status = ui8Status;
+	sResult.length = ui16Length;
+	if(ui16Length){
+		XbeeViewCopy(psValue, sResult.value, ui16Length);
+	}
+	if(psEntry->remote){
+		memcpy(sResult.addr64, psEntry->addr64, 8);
+	}
+	else{
+		memset(sResult.addr64, 0, 8);
+	}
+	sResult.latencyMs = ui32Now - psEntry->queuedMs;
+	psEntry->state = XBEE_AT_FREE;
+
+	if(ui8Status == XBEE_AT_STATUS_OK){
+		g_sAtStats.ok++;
+	}
+	else if(ui8Status == XBEE_AT_STATUS_TIMEOUT){
+		g_sAtStats.timeouts++;
+	}
+	else{
+		g_sAtStats.errors++;
+	}
+	if(sResult.latencyMs > g_sAtStats.maxLatencyMs){
+		g_sAtStats.maxLatencyMs = sResult.latencyMs;
+	}
+
+	// A remote module not reached may have a new network address.
+	if(psEntry->remote && (ui8Status == XBEE_AT_STATUS_TX_FAILURE || ui8Status == XBEE_AT_STATUS_TIMEOUT)){
+		XbeeAddrInvalidate(psEntry->addr64);
+	}
+
+	if(psEntry->psFuture){
+		psEntry->psFuture->result = sResult;
+		psEntry->psFuture->done = true;
+	}
+	if(psEntry->pfnCallback){
+		psEntry->pfnCallback(&sResult);
+	}
+	if(psEntry->batchSlot < XBEE_AT_BATCH_IN_FLIGHT){
+		atBatchResult(psEntry->batchSlot, ui8Status);
+	}
+}
+
+//*****************************************************************************
+// Queue the command sequence of the next batch nodes while there is a free
+// node slot and room in the queue for the whole sequence.
+static void atBatchFeed(void){
+	struct tXbeeAtBatch *psBatch = &g_sAtBatch;
+	const struct tXbeeAtBatchCommand *psCommand;
+	struct tXbeeAtEntry *psEntry;
+	uint8_t ui8Slot;
+	uint8_t i;
+
+	while(psBatch->nextNode < psBatch->nodeCount && atFreeCount() >= psBatch->commandCount){
+		for(ui8Slot = 0; ui8Slot < XBEE_AT_BATCH_IN_FLIGHT; ui8Slot++){
+			if(!psBatch->inFlight[ui8Slot].inUse){
+				break;
+			}
+		}
+		if(ui8Slot == XBEE_AT_BATCH_IN_FLIGHT){
+			return;
+		}
+
+		psBatch->inFlight[ui8Slot].inUse = true;
+		psBatch->inFlight[ui8Slot].node = psBatch->nextNode;
+		psBatch->inFlight[ui8Slot].remaining = psBatch->commandCount;
+		psBatch->inFlight[ui8Slot].status = XBEE_AT_STATUS_OK;
+		for(i = 0; i < psBatch->commandCount; i++){
+			psCommand = &psBatch->commands[i];
+			psEntry = atEntryTake(psCommand->command, psCommand->parameter, psCommand->length, 0, 0);
+			psEntry->remote = true;
+			memcpy(psEntry->addr64, psBatch->nodes[psBatch->nextNode], 8);
+			psEntry->options = (i + 1 == psBatch->commandCount) ? REMOTE_AT_APPLY_CHANGES : 0;
+			psEntry->batchSlot = ui8Slot;
+		}
+		psBatch->nextNode++;
+	}
+
+	if(psBatch->nextNode == psBatch->nodeCount){
+		for(ui8Slot = 0; ui8Slot < XBEE_AT_BATCH_IN_FLIGHT; ui8Slot++){
+			if(psBatch->inFlight[ui8Slot].inUse){
+				return;
+			}
+		}
+		psBatch->busy = false;
+	}
+}
+
+//*****************************************************************************
+// Initialize the client, with an empty queue.
+void XbeeAtInit(XbeeZB *psXbee){
+	uint8_t i;
+
+	g_psAtXbee = psXbee;
+	for(i = 0; i < XBEE_AT_QUEUE_SIZE; i++){
+		g_psAtQueue[i].state = XBEE_AT_FREE;
+	}
+	g_ui8AtQueuedSeq = 0;
+	g_ui8AtSentSeq = 0;
+	g_sAtBatch.busy = false;
+	memset(&g_sAtStats, 0, sizeof(g_sAtStats));
+}
+
+//*****************************************************************************
+// Queue the two character AT command pcCommand for the local module with
+// ui8Length bytes of parameter, none to read the current value. bQueue holds
+// the change in the module until an AC command. pfnCallback and psFuture may
+// be 0; the future is cleared here and set done with the result. Return false
+// if the queue is full or the parameter too long.
+bool XbeeAtCommand(const char *pcCommand, const uint8_t *pui8Parameter, uint8_t ui8Length, bool bQueue,
+				   tXbeeAtCallback *pfnCallback, struct tXbeeAtFuture *psFuture){
+	struct tXbeeAtEntry *psEntry = atEntryTake(pcCommand, pui8Parameter, ui8Length, pfnCallback, psFuture);
+
+	if(!psEntry){
+		return false;
+	}
+	psEntry->queue = bQueue;
+
+	atSendQueued(TimebaseMsGet());
+	return true;
+}
+
+//*****************************************************************************
+// Queue a query of the current value of the two character AT command pcCommand.
+bool XbeeAtQuery(const char *pcCommand, tXbeeAtCallback *pfnCallback, struct tXbeeAtFuture *psFuture){
+	return XbeeAtCommand(pcCommand, 0, 0, false, pfnCallback, psFuture);
+}
+
+//*****************************************************************************
+// Queue the two character AT command pcCommand for the remote module with 64
+// bit address pui8Addr64. Unless bApply is true the remote module holds the
+// change until a later command applies it. Otherwise as XbeeAtCommand().
+bool XbeeAtRemoteCommand(const uint8_t *pui8Addr64, const char *pcCommand, const uint8_t *pui8Parameter,
+						 uint8_t ui8Length, bool bApply, tXbeeAtCallback *pfnCallback,
+						 struct tXbeeAtFuture *psFuture){
+	struct tXbeeAtEntry *psEntry = atEntryTake(pcCommand, pui8Parameter, ui8Length, pfnCallback, psFuture);
+
+	if(!psEntry){
+		return false;
+	}
+	psEntry->remote = true;
+	memcpy(psEntry->addr64, pui8Addr64, 8);
+	psEntry->options = bApply ? REMOTE_AT_APPLY_CHANGES : 0;
+
+	atSendQueued(TimebaseMsGet());
+	return true;
+}
+
+//*****************************************************************************
+// Send the ui8CommandCount commands of psCommands to each of the
+// ui16NodeCount remote modules of ppui8Nodes. The last command of each node
+// applies the changes, so a write sequence usually ends with WR or AC.
+// pfnDone, which may be 0, is called once per node. The lists must not
+// change until XbeeAtBatchBusy() returns false. Return false if a batch is
+// running or the sequence does not fit.
+bool XbeeAtBatchStart(const uint8_t (*ppui8Nodes)[8], uint16_t ui16NodeCount,
+					  const struct tXbeeAtBatchCommand *psCommands, uint8_t ui8CommandCount,
+					  tXbeeAtBatchDone *pfnDone){
+	uint8_t i;
+
+	if(g_sAtBatch.busy || ui8CommandCount == 0 || ui8CommandCount > XBEE_AT_BATCH_MAX_COMMANDS){
+		return false;
+	}
+	for(i = 0; i < ui8CommandCount; i++){
+		if(psCommands[i].length > XBEE_AT_MAX_PARAMETER){
+			return false;
+		}
+	}
+
+	g_sAtBatch.nodes = ppui8Nodes;
+	g_sAtBatch.nodeCount = ui16NodeCount;
+	g_sAtBatch.nextNode = 0;
+	g_sAtBatch.commands = psCommands;
+	g_sAtBatch.commandCount = ui8CommandCount;
+	g_sAtBatch.pfnDone = pfnDone;
+	for(i = 0; i < XBEE_AT_BATCH_IN_FLIGHT; i++){
+		g_sAtBatch.inFlight[i].inUse = false;
+	}
+	g_sAtBatch.busy = true;
+
+	atBatchFeed();
+	atSendQueued(TimebaseMsGet());
+	return true;
+}
+
+//*****************************************************************************
+// Check if a batch is running.
+bool XbeeAtBatchBusy(void){
+	return g_sAtBatch.busy;
+}
+
+//*****************************************************************************
+// AT Command Response handler, to be registered with XbeeFrameHandlerSet().
+// Responses to commands no longer waiting, such as late ones, are ignored.
+void XbeeAtResponseHandler(const struct tXbeeApiFrame *psFrame){
+	const struct tXbeeAtResponse *psResponse = &psFrame->u.atResponse;
+	struct tXbeeAtEntry *psEntry;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_AT_QUEUE_SIZE; i++){
+		psEntry = &g_psAtQueue[i];
+		if(psEntry->state == XBEE_AT_SENT && !psEntry->remote && psEntry->frameId == psResponse->frameId &&
+		   psEntry->command[0] == psResponse->command[0] && psEntry->command[1] == psResponse->command[1]){
+			atComplete(psEntry, psResponse->status, &psResponse->value, TimebaseMsGet());
+			return;
+		}
+	}
+}
+
+//*****************************************************************************
+// Remote Command Response handler, to be registered with XbeeFrameHandlerSet().
+// The network address of the answering module is learned.
+void XbeeAtRemoteResponseHandler(const struct tXbeeApiFrame *psFrame){
+	const struct tXbeeRemoteAtResponse *psResponse = &psFrame->u.remoteAtResponse;
+	struct tXbeeAtEntry *psEntry;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_AT_QUEUE_SIZE; i++){
+		psEntry = &g_psAtQueue[i];
+		if(psEntry->state == XBEE_AT_SENT && psEntry->remote && psEntry->frameId == psResponse->frameId &&
+		   psEntry->command[0] == psResponse->command[0] && psEntry->command[1] == psResponse->command[1] &&
+		   memcmp(psEntry->addr64, psResponse->srcAddr64, 8) == 0){
+			if(psResponse->status != XBEE_AT_STATUS_TX_FAILURE){
+				XbeeAddrLearn(psResponse->srcAddr64, psResponse->srcAddr16);
+			}
+			atComplete(psEntry, psResponse->status, &psResponse->value, TimebaseMsGet());
+			return;
+		}
+	}
+}
+
+//*****************************************************************************
+// Send commands UART1 had no room for, feed the running batch and time out
+// commands left without response. Call it periodically from the main loop.
+void XbeeAtProcess(uint32_t ui32Now){
+	struct tXbeeAtEntry *psEntry;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_AT_QUEUE_SIZE; i++){
+		psEntry = &g_psAtQueue[i];
+		if(psEntry->state == XBEE_AT_SENT &&
+		   TimebaseDeadlineReached(ui32Now, psEntry->sentMs +
+								   (psEntry->remote ? XBEE_AT_REMOTE_TIMEOUT_MS : XBEE_AT_TIMEOUT_MS))){
+			atComplete(psEntry, XBEE_AT_STATUS_TIMEOUT, 0, ui32Now);
+		}
+	}
+
+	if(g_sAtBatch.busy){
+		atBatchFeed();
+	}
+	atSendQueued(ui32Now);
+}
+
+//*****************************************************************************
+// Number of commands queued or waiting for their response.
+uint8_t XbeeAtPendingGet(void){
+	return XBEE_AT_QUEUE_SIZE - atFreeCount();
+}
+
+//*****************************************************************************
+// Get client statistics.
+void XbeeAtStatsGet(struct tXbeeAtStats *psStats){
+	*psStats = g_sAtStats;
+}
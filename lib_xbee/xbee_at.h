@@ -0,0 +1,160 @@
+/*
+ * xbee_at.h - Non blocking local and remote AT command client.
+ *
+ * Commands are queued and sent in order, each with its own frame id, as
+ * UART1 takes them, so several can be waiting for their AT Command Response
+ * or Remote Command Response at once. The result of each command is handed to
+ * its callback, stored in its future, or both. Commands without response
+ * within their timeout complete with XBEE_AT_STATUS_TIMEOUT.
+ *
+ * A batch applies the same command sequence to a list of remote nodes. The
+ * sequence of a node is sent back to back, changes held until its last
+ * command applies them, and up to XBEE_AT_BATCH_IN_FLIGHT nodes are worked on
+ * at once, so a rollout takes about one round trip per
+ * XBEE_AT_BATCH_IN_FLIGHT nodes instead of one per command.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef XBEE_AT_H_
+#define XBEE_AT_H_
+
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+
+//*****************************************************************************
+// Client parameters.
+#define XBEE_AT_QUEUE_SIZE				   16		// Commands queued or waiting.
+#define XBEE_AT_MAX_PARAMETER			   20		// Longest parameter, NI takes 20 characters.
+#define XBEE_AT_MAX_VALUE				   20		// Longest response value kept.
+#define XBEE_AT_TIMEOUT_MS				 1000		// Time to wait for a local response.
+#define XBEE_AT_REMOTE_TIMEOUT_MS		 5000		// Time to wait for a remote response.
+#define XBEE_AT_BATCH_MAX_COMMANDS		    4		// Commands sent to each node of a batch.
+#define XBEE_AT_BATCH_IN_FLIGHT			    4		// Nodes of a batch worked on at once.
+
+//*****************************************************************************
+// AT Command Response and Remote Command Response status values, and the
+// status of commands left without response.
+#define XBEE_AT_STATUS_OK				 0x00
+#define XBEE_AT_STATUS_ERROR			 0x01
+#define XBEE_AT_STATUS_INVALID_COMMAND	 0x02
+#define XBEE_AT_STATUS_INVALID_PARAMETER 0x03
+#define XBEE_AT_STATUS_TX_FAILURE		 0x04		// Remote module not reached.
+#define XBEE_AT_STATUS_TIMEOUT			 0xFF
+
+//*****************************************************************************
+// Result of a command. Values longer than XBEE_AT_MAX_VALUE are cut.
+struct tXbeeAtResult{
+	uint8_t command[2];
+	uint8_t status;
+	uint8_t length;
+	uint8_t value[XBEE_AT_MAX_VALUE];		// Numeric values are msb first.
+	uint8_t addr64[8];						// Remote module, zero for local commands.
+	uint32_t latencyMs;						// From command queued to result.
+};
+
+//*****************************************************************************
+// Future owned by the caller, polled for the result. done is set last.
+struct tXbeeAtFuture{
+	volatile bool done;
+	struct tXbeeAtResult result;
+};
+
+//*****************************************************************************
+// Function called with the result of a command.
+typedef void (tXbeeAtCallback)(const struct tXbeeAtResult *psResult);
+
+//*****************************************************************************
+// Command queue entry states.
+#define XBEE_AT_FREE					    0
+#define XBEE_AT_QUEUED					    1		// Waiting for room in UART1.
+#define XBEE_AT_SENT					    2		// Waiting for the response.
+
+//*****************************************************************************
+// Queued command. Entries are sent in seq order and freed in any order.
+struct tXbeeAtEntry{
+	uint8_t state;
+	uint8_t seq;
+	bool queue;								// Local: AT Command Queue Parameter instead of AT Command.
+	bool remote;
+	uint8_t addr64[8];						// Remote module.
+	uint8_t options;						// Remote command options.
+	uint8_t batchSlot;						// Batch node slot, XBEE_AT_BATCH_IN_FLIGHT if none.
+	uint8_t frameId;
+	uint8_t command[2];
+	uint8_t parameterLength;
+	uint8_t parameter[XBEE_AT_MAX_PARAMETER];
+	uint32_t queuedMs;
+	uint32_t sentMs;
+	tXbeeAtCallback *pfnCallback;
+	struct tXbeeAtFuture *psFuture;
+};
+
+//*****************************************************************************
+// Command of a batch sequence.
+struct tXbeeAtBatchCommand{
+	const char *command;					// Two characters.
+	const uint8_t *parameter;
+	uint8_t length;
+};
+
+//*****************************************************************************
+// Function called once per node of a batch, with XBEE_AT_STATUS_OK or the
+// status of the first command of the node that failed.
+typedef void (tXbeeAtBatchDone)(uint16_t ui16Node, const uint8_t *pui8Addr64, uint8_t ui8Status);
+
+//*****************************************************************************
+// Batch node being worked on.
+struct tXbeeAtBatchNode{
+	bool inUse;
+	uint16_t node;							// Index in the node list.
+	uint8_t remaining;						// Commands without result.
+	uint8_t status;
+};
+
+//*****************************************************************************
+// Batch state. The node and command lists stay in the caller's memory.
+struct tXbeeAtBatch{
+	bool busy;
+	const uint8_t (*nodes)[8];
+	uint16_t nodeCount;
+	uint16_t nextNode;						// Next node to queue commands for.
+	const struct tXbeeAtBatchCommand *commands;
+	uint8_t commandCount;
+	tXbeeAtBatchDone *pfnDone;
+	struct tXbeeAtBatchNode inFlight[XBEE_AT_BATCH_IN_FLIGHT];
+};
+
+//*****************************************************************************
+// Client statistics.
+struct tXbeeAtStats{
+	uint32_t commands;
+	uint32_t ok;
+	uint32_t errors;						// Completed with an error status.
+	uint32_t timeouts;
+	uint32_t maxLatencyMs;
+	uint32_t batchNodes;					// Batch nodes completed.
+	uint32_t batchFailed;					// Batch nodes with a failed command.
+};
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern void XbeeAtInit(XbeeZB *psXbee);
+extern bool XbeeAtCommand(const char *pcCommand, const uint8_t *pui8Parameter, uint8_t ui8Length, bool bQueue,
+						  tXbeeAtCallback *pfnCallback, struct tXbeeAtFuture *psFuture);
+extern bool XbeeAtQuery(const char *pcCommand, tXbeeAtCallback *pfnCallback, struct tXbeeAtFuture *psFuture);
+extern bool XbeeAtRemoteCommand(const uint8_t *pui8Addr64, const char *pcCommand, const uint8_t *pui8Parameter,
+								uint8_t ui8Length, bool bApply, tXbeeAtCallback *pfnCallback,
+								struct tXbeeAtFuture *psFuture);
+extern bool XbeeAtBatchStart(const uint8_t (*ppui8Nodes)[8], uint16_t ui16NodeCount,
+							 const struct tXbeeAtBatchCommand *psCommands, uint8_t ui8CommandCount,
+							 tXbeeAtBatchDone *pfnDone);
+extern bool XbeeAtBatchBusy(void);
+extern void XbeeAtResponseHandler(const struct tXbeeApiFrame *psFrame);
+extern void XbeeAtRemoteResponseHandler(const struct tXbeeApiFrame *psFrame);
+extern void XbeeAtProcess(uint32_t ui32Now);
+extern uint8_t XbeeAtPendingGet(void);
+extern void XbeeAtStatsGet(struct tXbeeAtStats *psStats);
+
+#endif /* XBEE_AT_H_ */
@@ -6,11 +6,28 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "driverlib/gpio.h"
 #include "driverlib/rom.h"
+#include "driverlib/sysctl.h"
 #include "inc/hw_memmap.h"
+#include "lib_utils/ustdlib.h"
+#include "lib_utils/uartstdio.h"
+#include "lib_utils/timebase.h"
 #include "lib_xbee/xbee_data_parser.h"
 #include "lib_xbee/xbee_commands.h"
+#include "lib_xbee/sensor_report.h"
+#include "lib_xbee/xbee_fragment.h"
+#include "configperiph.h"
+
+//*****************************************************************************
+// Help text and other replies sent to the coordinator. Longer than one
+// payload, so they are sent in fragments straight from this buffer.
+#define REPLY_TEXT_SIZE			384
+static uint8_t g_pui8ReplyText[REPLY_TEXT_SIZE];
+
+// Time the UART counters were last cleared, for the interrupt load.
+static uint32_t g_ui32UartStatsStartMs;
 
 //*****************************************************************************
 // Table of valid command strings, callback functions and help messages.  This
@@ -21,14 +38,42 @@ tCmdLineEntry g_psCmdTable[] = {
     {"on", CMD_set_on, " : Turn on"},
     {"off", CMD_set_off, " : Turn off"},
     {"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", CMD_set_test, " : Test data payload"},
+    {"fmt", CMD_set_format, " : Report format, ascii, bin or batch"},
+    {"rel", CMD_set_reliable, " : Acknowledged reports, on or off"},
+    {"uart", CMD_uart_stats, " : Xbee UART receive counters, clear to reset"},
+    {0, 0, 0}
 };
 
 // argc is the number of arguments.
 // argv is an array with the function's string parameters.
 
 //*****************************************************************************
-// Print the help strings for all commands.
+// Send the help strings for all commands to the coordinator, one command per line.
 int8_t CMD_help(uint8_t argc, uint8_t **argv) {
+    tCmdLineEntry *psEntry;
+    uint16_t ui16Length = 0;
+    uint16_t ui16Cmd;
+    uint16_t ui16Help;
+
+    // The previous reply may still be being sent from the buffer.
+    if(XbeeFragmentTxBusy()){
+        return 0;
+    }
+
+    for(psEntry = g_psCmdTable; psEntry->pcCmd; psEntry++){
+        ui16Cmd = ustrlen((const char *)psEntry->pcCmd);
+        ui16Help = ustrlen((const char *)psEntry->pcHelp);
+        if(ui16Length + ui16Cmd + ui16Help + 1 > REPLY_TEXT_SIZE){
+            break;
+        }
+        memcpy(&g_pui8ReplyText[ui16Length], psEntry->pcCmd, ui16Cmd);
+        ui16Length += ui16Cmd;
+        memcpy(&g_pui8ReplyText[ui16Length], psEntry->pcHelp, ui16Help);
+        ui16Length += ui16Help;
+        g_pui8ReplyText[ui16Length++] = '\n';
+    }
+
+    XbeeFragmentSend(0, g_pui8ReplyText, ui16Length);
     return 0;
 }
 
@@ -57,3 +102,87 @@ int8_t CMD_set_test(uint8_t argc, uint8_t **argv) {
 	}
 	return 0;
 }
+
+//*****************************************************************************
+// Select the sensors report payload format: "fmt ascii", "fmt bin" or "fmt batch".
+int8_t CMD_set_format(uint8_t argc, uint8_t **argv) {
+	if(argc < 2){
+		return CMDLINE_TOO_FEW_ARGS;
+	}
+	if(!ustrcmp((char *)argv[1], "ascii")){
+		SensorReportFormatSet(REPORT_FORMAT_ASCII);
+	}
+	else if(!ustrcmp((char *)argv[1], "bin")){
+		SensorReportFormatSet(REPORT_FORMAT_BINARY);
+	}
+	else if(!ustrcmp((char *)argv[1], "batch")){
+		SensorReportFormatSet(REPORT_FORMAT_BATCH);
+	}
+	else{
+		return CMDLINE_INVALID_ARG;
+	}
+	return 0;
+}
+
+//*****************************************************************************
+// Select whether sensors reports wait for the gateway acknowledge: "rel on" or "rel off".
+int8_t CMD_set_reliable(uint8_t argc, uint8_t **argv) {
+	if(argc < 2){
+		return CMDLINE_TOO_FEW_ARGS;
+	}
+	if(!ustrcmp((char *)argv[1], "on")){
+		SensorReportReliableSet(true);
+	}
+	else if(!ustrcmp((char *)argv[1], "off")){
+		SensorReportReliableSet(false);
+	}
+	else{
+		return CMDLINE_INVALID_ARG;
+	}
+	return 0;
+}
+
+//*****************************************************************************
+// Send the xbee UART receive counters to the coordinator: "uart", or "uart clear"
+// to reset them after sending. The interrupt load is the share of processor time
+// spent in the UART interrupt handler since the counters were cleared, in tenths
+// of percent, followed by its cycles per received byte. The last line counts the
+// console bytes dropped with the UART0 transmit buffer full.
+int8_t CMD_uart_stats(uint8_t argc, uint8_t **argv) {
+	tUARTStdioStats sStats;
+	tUARTStdioStats sConsoleStats;
+	uint64_t ui64Cycles;
+	uint32_t ui32Load = 0;
+	uint32_t ui32ByteCycles = 0;
+	uint16_t ui16Length;
+
+	if(XbeeFragmentTxBusy()){
+		return 0;
+	}
+
+	UARTStdioStatsGet(g_psUART1Stdio, &sStats);
+	UARTStdioStatsGet(&g_sUART0Stdio, &sConsoleStats);
+	ui64Cycles = (uint64_t)(TimebaseMsGet() - g_ui32UartStatsStartMs) * (ROM_SysCtlClockGet() / 1000);
+	if(ui64Cycles){
+		ui32Load = (uint32_t)(sStats.ui64InterruptCycles * 1000 / ui64Cycles);
+	}
+	if(sStats.ui32RxBytes){
+		ui32ByteCycles = (uint32_t)(sStats.ui64InterruptCycles / sStats.ui32RxBytes);
+	}
+	ui16Length = usprintf((char *)g_pui8ReplyText,
+						  "rx %u overrun %u error %u dropped %u held %u max %u\n"
+						  "irq %u blocks %u load %u.%u%% cycles/byte %u\n"
+						  "console dropped %u\n",
+						  sStats.ui32RxBytes, sStats.ui32RxOverruns, sStats.ui32RxErrors,
+						  sStats.ui32RxDropped, sStats.ui32RxHolds, sStats.ui32RxMaxUsed,
+						  sStats.ui32Interrupts, sStats.ui32RxDmaBlocks, ui32Load / 10, ui32Load % 10,
+						  ui32ByteCycles, sConsoleStats.ui32TxDropped);
+	XbeeFragmentSend(0, g_pui8ReplyText, ui16Length);
+
+	if(argc > 1 && !ustrcmp((char *)argv[1], "clear")){
+		UARTStdioStatsClear(g_psUART1Stdio);
+		UARTStdioStatsClear(&g_sUART0Stdio);
+		g_ui32UartStatsStartMs = TimebaseMsGet();
+	}
+	return 0;
+}
@@ -10,7 +10,7 @@
 //*****************************************************************************
 // Defines for the command line argument parser provided as a standard part of TivaWare.
 // Xbee application uses the command parser to extend functionality to the serial port.
-#define CMDLINE_MAX_ARGS 1
+#define CMDLINE_MAX_ARGS 2
 
 //*****************************************************************************
 // Declaration for the callback functions that will implement the command line
@@ -20,5 +20,8 @@ extern int8_t CMD_help(uint8_t argc, uint8_t **argv);
 extern int8_t CMD_set_on(uint8_t argc, uint8_t **argv);
 extern int8_t CMD_set_off(uint8_t argc, uint8_t **argv);
 extern int8_t CMD_set_test(uint8_t argc, uint8_t **argv);
+extern int8_t CMD_set_format(uint8_t argc, uint8_t **argv);
+extern int8_t CMD_set_reliable(uint8_t argc, uint8_t **argv);
+extern int8_t CMD_uart_stats(uint8_t argc, uint8_t **argv);
 
 #endif //__XBEE_COMMANDS_H__
@@ -0,0 +1,255 @@
+/*
+ * xbee_fragment.cpp - Send and receive messages larger than one ZB Transmit
+ * 					   Request payload as numbered fragments.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lib_utils/timebase.h"
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_addr_table.h"
+#include "lib_xbee/xbee_source_route.h"
+#include "lib_xbee/xbee_fragment.h"
+
+#if XBEE_FRAGMENT_HEADER_SIZE + XBEE_FRAGMENT_DATA_SIZE > ZB_MAX_RF_PAYLOAD
+#error "Xbee fragment does not fit in a ZB Transmit Request payload"
+#endif
+
+static XbeeZB *g_psFragmentXbee;
+static tXbeeFragmentDeliver *g_pfnFragmentDeliver;
+static struct tXbeeFragmentRx g_psFragmentRx[XBEE_FRAGMENT_RX_SLOTS];
+static struct tXbeeFragmentTx g_sFragmentTx;
+static struct tXbeeFragmentStats g_sFragmentStats;
+
+//*****************************************************************************
+// Initialize fragmentation. pfnDeliver is called with each message reassembled.
+void XbeeFragmentInit(XbeeZB *psXbee, tXbeeFragmentDeliver *pfnDeliver){
+	uint8_t i;
+
+	g_psFragmentXbee = psXbee;
+	g_pfnFragmentDeliver = pfnDeliver;
+	for(i = 0; i < XBEE_FRAGMENT_RX_SLOTS; i++){
+		g_psFragmentRx[i].inUse = false;
+	}
+	g_sFragmentTx.busy = false;
+	g_sFragmentTx.msgId = 0;
+	memset(&g_sFragmentStats, 0, sizeof(g_sFragmentStats));
+}
+
+//*****************************************************************************
+// Start sending ui16Length bytes of pui8Data to the node with 64 bit address
+// pui8DstAddr64, or to the coordinator if it is 0. The data must not change
+// until XbeeFragmentTxBusy() returns false. Fragments are sent from
+// XbeeFragmentProcess(). Return false if a message is still being sent or the
+// message is too long.
+bool XbeeFragmentSend(const uint8_t *pui8DstAddr64, const uint8_t *pui8Data, uint16_t ui16Length){
+	if(g_sFragmentTx.busy || ui16Length == 0 || ui16Length > XBEE_FRAGMENT_MAX_MESSAGE){
+		return false;
+	}
+
+	if(!pui8DstAddr64){
+		pui8DstAddr64 = g_pui8ZBCoordinatorAddr64;
+	}
+	g_psFragmentXbee->buildTxHeader(&g_sFragmentTx.txHeader, pui8DstAddr64, XbeeAddrLookup(pui8DstAddr64),
+									0x00, 0x00);
+	memcpy(g_sFragmentTx.addr64, pui8DstAddr64, 8);
+	g_sFragmentTx.data = pui8Data;
+	g_sFragmentTx.length = ui16Length;
+	g_sFragmentTx.msgId++;
+	g_sFragmentTx.next = 0;
+	g_sFragmentTx.count = (ui16Length + XBEE_FRAGMENT_DATA_SIZE - 1) / XBEE_FRAGMENT_DATA_SIZE;
+	g_sFragmentTx.busy = true;
+	g_sFragmentStats.txMessages++;
+	return true;
+}
+
+//*****************************************************************************
+// Check if a message is still being sent.
+bool XbeeFragmentTxBusy(void){
+	return g_sFragmentTx.busy;
+}
+
+//*****************************************************************************
+// Send fragments of the current message until UART1 has no room left. A cached
+// source route to the destination goes to the module ahead of the first one.
+static void fragmentTxProcess(void){
+	struct tXbeeFragmentTx *psTx = &g_sFragmentTx;
+	struct tXbeeTxSegment psSegments[2];
+	uint16_t ui16Offset;
+	uint16_t ui16Length;
+
+	if(psTx->busy && psTx->next == 0 && !XbeeSourceRoutePrepare(psTx->addr64)){
+		return;
+	}
+
+	while(psTx->busy){
+		ui16Offset = (uint16_t)psTx->next * XBEE_FRAGMENT_DATA_SIZE;
+		ui16Length = psTx->length - ui16Offset;
+		if(ui16Length > XBEE_FRAGMENT_DATA_SIZE){
+			ui16Length = XBEE_FRAGMENT_DATA_SIZE;
+		}
+
+		psTx->header[0] = XBEE_FRAGMENT_TAG;
+		psTx->header[1] = psTx->msgId;
+		psTx->header[2] = psTx->next;
+		psTx->header[3] = psTx->count;
+		psSegments[0].data = psTx->header;
+		psSegments[0].length = XBEE_FRAGMENT_HEADER_SIZE;
+		psSegments[1].data = psTx->data + ui16Offset;
+		psSegments[1].length = ui16Length;
+		if(!g_psFragmentXbee->ZBTransmitRequest(&psTx->txHeader, psSegments, 2, 0)){
+			return;
+		}
+
+		g_sFragmentStats.txFragments++;
+		psTx->next++;
+		if(psTx->next == psTx->count){
+			psTx->busy = false;
+		}
+	}
+}
+
+//*****************************************************************************
+// Empty a reassembly slot for a new message.
+static void fragmentRxRestart(struct tXbeeFragmentRx *psSlot){
+	psSlot->complete = false;
+	psSlot->count = 0;
+	psSlot->received = 0;
+	psSlot->length = 0;
+}
+
+//*****************************************************************************
+// Find the reassembly slot of message ui8MsgId from pui8Addr64, or take one
+// for it. A free slot is preferred, then the slot of a delivered message,
+// otherwise the slot closest to its timeout is dropped.
+static struct tXbeeFragmentRx *fragmentRxSlot(const uint8_t *pui8Addr64, uint8_t ui8MsgId){
+	struct tXbeeFragmentRx *psSlot = 0;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_FRAGMENT_RX_SLOTS; i++){
+		if(g_psFragmentRx[i].inUse && g_psFragmentRx[i].msgId == ui8MsgId &&
+		   memcmp(g_psFragmentRx[i].addr64, pui8Addr64, 8) == 0){
+			return &g_psFragmentRx[i];
+		}
+	}
+
+	for(i = 0; i < XBEE_FRAGMENT_RX_SLOTS; i++){
+		if(!g_psFragmentRx[i].inUse){
+			psSlot = &g_psFragmentRx[i];
+			break;
+		}
+		if(!psSlot || (g_psFragmentRx[i].complete && !psSlot->complete) ||
+		   (g_psFragmentRx[i].complete == psSlot->complete &&
+			(int32_t)(g_psFragmentRx[i].deadlineMs - psSlot->deadlineMs) < 0)){
+			psSlot = &g_psFragmentRx[i];
+		}
+	}
+	if(psSlot->inUse && !psSlot->complete){
+		g_sFragmentStats.rxTimeouts++;
+	}
+
+	psSlot->inUse = true;
+	memcpy(psSlot->addr64, pui8Addr64, 8);
+	psSlot->msgId = ui8MsgId;
+	fragmentRxRestart(psSlot);
+	return psSlot;
+}
+
+//*****************************************************************************
+// Handle a received ZB Receive Packet. Fragments are stored in the reassembly
+// buffer of their message, and the message is passed to the deliver function
+// once all its fragments arrived. Return false if the payload is not a
+// fragment.
+bool XbeeFragmentReceive(const struct tXbeeRxPacket *psPacket, uint32_t ui32Now){
+	const struct tXbeeRxView *psData = &psPacket->data;
+	struct tXbeeFragmentRx *psSlot;
+	struct tXbeeRxView sFragment;
+	uint16_t ui16Length = XbeeViewLength(psData);
+	uint16_t ui16Offset;
+	uint8_t ui8Index;
+	uint8_t ui8Count;
+
+	if(ui16Length < XBEE_FRAGMENT_HEADER_SIZE || XbeeViewByte(psData, 0) != XBEE_FRAGMENT_TAG){
+		return false;
+	}
+	ui8Index = XbeeViewByte(psData, 2);
+	ui8Count = XbeeViewByte(psData, 3);
+	ui16Length -= XBEE_FRAGMENT_HEADER_SIZE;
+	ui16Offset = (uint16_t)ui8Index * XBEE_FRAGMENT_DATA_SIZE;
+	g_sFragmentStats.rxFragments++;
+
+	// Every fragment but the last is full, and all must fit in the buffer.
+	if(ui8Count == 0 || ui8Count > XBEE_FRAGMENT_MAX_COUNT || ui8Index >= ui8Count ||
+	   (ui8Index + 1 < ui8Count && ui16Length != XBEE_FRAGMENT_DATA_SIZE) ||
+	   ui16Length > XBEE_FRAGMENT_DATA_SIZE || ui16Offset + ui16Length > XBEE_FRAGMENT_RX_BUFFER_SIZE){
+		g_sFragmentStats.rxInvalid++;
+		return true;
+	}
+
+	psSlot = fragmentRxSlot(psPacket->srcAddr64, XbeeViewByte(psData, 1));
+	if(psSlot->complete){
+		// Late duplicates of a delivered message are dropped, but its first fragment starts a new
+		// message: the sender rebooted and reused the id.
+		if(ui8Index != 0){
+			return true;
+		}
+		fragmentRxRestart(psSlot);
+	}
+	if(psSlot->count == 0){
+		psSlot->count = ui8Count;
+	}
+	else if(psSlot->count != ui8Count){
+		g_sFragmentStats.rxInvalid++;
+		return true;
+	}
+	psSlot->deadlineMs = ui32Now + XBEE_FRAGMENT_TIMEOUT_MS;
+
+	// Duplicated fragments are ignored.
+	if(psSlot->received & (1 << ui8Index)){
+		return true;
+	}
+	XbeeViewSlice(psData, XBEE_FRAGMENT_HEADER_SIZE, ui16Length, &sFragment);
+	XbeeViewCopy(&sFragment, &psSlot->data[ui16Offset], ui16Length);
+	psSlot->received |= 1 << ui8Index;
+	if(ui8Index + 1 == ui8Count){
+		psSlot->length = ui16Offset + ui16Length;
+	}
+
+	if(psSlot->received == (uint16_t)((1UL << ui8Count) - 1)){
+		psSlot->complete = true;
+		g_sFragmentStats.rxMessages++;
+		if(g_pfnFragmentDeliver){
+			g_pfnFragmentDeliver(psSlot->addr64, psSlot->data, psSlot->length);
+		}
+	}
+	return true;
+}
+
+//*****************************************************************************
+// Send pending fragments and drop messages whose fragments stopped arriving.
+// Call it periodically from the main loop.
+void XbeeFragmentProcess(uint32_t ui32Now){
+	uint8_t i;
+
+	fragmentTxProcess();
+
+	for(i = 0; i < XBEE_FRAGMENT_RX_SLOTS; i++){
+		if(g_psFragmentRx[i].inUse && TimebaseDeadlineReached(ui32Now, g_psFragmentRx[i].deadlineMs)){
+			g_psFragmentRx[i].inUse = false;
+			if(!g_psFragmentRx[i].complete){
+				g_sFragmentStats.rxTimeouts++;
+			}
+		}
+	}
+}
+
+//*****************************************************************************
+// Get fragmentation statistics.
+void XbeeFragmentStatsGet(struct tXbeeFragmentStats *psStats){
+	*psStats = g_sFragmentStats;
+}
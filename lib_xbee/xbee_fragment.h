@@ -0,0 +1,118 @@
+/*
+ * xbee_fragment.h - Send and receive messages larger than one ZB Transmit
+ * 					 Request payload as numbered fragments.
+ *
+ * Fragments of a message are sent back to back as fast as UART1 takes them.
+ * Received fragments are reassembled in bounded buffers, one per message being
+ * received, which are dropped when no fragment arrives for
+ * XBEE_FRAGMENT_TIMEOUT_MS.
+ *
+ * Delivery is best effort. Fragments are not acknowledged, so a message with a
+ * lost fragment is dropped at the timeout and must be sent again by the
+ * application. The reliable layer, see xbee_reliable.h, buffers single payloads
+ * only and is not used for fragments. A message is identified by its sender and
+ * message id. Ids restart after the sender reboots, so fragment 0 of a message
+ * id already delivered starts a new message.
+ *
+ * Fragment payload layout:
+ *   0      XBEE_FRAGMENT_TAG.
+ *   1      Message id, the same for all fragments of a message.
+ *   2      Fragment index, from 0.
+ *   3      Number of fragments of the message.
+ *   4..    Data. Every fragment but the last carries XBEE_FRAGMENT_DATA_SIZE
+ *          bytes.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef XBEE_FRAGMENT_H_
+#define XBEE_FRAGMENT_H_
+
+//*****************************************************************************
+// Fragment payload layout. The fragment fills a ZB_MAX_RF_PAYLOAD payload.
+#define XBEE_FRAGMENT_TAG				 0xF0
+#define XBEE_FRAGMENT_HEADER_SIZE		    4
+#define XBEE_FRAGMENT_DATA_SIZE			   80
+#define XBEE_FRAGMENT_MAX_COUNT			   16		// Fragments of a message.
+#define XBEE_FRAGMENT_MAX_MESSAGE		 (XBEE_FRAGMENT_MAX_COUNT * XBEE_FRAGMENT_DATA_SIZE)
+
+//*****************************************************************************
+// Reassembly parameters.
+#define XBEE_FRAGMENT_RX_SLOTS			    2		// Messages reassembled at once.
+#define XBEE_FRAGMENT_RX_BUFFER_SIZE	  480		// Longest message received.
+#define XBEE_FRAGMENT_TIMEOUT_MS		 2000		// Time allowed between fragments.
+
+//*****************************************************************************
+// If building with a C++ compiler, make the send API have a C binding so the
+// command handlers can use it.
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern bool XbeeFragmentSend(const uint8_t *pui8DstAddr64, const uint8_t *pui8Data, uint16_t ui16Length);
+extern bool XbeeFragmentTxBusy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+
+//*****************************************************************************
+// Message being reassembled. Bit n of received is set once fragment n arrived.
+// A delivered message keeps its slot until the timeout, so late duplicated
+// fragments other than fragment 0 do not start it again.
+struct tXbeeFragmentRx{
+	bool inUse;
+	bool complete;
+	uint8_t addr64[8];
+	uint8_t msgId;
+	uint8_t count;
+	uint16_t received;
+	uint16_t length;						// Known once the last fragment arrived.
+	uint32_t deadlineMs;
+	uint8_t data[XBEE_FRAGMENT_RX_BUFFER_SIZE];
+};
+
+//*****************************************************************************
+// Message being sent. The data stays in the caller's buffer until sent.
+struct tXbeeFragmentTx{
+	bool busy;
+	uint8_t addr64[8];
+	struct tXbeeTxHeader txHeader;			// ZB Transmit Request header to addr64.
+	const uint8_t *data;
+	uint16_t length;
+	uint8_t msgId;
+	uint8_t next;							// Index of the next fragment to send.
+	uint8_t count;
+	uint8_t header[XBEE_FRAGMENT_HEADER_SIZE];	// Sent ahead of the data, which is not copied.
+};
+
+//*****************************************************************************
+// Fragmentation statistics.
+struct tXbeeFragmentStats{
+	uint32_t txMessages;
+	uint32_t txFragments;
+	uint32_t rxMessages;
+	uint32_t rxFragments;
+	uint32_t rxTimeouts;					// Messages dropped incomplete.
+	uint32_t rxInvalid;						// Fragments not fitting the reassembly buffer.
+};
+
+//*****************************************************************************
+// Function called with each message reassembled.
+typedef void (tXbeeFragmentDeliver)(const uint8_t *pui8SrcAddr64, const uint8_t *pui8Data, uint16_t ui16Length);
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern void XbeeFragmentInit(XbeeZB *psXbee, tXbeeFragmentDeliver *pfnDeliver);
+extern bool XbeeFragmentReceive(const struct tXbeeRxPacket *psPacket, uint32_t ui32Now);
+extern void XbeeFragmentProcess(uint32_t ui32Now);
+extern void XbeeFragmentStatsGet(struct tXbeeFragmentStats *psStats);
+#endif
+
+#endif /* XBEE_FRAGMENT_H_ */
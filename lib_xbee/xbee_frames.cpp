@@ -0,0 +1,386 @@
+/*
+ * xbee_frames.cpp - Decode received API frames into typed structures and route
+ * 					 them to handlers registered per frame type.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+
+//*****************************************************************************
+// Frame decoder type. Return false if the frame data is too short for the
+// frame type.
+typedef bool (tXbeeFrameDecoder)(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+
+//*****************************************************************************
+// Structure for an entry in the frame type table.
+struct tXbeeFrameEntry{
+	uint8_t frameType;
+	tXbeeFrameDecoder *pfnDecode;
+	tXbeeFrameHandler *pfnHandler;
+};
+
+static bool decodeTxStatus(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+static bool decodeAtResponse(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+static bool decodeModemStatus(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+static bool decodeRxPacket(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+static bool decodeExplicitRx(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+static bool decodeIoSample(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+static bool decodeNodeIdentification(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+static bool decodeRemoteAtResponse(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+static bool decodeRouteRecord(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+static bool decodeManyToOne(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame);
+
+//*****************************************************************************
+// Frame type table. The last entry has a NULL decoder.
+static struct tXbeeFrameEntry g_psXbeeFrameTable[] = {
+	{ZB_TRANSMIT_STATUS, decodeTxStatus, 0},
+	{AT_COMMAND_RESPONSE, decodeAtResponse, 0},
+	{MODEM_STATUS, decodeModemStatus, 0},
+	{ZB_RECEIVE_PACKET, decodeRxPacket, 0},
+	{ZB_EXPLICIT_RX_INDICATOR, decodeExplicitRx, 0},
+	{ZB_IO_DATA_SAMPLE_RX_INDICATOR, decodeIoSample, 0},
+	{NODE_IDENTIFICATION_INDICATOR, decodeNodeIdentification, 0},
+	{REMOTE_COMMAND_RESPONSE, decodeRemoteAtResponse, 0},
+	{ROUTE_RECORD_INDICATOR, decodeRouteRecord, 0},
+	{MANY_TO_ONE_ROUTE_REQUEST_INDICATOR, decodeManyToOne, 0},
+	{0, 0, 0}
+};
+
+static tXbeeFrameHandler *g_pfnXbeeUnknownHandler = 0;
+static uint32_t g_ui32XbeeUnknownCount = 0;
+static uint32_t g_ui32XbeeMalformedCount = 0;
+
+//*****************************************************************************
+// Number of bytes in a view.
+uint16_t XbeeViewLength(const struct tXbeeRxView *psView){
+	return psView->length1 + psView->length2;
+}
+
+//*****************************************************************************
+// Byte at position ui16Offset of a view. The offset must be below the view length.
+uint8_t XbeeViewByte(const struct tXbeeRxView *psView, uint16_t ui16Offset){
+	if(ui16Offset < psView->length1){
+		return psView->data1[ui16Offset];
+	}
+	return psView->data2[ui16Offset - psView->length1];
+}
+
+//*****************************************************************************
+// Set psSlice to ui16Length bytes of a view starting at ui16Offset. The slice is
+// clipped to the end of the view.
+void XbeeViewSlice(const struct tXbeeRxView *psView, uint16_t ui16Offset, uint16_t ui16Length,
+				   struct tXbeeRxView *psSlice){
+	uint16_t ui16Total = XbeeViewLength(psView);
+
+	if(ui16Offset > ui16Total){
+		ui16Offset = ui16Total;
+	}
+	if(ui16Length > ui16Total - ui16Offset){
+		ui16Length = ui16Total - ui16Offset;
+	}
+
+	if(ui16Offset < psView->length1){
+		psSlice->data1 = psView->data1 + ui16Offset;
+		if(ui16Length <= psView->length1 - ui16Offset){
+			psSlice->length1 = ui16Length;
+			psSlice->data2 = psView->data2;
+			psSlice->length2 = 0;
+		}
+		else{
+			psSlice->length1 = psView->length1 - ui16Offset;
+			psSlice->data2 = psView->data2;
+			psSlice->length2 = ui16Length - psSlice->length1;
+		}
+	}
+	else{
+		psSlice->data1 = psView->data2 + (ui16Offset - psView->length1);
+		psSlice->length1 = ui16Length;
+		psSlice->data2 = psView->data2;
+		psSlice->length2 = 0;
+	}
+}
+
+//*****************************************************************************
+// Copy up to ui16Max bytes of a view to pui8Dst. Return number of bytes copied.
+uint16_t XbeeViewCopy(const struct tXbeeRxView *psView, uint8_t *pui8Dst, uint16_t ui16Max){
+	uint16_t ui16Count = 0;
+	uint16_t i;
+
+	for(i = 0; i < psView->length1 && ui16Count < ui16Max; i++){
+		pui8Dst[ui16Count++] = psView->data1[i];
+	}
+	for(i = 0; i < psView->length2 && ui16Count < ui16Max; i++){
+		pui8Dst[ui16Count++] = psView->data2[i];
+	}
+	return ui16Count;
+}
+
+//*****************************************************************************
+// Read a big endian 16 bit field.
+static uint16_t viewWord(const struct tXbeeRxView *psData, uint16_t ui16Offset){
+	return ((uint16_t)XbeeViewByte(psData, ui16Offset) << 8) | XbeeViewByte(psData, ui16Offset + 1);
+}
+
+//*****************************************************************************
+// Read 64 bit and 16 bit source addresses found at ui16Offset.
+static void viewAddresses(const struct tXbeeRxView *psData, uint16_t ui16Offset, uint8_t *pui8Addr64,
+						  uint16_t *pui16Addr16){
+	uint8_t i;
+
+	for(i = 0; i < 8; i++){
+		pui8Addr64[i] = XbeeViewByte(psData, ui16Offset + i);
+	}
+	*pui16Addr16 = viewWord(psData, ui16Offset + 8);
+}
+
+//*****************************************************************************
+// Frame decoders. Offsets count from the byte following the frame type.
+static bool decodeTxStatus(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	struct tXbeeTxStatus *psStatus = &psFrame->u.txStatus;
+
+	if(XbeeViewLength(psData) < 6){
+		return false;
+	}
+	psStatus->frameId = XbeeViewByte(psData, 0);
+	psStatus->dstAddr16 = viewWord(psData, 1);
+	psStatus->retryCount = XbeeViewByte(psData, 3);
+	psStatus->deliveryStatus = XbeeViewByte(psData, 4);
+	psStatus->discoveryStatus = XbeeViewByte(psData, 5);
+	return true;
+}
+
+static bool decodeAtResponse(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	struct tXbeeAtResponse *psResponse = &psFrame->u.atResponse;
+
+	if(XbeeViewLength(psData) < 4){
+		return false;
+	}
+	psResponse->frameId = XbeeViewByte(psData, 0);
+	psResponse->command[0] = XbeeViewByte(psData, 1);
+	psResponse->command[1] = XbeeViewByte(psData, 2);
+	psResponse->status = XbeeViewByte(psData, 3);
+	XbeeViewSlice(psData, 4, XbeeViewLength(psData) - 4, &psResponse->value);
+	return true;
+}
+
+static bool decodeModemStatus(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	if(XbeeViewLength(psData) < 1){
+		return false;
+	}
+	psFrame->u.modemStatus.status = XbeeViewByte(psData, 0);
+	return true;
+}
+
+static bool decodeRxPacket(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	struct tXbeeRxPacket *psPacket = &psFrame->u.rxPacket;
+
+	if(XbeeViewLength(psData) < 11){
+		return false;
+	}
+	viewAddresses(psData, 0, psPacket->srcAddr64, &psPacket->srcAddr16);
+	psPacket->options = XbeeViewByte(psData, 10);
+	XbeeViewSlice(psData, 11, XbeeViewLength(psData) - 11, &psPacket->data);
+	return true;
+}
+
+static bool decodeExplicitRx(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	struct tXbeeExplicitRx *psPacket = &psFrame->u.explicitRx;
+
+	if(XbeeViewLength(psData) < 17){
+		return false;
+	}
+	viewAddresses(psData, 0, psPacket->srcAddr64, &psPacket->srcAddr16);
+	psPacket->srcEndpoint = XbeeViewByte(psData, 10);
+	psPacket->dstEndpoint = XbeeViewByte(psData, 11);
+	psPacket->clusterId = viewWord(psData, 12);
+	psPacket->profileId = viewWord(psData, 14);
+	psPacket->options = XbeeViewByte(psData, 16);
+	XbeeViewSlice(psData, 17, XbeeViewLength(psData) - 17, &psPacket->data);
+	return true;
+}
+
+static bool decodeIoSample(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	struct tXbeeIoSample *psSample = &psFrame->u.ioSample;
+	uint16_t ui16Offset = 15;
+	uint8_t i;
+
+	if(XbeeViewLength(psData) < 15){
+		return false;
+	}
+	viewAddresses(psData, 0, psSample->srcAddr64, &psSample->srcAddr16);
+	psSample->options = XbeeViewByte(psData, 10);
+	psSample->numSamples = XbeeViewByte(psData, 11);
+	psSample->digitalMask = viewWord(psData, 12);
+	psSample->analogMask = XbeeViewByte(psData, 14);
+	psSample->digitalSamples = 0;
+
+	// Digital samples are only present when a digital line is enabled.
+	if(psSample->digitalMask){
+		if(XbeeViewLength(psData) < ui16Offset + 2){
+			return false;
+		}
+		psSample->digitalSamples = viewWord(psData, ui16Offset);
+		ui16Offset += 2;
+	}
+
+	// One analog sample follows for each analog mask bit set.
+	for(i = 0; i < 8; i++){
+		psSample->analogSamples[i] = 0;
+		if(psSample->analogMask & (1 << i)){
+			if(XbeeViewLength(psData) < ui16Offset + 2){
+				return false;
+			}
+			psSample->analogSamples[i] = viewWord(psData, ui16Offset);
+			ui16Offset += 2;
+		}
+	}
+	return true;
+}
+
+static bool decodeNodeIdentification(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	struct tXbeeNodeIdentification *psNode = &psFrame->u.nodeIdentification;
+	uint16_t ui16Length = XbeeViewLength(psData);
+	uint16_t ui16End;
+	uint8_t i;
+
+	if(ui16Length < 30){
+		return false;
+	}
+	viewAddresses(psData, 0, psNode->srcAddr64, &psNode->srcAddr16);
+	psNode->options = XbeeViewByte(psData, 10);
+	psNode->remoteAddr16 = viewWord(psData, 11);
+	for(i = 0; i < 8; i++){
+		psNode->remoteAddr64[i] = XbeeViewByte(psData, 13 + i);
+	}
+
+	// Node identifier string is NUL terminated and followed by 8 fixed bytes.
+	ui16End = 21;
+	while(ui16End < ui16Length && XbeeViewByte(psData, ui16End) != 0){
+		ui16End++;
+	}
+	if(ui16End + 9 > ui16Length){
+		return false;
+	}
+	XbeeViewSlice(psData, 21, ui16End - 21, &psNode->nodeId);
+	psNode->parentAddr16 = viewWord(psData, ui16End + 1);
+	psNode->deviceType = XbeeViewByte(psData, ui16End + 3);
+	psNode->sourceEvent = XbeeViewByte(psData, ui16End + 4);
+	psNode->profileId = viewWord(psData, ui16End + 5);
+	psNode->manufacturerId = viewWord(psData, ui16End + 7);
+	return true;
+}
+
+static bool decodeRemoteAtResponse(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	struct tXbeeRemoteAtResponse *psResponse = &psFrame->u.remoteAtResponse;
+
+	if(XbeeViewLength(psData) < 14){
+		return false;
+	}
+	psResponse->frameId = XbeeViewByte(psData, 0);
+	viewAddresses(psData, 1, psResponse->srcAddr64, &psResponse->srcAddr16);
+	psResponse->command[0] = XbeeViewByte(psData, 11);
+	psResponse->command[1] = XbeeViewByte(psData, 12);
+	psResponse->status = XbeeViewByte(psData, 13);
+	XbeeViewSlice(psData, 14, XbeeViewLength(psData) - 14, &psResponse->value);
+	return true;
+}
+
+static bool decodeRouteRecord(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	struct tXbeeRouteRecord *psRecord = &psFrame->u.routeRecord;
+	uint8_t i;
+
+	if(XbeeViewLength(psData) < 12){
+		return false;
+	}
+	viewAddresses(psData, 0, psRecord->srcAddr64, &psRecord->srcAddr16);
+	psRecord->options = XbeeViewByte(psData, 10);
+	psRecord->numAddresses = XbeeViewByte(psData, 11);
+	if(psRecord->numAddresses > XBEE_MAX_ROUTE_HOPS ||
+	   XbeeViewLength(psData) < 12 + 2 * (uint16_t)psRecord->numAddresses){
+		return false;
+	}
+	for(i = 0; i < psRecord->numAddresses; i++){
+		psRecord->addresses[i] = viewWord(psData, 12 + 2 * i);
+	}
+	return true;
+}
+
+static bool decodeManyToOne(const struct tXbeeRxView *psData, struct tXbeeApiFrame *psFrame){
+	if(XbeeViewLength(psData) < 10){
+		return false;
+	}
+	viewAddresses(psData, 0, psFrame->u.manyToOne.srcAddr64, &psFrame->u.manyToOne.srcAddr16);
+	return true;
+}
+
+//*****************************************************************************
+// Register the function called with each decoded frame of type ui8FrameType,
+// replacing the previous one. Pass 0 to ignore the frame type. Return false if
+// the frame type has no decoder.
+bool XbeeFrameHandlerSet(uint8_t ui8FrameType, tXbeeFrameHandler *pfnHandler){
+	struct tXbeeFrameEntry *psEntry;
+
+	for(psEntry = g_psXbeeFrameTable; psEntry->pfnDecode; psEntry++){
+		if(psEntry->frameType == ui8FrameType){
+			psEntry->pfnHandler = pfnHandler;
+			return true;
+		}
+	}
+	return false;
+}
+
+//*****************************************************************************
+// Register the function called with frames of types without decoder. The frame
+// data after the frame type is passed in the raw view.
+void XbeeFrameUnknownHandlerSet(tXbeeFrameHandler *pfnHandler){
+	g_pfnXbeeUnknownHandler = pfnHandler;
+}
+
+//*****************************************************************************
+// Decode a received frame and pass it to the handler registered for its frame
+// type. Frames of unknown type are counted and passed to the unknown frame
+// handler. Return false if the frame type is unknown or the frame is too
+// short for its type.
+bool XbeeFrameDispatch(const struct tXbeeRxSlot *psSlot){
+	struct tXbeeFrameEntry *psEntry;
+	struct tXbeeApiFrame sFrame;
+
+	sFrame.frameType = psSlot->frameType;
+
+	for(psEntry = g_psXbeeFrameTable; psEntry->pfnDecode; psEntry++){
+		if(psEntry->frameType == psSlot->frameType){
+			if(!psEntry->pfnDecode(&psSlot->data, &sFrame)){
+				g_ui32XbeeMalformedCount++;
+				return false;
+			}
+			if(psEntry->pfnHandler){
+				psEntry->pfnHandler(&sFrame);
+			}
+			return true;
+		}
+	}
+
+	g_ui32XbeeUnknownCount++;
+	if(g_pfnXbeeUnknownHandler){
+		sFrame.u.raw = psSlot->data;
+		g_pfnXbeeUnknownHandler(&sFrame);
+	}
+	return false;
+}
+
+//*****************************************************************************
+// Get number of received frames of unknown type.
+uint32_t XbeeFrameUnknownCountGet(void){
+	return g_ui32XbeeUnknownCount;
+}
+
+//*****************************************************************************
+// Get number of received frames too short for their type.
+uint32_t XbeeFrameMalformedCountGet(void){
+	return g_ui32XbeeMalformedCount;
+}
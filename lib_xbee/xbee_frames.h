@@ -0,0 +1,157 @@
+/*
+ * xbee_frames.h - Decode received API frames into typed structures and route
+ * 				   them to handlers registered per frame type.
+ *
+ * Variable length fields are views into the UART1 receive ring buffer, so they
+ * are only valid inside the handler, until the frame is released.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef XBEE_FRAMES_H_
+#define XBEE_FRAMES_H_
+
+#include "lib_xbee/XbeeZB.h"
+
+//*****************************************************************************
+// Route Record Indicator addresses kept, the ZigBee source route limit.
+#define XBEE_MAX_ROUTE_HOPS				   40
+
+//*****************************************************************************
+// ZB Transmit Status delivery status values.
+#define XBEE_DELIVERY_SUCCESS			 0x00
+#define XBEE_DELIVERY_ADDRESS_NOT_FOUND	 0x24
+
+//*****************************************************************************
+// ZB Transmit Status (0x8B).
+struct tXbeeTxStatus{
+	uint8_t frameId;
+	uint16_t dstAddr16;
+	uint8_t retryCount;
+	uint8_t deliveryStatus;
+	uint8_t discoveryStatus;
+};
+
+// AT Command Response (0x88).
+struct tXbeeAtResponse{
+	uint8_t frameId;
+	uint8_t command[2];
+	uint8_t status;
+	struct tXbeeRxView value;
+};
+
+// Modem Status (0x8A).
+struct tXbeeModemStatus{
+	uint8_t status;
+};
+
+// ZB Receive Packet (0x90).
+struct tXbeeRxPacket{
+	uint8_t srcAddr64[8];
+	uint16_t srcAddr16;
+	uint8_t options;
+	struct tXbeeRxView data;
+};
+
+// ZB Explicit Rx Indicator (0x91).
+struct tXbeeExplicitRx{
+	uint8_t srcAddr64[8];
+	uint16_t srcAddr16;
+	uint8_t srcEndpoint;
+	uint8_t dstEndpoint;
+	uint16_t clusterId;
+	uint16_t profileId;
+	uint8_t options;
+	struct tXbeeRxView data;
+};
+
+// ZB IO Data Sample Rx Indicator (0x92). analogSamples is indexed by analog mask bit.
+struct tXbeeIoSample{
+	uint8_t srcAddr64[8];
+	uint16_t srcAddr16;
+	uint8_t options;
+	uint8_t numSamples;
+	uint16_t digitalMask;
+	uint8_t analogMask;
+	uint16_t digitalSamples;
+	uint16_t analogSamples[8];
+};
+
+// Node Identification Indicator (0x95). nodeId excludes the terminating NUL.
+struct tXbeeNodeIdentification{
+	uint8_t srcAddr64[8];
+	uint16_t srcAddr16;
+	uint8_t options;
+	uint16_t remoteAddr16;
+	uint8_t remoteAddr64[8];
+	struct tXbeeRxView nodeId;
+	uint16_t parentAddr16;
+	uint8_t deviceType;
+	uint8_t sourceEvent;
+	uint16_t profileId;
+	uint16_t manufacturerId;
+};
+
+// Remote Command Response (0x97).
+struct tXbeeRemoteAtResponse{
+	uint8_t frameId;
+	uint8_t srcAddr64[8];
+	uint16_t srcAddr16;
+	uint8_t command[2];
+	uint8_t status;
+	struct tXbeeRxView value;
+};
+
+// Route Record Indicator (0xA1). Hop addresses are listed from the source side.
+struct tXbeeRouteRecord{
+	uint8_t srcAddr64[8];
+	uint16_t srcAddr16;
+	uint8_t options;
+	uint8_t numAddresses;
+	uint16_t addresses[XBEE_MAX_ROUTE_HOPS];
+};
+
+// Many-to-One Route Request Indicator (0xA3).
+struct tXbeeManyToOne{
+	uint8_t srcAddr64[8];
+	uint16_t srcAddr16;
+};
+
+// Decoded frame. raw holds the frame data after the frame type for frame types without decoder.
+struct tXbeeApiFrame{
+	uint8_t frameType;
+	union{
+		struct tXbeeTxStatus txStatus;
+		struct tXbeeAtResponse atResponse;
+		struct tXbeeModemStatus modemStatus;
+		struct tXbeeRxPacket rxPacket;
+		struct tXbeeExplicitRx explicitRx;
+		struct tXbeeIoSample ioSample;
+		struct tXbeeNodeIdentification nodeIdentification;
+		struct tXbeeRemoteAtResponse remoteAtResponse;
+		struct tXbeeRouteRecord routeRecord;
+		struct tXbeeManyToOne manyToOne;
+		struct tXbeeRxView raw;
+	} u;
+};
+
+//*****************************************************************************
+// Frame handler callback type.
+typedef void (tXbeeFrameHandler)(const struct tXbeeApiFrame *psFrame);
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern bool XbeeFrameHandlerSet(uint8_t ui8FrameType, tXbeeFrameHandler *pfnHandler);
+extern void XbeeFrameUnknownHandlerSet(tXbeeFrameHandler *pfnHandler);
+extern bool XbeeFrameDispatch(const struct tXbeeRxSlot *psSlot);
+extern uint32_t XbeeFrameUnknownCountGet(void);
+extern uint32_t XbeeFrameMalformedCountGet(void);
+
+extern uint16_t XbeeViewLength(const struct tXbeeRxView *psView);
+extern uint8_t XbeeViewByte(const struct tXbeeRxView *psView, uint16_t ui16Offset);
+extern void XbeeViewSlice(const struct tXbeeRxView *psView, uint16_t ui16Offset, uint16_t ui16Length,
+						  struct tXbeeRxView *psSlice);
+extern uint16_t XbeeViewCopy(const struct tXbeeRxView *psView, uint8_t *pui8Dst, uint16_t ui16Max);
+
+#endif /* XBEE_FRAMES_H_ */
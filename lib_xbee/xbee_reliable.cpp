@@ -0,0 +1,362 @@
+/*
+ * xbee_reliable.cpp - Optional end to end delivery layer over ZB Transmit
+ * 					   Request payloads.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lib_utils/timebase.h"
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_addr_table.h"
+#include "lib_xbee/xbee_source_route.h"
+#include "lib_xbee/xbee_reliable.h"
+
+static XbeeZB *g_psReliableXbee;
+static uint8_t g_ui8ReliableEpoch;
+static tXbeeReliableDeliver *g_pfnReliableDeliver;
+static tXbeeReliableDone *g_pfnReliableDone;
+static struct tXbeeReliablePeer g_psReliablePeers[XBEE_RELIABLE_MAX_PEERS];
+static struct tXbeeReliableEntry g_psReliableBuffer[XBEE_RELIABLE_BUFFER_SIZE];
+static uint32_t g_ui32ReliablePeerUses;
+static struct tXbeeReliableStats g_sReliableStats;
+
+//*****************************************************************************
+// Check whether a peer can be released: it was never sent data and has no
+// acknowledge waiting.
+static bool reliablePeerReleasable(const struct tXbeeReliablePeer *psPeer){
+	return !psPeer->txUsed && !psPeer->ackPending;
+}
+
+//*****************************************************************************
+// Find the peer with 64 bit address pui8Addr64. When bAdd is true a peer is
+// made for an unknown address, replacing the least recently used releasable
+// one if there is no free peer. Return XBEE_RELIABLE_MAX_PEERS if none.
+static uint8_t reliablePeerFind(const uint8_t *pui8Addr64, bool bAdd){
+	struct tXbeeReliablePeer *psPeer;
+	uint8_t ui8Victim = XBEE_RELIABLE_MAX_PEERS;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_RELIABLE_MAX_PEERS; i++){
+		psPeer = &g_psReliablePeers[i];
+		if(!psPeer->inUse){
+			if(ui8Victim == XBEE_RELIABLE_MAX_PEERS || g_psReliablePeers[ui8Victim].inUse){
+				ui8Victim = i;
+			}
+		}
+		else if(memcmp(psPeer->addr64, pui8Addr64, 8) == 0){
+			psPeer->lastUsed = ++g_ui32ReliablePeerUses;
+			return i;
+		}
+		else if(reliablePeerReleasable(psPeer) &&
+				(ui8Victim == XBEE_RELIABLE_MAX_PEERS ||
+				 (g_psReliablePeers[ui8Victim].inUse && psPeer->lastUsed < g_psReliablePeers[ui8Victim].lastUsed))){
+			ui8Victim = i;
+		}
+	}
+	if(!bAdd || ui8Victim == XBEE_RELIABLE_MAX_PEERS){
+		return XBEE_RELIABLE_MAX_PEERS;
+	}
+
+	psPeer = &g_psReliablePeers[ui8Victim];
+	if(psPeer->inUse){
+		g_sReliableStats.peersReleased++;
+	}
+	psPeer->inUse = true;
+	psPeer->rxValid = false;
+	psPeer->txUsed = false;
+	psPeer->ackPending = false;
+	psPeer->txSeq = 0;
+	psPeer->lastUsed = ++g_ui32ReliablePeerUses;
+	memcpy(psPeer->addr64, pui8Addr64, 8);
+	return ui8Victim;
+}
+
+//*****************************************************************************
+// Find the peer of the sender of psPacket. Payloads sent to the coordinator
+// alias g_pui8ZBCoordinatorAddr64 are answered from the coordinator's own 64
+// bit address, so a coordinator without a peer of its own address uses the
+// alias peer, as XbeeAddrLearn() does for the address table.
+static uint8_t reliablePeerSourceFind(const struct tXbeeRxPacket *psPacket, bool bAdd){
+	uint8_t ui8Peer = reliablePeerFind(psPacket->srcAddr64, false);
+
+	if(ui8Peer == XBEE_RELIABLE_MAX_PEERS && psPacket->srcAddr16 == ZB_COORDINATOR_ADDR16){
+		ui8Peer = reliablePeerFind(g_pui8ZBCoordinatorAddr64, false);
+	}
+	if(ui8Peer == XBEE_RELIABLE_MAX_PEERS && bAdd){
+		ui8Peer = reliablePeerFind(psPacket->srcAddr64, true);
+	}
+	return ui8Peer;
+}
+
+//*****************************************************************************
+// Send a buffered data payload and schedule its next retransmit. When the
+// UART has no room the payload is left pending, to be sent by
+// XbeeReliableProcess() without counting an attempt.
+static void reliableTransmit(struct tXbeeReliableEntry *psEntry, uint32_t ui32Now){
+	struct tXbeeTxSegment sSegment;
+
+	sSegment.data = psEntry->payload;
+	sSegment.length = psEntry->length;
+	XbeeSourceRoutePrepare(g_psReliablePeers[psEntry->peer].addr64);
+	if(!g_psReliableXbee->ZBTransmitRequest(XbeeAddrTxHeaderGet(g_psReliablePeers[psEntry->peer].addr64),
+											&sSegment, 1, 0)){
+		psEntry->sendPending = true;
+		return;
+	}
+	psEntry->sendPending = false;
+	psEntry->attempts++;
+	psEntry->retryMs = ui32Now + psEntry->rtoMs;
+}
+
+//*****************************************************************************
+// Acknowledge the peer payload recorded in ackEpoch and ackSeq. The
+// acknowledge stays pending if the UART has no room.
+static void reliableAckSend(struct tXbeeReliablePeer *psPeer){
+	uint8_t pui8Ack[XBEE_RELIABLE_HEADER_SIZE];
+	struct tXbeeTxSegment sSegment;
+
+	pui8Ack[0] = XBEE_RELIABLE_ACK;
+	pui8Ack[1] = psPeer->ackEpoch;
+	pui8Ack[2] = psPeer->ackSeq;
+	sSegment.data = pui8Ack;
+	sSegment.length = sizeof(pui8Ack);
+	psPeer->ackPending = !g_psReliableXbee->ZBTransmitRequest(XbeeAddrTxHeaderGet(psPeer->addr64),
+															 &sSegment, 1, 0);
+}
+
+//*****************************************************************************
+// Record whether sequence number ui8Seq of epoch ui8Epoch was already received
+// from a peer. Return true for a duplicate.
+static bool reliableRxDuplicate(struct tXbeeReliablePeer *psPeer, uint8_t ui8Epoch, uint8_t ui8Seq){
+	int8_t i8Delta = (int8_t)(ui8Seq - psPeer->rxHighest);
+
+	// First payload, or the peer rebooted and restarted its sequence numbers.
+	if(!psPeer->rxValid || ui8Epoch != psPeer->rxEpoch){
+		psPeer->rxValid = true;
+		psPeer->rxEpoch = ui8Epoch;
+		psPeer->rxHighest = ui8Seq;
+		psPeer->rxBitmap = 1;
+		return false;
+	}
+	if(i8Delta > 0){
+		psPeer->rxBitmap = (i8Delta < 32) ? (psPeer->rxBitmap << i8Delta) | 1 : 1;
+		psPeer->rxHighest = ui8Seq;
+		return false;
+	}
+
+	// Too old to be tracked, taken as a duplicate.
+	if(-i8Delta >= 32){
+		return true;
+	}
+	if(psPeer->rxBitmap & ((uint32_t)1 << -i8Delta)){
+		return true;
+	}
+	psPeer->rxBitmap |= (uint32_t)1 << -i8Delta;
+	return false;
+}
+
+//*****************************************************************************
+// Initialize the layer. ui8Epoch must differ from the one used on the previous
+// boot, such as the low byte of a boot counter. pfnDeliver is called with new
+// data received and pfnDone, which may be 0, with the outcome of each data
+// payload sent.
+void XbeeReliableInit(XbeeZB *psXbee, uint8_t ui8Epoch, tXbeeReliableDeliver *pfnDeliver,
+					  tXbeeReliableDone *pfnDone){
+	uint8_t i;
+
+	g_psReliableXbee = psXbee;
+	g_ui8ReliableEpoch = ui8Epoch;
+	g_pfnReliableDeliver = pfnDeliver;
+	g_pfnReliableDone = pfnDone;
+	for(i = 0; i < XBEE_RELIABLE_MAX_PEERS; i++){
+		g_psReliablePeers[i].inUse = false;
+	}
+	for(i = 0; i < XBEE_RELIABLE_BUFFER_SIZE; i++){
+		g_psReliableBuffer[i].inUse = false;
+	}
+	g_ui32ReliablePeerUses = 0;
+	memset(&g_sReliableStats, 0, sizeof(g_sReliableStats));
+}
+
+//*****************************************************************************
+// Send ui8Length bytes of data to the node with 64 bit address pui8DstAddr64.
+// The data is copied to the retransmit buffer, and sent later if the UART has
+// no room now. Return false if the data is too long, the buffer is full or
+// there is no room for a new destination.
+bool XbeeReliableSend(const uint8_t *pui8DstAddr64, const uint8_t *pui8Data, uint8_t ui8Length,
+					  uint32_t ui32Now){
+	struct tXbeeReliableEntry *psEntry = 0;
+	uint8_t ui8Peer;
+	uint8_t i;
+
+	if(ui8Length > XBEE_RELIABLE_MAX_DATA){
+		return false;
+	}
+	for(i = 0; i < XBEE_RELIABLE_BUFFER_SIZE; i++){
+		if(!g_psReliableBuffer[i].inUse){
+			psEntry = &g_psReliableBuffer[i];
+			break;
+		}
+	}
+	if(!psEntry){
+		return false;
+	}
+	ui8Peer = reliablePeerFind(pui8DstAddr64, true);
+	if(ui8Peer == XBEE_RELIABLE_MAX_PEERS){
+		return false;
+	}
+
+	g_psReliablePeers[ui8Peer].txUsed = true;
+	psEntry->inUse = true;
+	psEntry->peer = ui8Peer;
+	psEntry->seq = g_psReliablePeers[ui8Peer].txSeq++;
+	psEntry->attempts = 0;
+	psEntry->firstSentMs = ui32Now;
+	psEntry->rtoMs = XBEE_RELIABLE_RTO_MS;
+	psEntry->payload[0] = XBEE_RELIABLE_DATA;
+	psEntry->payload[1] = g_ui8ReliableEpoch;
+	psEntry->payload[2] = psEntry->seq;
+	memcpy(&psEntry->payload[XBEE_RELIABLE_HEADER_SIZE], pui8Data, ui8Length);
+	psEntry->length = ui8Length + XBEE_RELIABLE_HEADER_SIZE;
+	g_sReliableStats.sent++;
+
+	reliableTransmit(psEntry, ui32Now);
+	return true;
+}
+
+//*****************************************************************************
+// Handle a received ZB Receive Packet. Data payloads are acknowledged and new
+// ones passed to the deliver function, acknowledges release the matching
+// buffered payload. Return false if the payload does not belong to the layer.
+bool XbeeReliableReceive(const struct tXbeeRxPacket *psPacket){
+	struct tXbeeReliableEntry *psEntry;
+	struct tXbeeReliablePeer *psPeer;
+	struct tXbeeRxView sData;
+	uint32_t ui32Now;
+	uint8_t ui8Peer;
+	uint8_t ui8Epoch;
+	uint8_t ui8Seq;
+	uint8_t i;
+
+	if(XbeeViewLength(&psPacket->data) < XBEE_RELIABLE_HEADER_SIZE){
+		return false;
+	}
+	ui8Epoch = XbeeViewByte(&psPacket->data, 1);
+	ui8Seq = XbeeViewByte(&psPacket->data, 2);
+
+	switch(XbeeViewByte(&psPacket->data, 0)){
+		case XBEE_RELIABLE_DATA:
+			// Without a peer the payload is neither acknowledged nor delivered, the sender
+			// sends it again.
+			ui8Peer = reliablePeerSourceFind(psPacket, true);
+			if(ui8Peer == XBEE_RELIABLE_MAX_PEERS){
+				return true;
+			}
+			psPeer = &g_psReliablePeers[ui8Peer];
+
+			// Acknowledge every copy, the previous acknowledge may have been lost.
+			psPeer->ackEpoch = ui8Epoch;
+			psPeer->ackSeq = ui8Seq;
+			reliableAckSend(psPeer);
+
+			if(reliableRxDuplicate(psPeer, ui8Epoch, ui8Seq)){
+				g_sReliableStats.duplicates++;
+				return true;
+			}
+			g_sReliableStats.received++;
+			if(g_pfnReliableDeliver){
+				XbeeViewSlice(&psPacket->data, XBEE_RELIABLE_HEADER_SIZE,
+							  XbeeViewLength(&psPacket->data) - XBEE_RELIABLE_HEADER_SIZE, &sData);
+				g_pfnReliableDeliver(psPacket->srcAddr64, &sData);
+			}
+			return true;
+
+		case XBEE_RELIABLE_ACK:
+			// Acknowledges of payloads sent before this node rebooted are ignored.
+			if(ui8Epoch != g_ui8ReliableEpoch){
+				return true;
+			}
+			ui8Peer = reliablePeerSourceFind(psPacket, false);
+			ui32Now = TimebaseMsGet();
+			for(i = 0; i < XBEE_RELIABLE_BUFFER_SIZE; i++){
+				psEntry = &g_psReliableBuffer[i];
+				if(psEntry->inUse && psEntry->peer == ui8Peer && psEntry->seq == ui8Seq){
+					psEntry->inUse = false;
+					g_sReliableStats.acked++;
+					g_sReliableStats.lastLatencyMs = ui32Now - psEntry->firstSentMs;
+					if(g_sReliableStats.lastLatencyMs > g_sReliableStats.maxLatencyMs){
+						g_sReliableStats.maxLatencyMs = g_sReliableStats.lastLatencyMs;
+					}
+					if(g_pfnReliableDone){
+						g_pfnReliableDone(ui8Seq, true, g_sReliableStats.lastLatencyMs);
+					}
+					break;
+				}
+			}
+			// Late acknowledges of payloads already released are ignored.
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+//*****************************************************************************
+// Send pending acknowledges and payloads, retransmit payloads whose timeout
+// expired, doubling the timeout each time, and give up after
+// XBEE_RELIABLE_MAX_ATTEMPTS. Call it periodically from the main loop.
+void XbeeReliableProcess(uint32_t ui32Now){
+	struct tXbeeReliableEntry *psEntry;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_RELIABLE_MAX_PEERS; i++){
+		if(g_psReliablePeers[i].inUse && g_psReliablePeers[i].ackPending){
+			reliableAckSend(&g_psReliablePeers[i]);
+		}
+	}
+
+	for(i = 0; i < XBEE_RELIABLE_BUFFER_SIZE; i++){
+		psEntry = &g_psReliableBuffer[i];
+		if(!psEntry->inUse){
+			continue;
+		}
+		if(psEntry->sendPending){
+			reliableTransmit(psEntry, ui32Now);
+			continue;
+		}
+		if(!TimebaseDeadlineReached(ui32Now, psEntry->retryMs)){
+			continue;
+		}
+
+		// The payload or its acknowledge was lost, the destination may have a new address.
+		XbeeAddrInvalidate(g_psReliablePeers[psEntry->peer].addr64);
+
+		if(psEntry->attempts >= XBEE_RELIABLE_MAX_ATTEMPTS){
+			XbeeSourceRouteDrop(g_psReliablePeers[psEntry->peer].addr64);
+			psEntry->inUse = false;
+			g_sReliableStats.failed++;
+			if(g_pfnReliableDone){
+				g_pfnReliableDone(psEntry->seq, false, ui32Now - psEntry->firstSentMs);
+			}
+			continue;
+		}
+
+		psEntry->rtoMs *= 2;
+		if(psEntry->rtoMs > XBEE_RELIABLE_RTO_MAX_MS){
+			psEntry->rtoMs = XBEE_RELIABLE_RTO_MAX_MS;
+		}
+		g_sReliableStats.retransmits++;
+		reliableTransmit(psEntry, ui32Now);
+	}
+}
+
+//*****************************************************************************
+// Get layer statistics.
+void XbeeReliableStatsGet(struct tXbeeReliableStats *psStats){
+	*psStats = g_sReliableStats;
+}
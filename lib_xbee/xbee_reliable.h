@@ -0,0 +1,120 @@
+/*
+ * xbee_reliable.h - Optional end to end delivery layer over ZB Transmit
+ * 					 Request payloads.
+ *
+ * Data payloads carry a per destination sequence number and are kept in a
+ * retransmit buffer until the destination acknowledges that sequence number.
+ * Unacknowledged payloads are sent again with exponential backoff, so only the
+ * lost ones are retransmitted. Received data payloads are acknowledged and
+ * duplicates are dropped. A retransmit also drops the learned 16 bit address of
+ * the destination, see xbee_addr_table.h.
+ *
+ * Sequence numbers restart at 0 when a node boots, so data payloads also carry
+ * the sender epoch, a value that changes on every boot. A new epoch from a peer
+ * restarts its duplicate tracking, and an acknowledge only matches payloads of
+ * the epoch it echoes.
+ *
+ * Payloads sent to the coordinator alias g_pui8ZBCoordinatorAddr64 are
+ * acknowledged from the coordinator's own 64 bit address; frames from 16 bit
+ * address 0 are matched to the alias peer.
+ *
+ * Payloads and acknowledges the UART had no room for are sent from
+ * XbeeReliableProcess(). Peers that only sent data to this node are released,
+ * least recently used first, when a new peer needs their place; their
+ * duplicate tracking is lost with them. Peers this node sent data to keep
+ * their sequence number and are never released.
+ *
+ * Payload layout:
+ *   DATA   XBEE_RELIABLE_DATA, sender epoch, sequence number, data bytes.
+ *   ACK    XBEE_RELIABLE_ACK, epoch of the data payload, acknowledged sequence number.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef XBEE_RELIABLE_H_
+#define XBEE_RELIABLE_H_
+
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+
+//*****************************************************************************
+// Payload tags. Plain text commands stay below 0x80.
+#define XBEE_RELIABLE_DATA				 0xC0
+#define XBEE_RELIABLE_ACK				 0xC1
+#define XBEE_RELIABLE_HEADER_SIZE		    3
+#define XBEE_RELIABLE_MAX_DATA			 (ZB_MAX_RF_PAYLOAD - XBEE_RELIABLE_HEADER_SIZE)
+
+//*****************************************************************************
+// Layer parameters.
+#define XBEE_RELIABLE_MAX_PEERS			    4		// Destinations with sequence state.
+#define XBEE_RELIABLE_BUFFER_SIZE		    4		// Payloads waiting for acknowledge.
+#define XBEE_RELIABLE_RTO_MS			  500		// First retransmit timeout.
+#define XBEE_RELIABLE_RTO_MAX_MS		 8000		// Retransmit timeout limit.
+#define XBEE_RELIABLE_MAX_ATTEMPTS		    6		// Sends before giving up.
+
+//*****************************************************************************
+// Sequence state of a destination. Received sequence numbers are tracked in a
+// bitmap where bit n stands for rxHighest - n.
+struct tXbeeReliablePeer{
+	bool inUse;
+	bool rxValid;							// True once a data payload was received.
+	bool txUsed;							// True once a data payload was sent.
+	bool ackPending;						// Acknowledge waiting for room in the UART.
+	uint8_t addr64[8];
+	uint8_t txSeq;							// Sequence number of the next data payload.
+	uint8_t ackEpoch;
+	uint8_t ackSeq;
+	uint8_t rxEpoch;						// Epoch of the tracked sequence numbers.
+	uint8_t rxHighest;
+	uint32_t rxBitmap;
+	uint32_t lastUsed;						// Use count when last used, for replacement.
+};
+
+//*****************************************************************************
+// Data payload waiting for acknowledge.
+struct tXbeeReliableEntry{
+	bool inUse;
+	bool sendPending;						// Not queued yet, the UART had no room.
+	uint8_t peer;
+	uint8_t seq;
+	uint8_t attempts;
+	uint32_t firstSentMs;
+	uint32_t retryMs;						// Time of the next retransmit.
+	uint32_t rtoMs;							// Current retransmit timeout.
+	uint8_t length;
+	uint8_t payload[ZB_MAX_RF_PAYLOAD];		// Header included.
+};
+
+//*****************************************************************************
+// Layer statistics.
+struct tXbeeReliableStats{
+	uint32_t sent;							// Data payloads accepted.
+	uint32_t acked;
+	uint32_t failed;						// Given up after XBEE_RELIABLE_MAX_ATTEMPTS.
+	uint32_t retransmits;
+	uint32_t peersReleased;					// Peers replaced by a new one.
+	uint32_t received;						// Data payloads delivered.
+	uint32_t duplicates;
+	uint32_t lastLatencyMs;
+	uint32_t maxLatencyMs;
+};
+
+//*****************************************************************************
+// Function called with the data of each new data payload received.
+typedef void (tXbeeReliableDeliver)(const uint8_t *pui8SrcAddr64, const struct tXbeeRxView *psData);
+
+// Function called once per data payload sent, when acknowledged or given up.
+typedef void (tXbeeReliableDone)(uint8_t ui8Seq, bool bDelivered, uint32_t ui32LatencyMs);
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern void XbeeReliableInit(XbeeZB *psXbee, uint8_t ui8Epoch, tXbeeReliableDeliver *pfnDeliver,
+							 tXbeeReliableDone *pfnDone);
+extern bool XbeeReliableSend(const uint8_t *pui8DstAddr64, const uint8_t *pui8Data, uint8_t ui8Length,
+							 uint32_t ui32Now);
+extern bool XbeeReliableReceive(const struct tXbeeRxPacket *psPacket);
+extern void XbeeReliableProcess(uint32_t ui32Now);
+extern void XbeeReliableStatsGet(struct tXbeeReliableStats *psStats);
+
+#endif /* XBEE_RELIABLE_H_ */
@@ -0,0 +1,159 @@
+/*
+ * xbee_source_route.cpp - Cache source routes learned from Route Record
+ * 						   Indicator frames and hand them to the module before
+ * 						   unicasting.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_addr_table.h"
+#include "lib_xbee/xbee_source_route.h"
+
+static XbeeZB *g_psSourceRouteXbee;
+static struct tXbeeSourceRoute g_psSourceRoutes[XBEE_SOURCE_ROUTE_SIZE];
+static uint32_t g_ui32SourceRouteUses;
+static struct tXbeeSourceRouteStats g_sSourceRouteStats;
+
+//*****************************************************************************
+// Find the cached route to pui8Addr64. When bAdd is true an empty route is
+// made for a new node, replacing the least recently used one if the cache is
+// full. Return 0 if not found and not added.
+static struct tXbeeSourceRoute *sourceRouteFind(const uint8_t *pui8Addr64, bool bAdd){
+	struct tXbeeSourceRoute *psVictim = 0;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_SOURCE_ROUTE_SIZE; i++){
+		if(!g_psSourceRoutes[i].inUse){
+			if(!psVictim || psVictim->inUse){
+				psVictim = &g_psSourceRoutes[i];
+			}
+		}
+		else if(memcmp(g_psSourceRoutes[i].addr64, pui8Addr64, 8) == 0){
+			return &g_psSourceRoutes[i];
+		}
+		else if(!psVictim || (psVictim->inUse && g_psSourceRoutes[i].lastUsed < psVictim->lastUsed)){
+			psVictim = &g_psSourceRoutes[i];
+		}
+	}
+	if(!bAdd){
+		return 0;
+	}
+
+	psVictim->inUse = true;
+	memcpy(psVictim->addr64, pui8Addr64, 8);
+	psVictim->addr16 = ZB_UNKNOWN_ADDR16;
+	psVictim->hopCount = 0;
+	psVictim->lastUsed = g_ui32SourceRouteUses;
+	return psVictim;
+}
+
+//*****************************************************************************
+// Initialize the cache, with no route known.
+void XbeeSourceRouteInit(XbeeZB *psXbee){
+	uint8_t i;
+
+	g_psSourceRouteXbee = psXbee;
+	for(i = 0; i < XBEE_SOURCE_ROUTE_SIZE; i++){
+		g_psSourceRoutes[i].inUse = false;
+	}
+	g_ui32SourceRouteUses = 0;
+	memset(&g_sSourceRouteStats, 0, sizeof(g_sSourceRouteStats));
+}
+
+//*****************************************************************************
+// Route Record Indicator handler, to be registered with XbeeFrameHandlerSet().
+// A new or changed route is marked to be given to the module. Only called on a
+// concentrator, a sensor node never receives these frames.
+void XbeeSourceRouteRecordHandler(const struct tXbeeApiFrame *psFrame){
+	const struct tXbeeRouteRecord *psRecord = &psFrame->u.routeRecord;
+	struct tXbeeSourceRoute *psRoute;
+	uint8_t i;
+
+	g_sSourceRouteStats.records++;
+	XbeeAddrLearn(psRecord->srcAddr64, psRecord->srcAddr16);
+
+	// Nodes with longer routes are left to route discovery.
+	if(psRecord->numAddresses > XBEE_SOURCE_ROUTE_MAX_HOPS){
+		g_sSourceRouteStats.tooLong++;
+		psRoute = sourceRouteFind(psRecord->srcAddr64, false);
+		if(psRoute){
+			psRoute->inUse = false;
+		}
+		return;
+	}
+
+	psRoute = sourceRouteFind(psRecord->srcAddr64, true);
+	if(psRoute->addr16 == psRecord->srcAddr16 && psRoute->hopCount == psRecord->numAddresses &&
+	   memcmp(psRoute->hops, psRecord->addresses, 2 * psRecord->numAddresses) == 0){
+		return;
+	}
+	psRoute->addr16 = psRecord->srcAddr16;
+	psRoute->hopCount = psRecord->numAddresses;
+	for(i = 0; i < psRecord->numAddresses; i++){
+		psRoute->hops[i] = psRecord->addresses[i];
+	}
+	psRoute->pending = true;
+	g_sSourceRouteStats.changed++;
+}
+
+//*****************************************************************************
+// Many-to-One Route Request Indicator handler, to be registered with
+// XbeeFrameHandlerSet(). Frames to the concentrator use its many-to-one route.
+void XbeeSourceRouteManyToOneHandler(const struct tXbeeApiFrame *psFrame){
+	const struct tXbeeManyToOne *psRequest = &psFrame->u.manyToOne;
+	struct tXbeeSourceRoute *psRoute = sourceRouteFind(psRequest->srcAddr64, false);
+
+	g_sSourceRouteStats.manyToOne++;
+	XbeeAddrLearn(psRequest->srcAddr64, psRequest->srcAddr16);
+	if(psRoute){
+		psRoute->inUse = false;
+	}
+}
+
+//*****************************************************************************
+// Call before sending a frame to pui8Addr64. If its cached route is not yet in
+// the module a Create Source Route frame is sent first. Return false if UART1
+// had no room for it; the frame may still be sent, the module then discovers
+// the route itself.
+bool XbeeSourceRoutePrepare(const uint8_t *pui8Addr64){
+	struct tXbeeSourceRoute *psRoute = sourceRouteFind(pui8Addr64, false);
+
+	if(!psRoute){
+		return true;
+	}
+	psRoute->lastUsed = ++g_ui32SourceRouteUses;
+	if(!psRoute->pending){
+		return true;
+	}
+	if(!g_psSourceRouteXbee->ZBCreateSourceRoute(psRoute->addr64, psRoute->addr16, psRoute->hops,
+												 psRoute->hopCount)){
+		return false;
+	}
+	psRoute->pending = false;
+	g_sSourceRouteStats.created++;
+	return true;
+}
+
+//*****************************************************************************
+// Drop the cached route to pui8Addr64 after a delivery failure. The next Route
+// Record Indicator from the node brings its current route.
+void XbeeSourceRouteDrop(const uint8_t *pui8Addr64){
+	struct tXbeeSourceRoute *psRoute = sourceRouteFind(pui8Addr64, false);
+
+	if(psRoute){
+		psRoute->inUse = false;
+		g_sSourceRouteStats.dropped++;
+	}
+}
+
+//*****************************************************************************
+// Get cache statistics.
+void XbeeSourceRouteStatsGet(struct tXbeeSourceRouteStats *psStats){
+	*psStats = g_sSourceRouteStats;
+}
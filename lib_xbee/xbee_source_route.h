@@ -0,0 +1,73 @@
+/*
+ * xbee_source_route.h - Cache source routes learned from Route Record
+ * 						 Indicator frames and hand them to the module before
+ * 						 unicasting, so frames to known nodes need no route
+ * 						 discovery.
+ *
+ * In a many-to-one network the concentrator receives a Route Record
+ * Indicator with the hops every remote node used to reach it. Those hops,
+ * in the same order, make the source route back to the node. A route is
+ * given to the module in a Create Source Route frame the first time a frame
+ * is sent to its node after the route was learned or changed; the module
+ * keeps it in its own source route table.
+ *
+ * A Many-to-One Route Request Indicator names a concentrator. Frames to it
+ * follow its many-to-one route, so any source route cached for it is dropped.
+ *
+ * Route Record Indicators are only output by a concentrator, the node that
+ * sends many-to-one route requests (ATAR) with API output of explicit frames
+ * (ATAO 1). This firmware runs on a sensor node, a router or end device that
+ * reports to the coordinator, so on it no route is learned: the cache stays
+ * empty and XbeeSourceRoutePrepare() does nothing. The cache only fills if
+ * the firmware is reused on a concentrator, such as a gateway built on this
+ * code. Many-to-One Route Request Indicators do reach sensor nodes, where they
+ * only teach the concentrator address.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef XBEE_SOURCE_ROUTE_H_
+#define XBEE_SOURCE_ROUTE_H_
+
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+
+//*****************************************************************************
+// Cache parameters.
+#define XBEE_SOURCE_ROUTE_SIZE			    8		// Nodes with a cached route.
+#define XBEE_SOURCE_ROUTE_MAX_HOPS		   10		// Longer routes are not cached.
+
+//*****************************************************************************
+// Cached route to a node.
+struct tXbeeSourceRoute{
+	bool inUse;
+	bool pending;							// Not yet given to the module.
+	uint8_t addr64[8];
+	uint16_t addr16;
+	uint8_t hopCount;
+	uint16_t hops[XBEE_SOURCE_ROUTE_MAX_HOPS];	// Starting with the neighbor of the node.
+	uint32_t lastUsed;						// Cache use count at last use, for replacement.
+};
+
+//*****************************************************************************
+// Cache statistics.
+struct tXbeeSourceRouteStats{
+	uint32_t records;						// Route Record Indicators received.
+	uint32_t changed;						// Routes learned or changed.
+	uint32_t created;						// Create Source Route frames sent.
+	uint32_t tooLong;						// Routes longer than XBEE_SOURCE_ROUTE_MAX_HOPS.
+	uint32_t dropped;						// Routes dropped after a delivery failure.
+	uint32_t manyToOne;						// Many-to-One Route Request Indicators received.
+};
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern void XbeeSourceRouteInit(XbeeZB *psXbee);
+extern void XbeeSourceRouteRecordHandler(const struct tXbeeApiFrame *psFrame);
+extern void XbeeSourceRouteManyToOneHandler(const struct tXbeeApiFrame *psFrame);
+extern bool XbeeSourceRoutePrepare(const uint8_t *pui8Addr64);
+extern void XbeeSourceRouteDrop(const uint8_t *pui8Addr64);
+extern void XbeeSourceRouteStatsGet(struct tXbeeSourceRouteStats *psStats);
+
+#endif /* XBEE_SOURCE_ROUTE_H_ */
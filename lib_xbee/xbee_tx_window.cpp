@@ -0,0 +1,234 @@
+/*
+ * xbee_tx_window.cpp - Keep several ZB Transmit Requests in flight and match
+ * 						them with the ZB Transmit Status frames sent back by
+ * 						the module.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lib_utils/timebase.h"
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_addr_table.h"
+#include "lib_xbee/xbee_tx_window.h"
+
+static XbeeZB *g_psTxWindowXbee;
+static tXbeeTxDoneCallback *g_pfnTxWindowDone;
+static struct tXbeeTxEntry g_psTxWindow[XBEE_TX_WINDOW_SIZE];
+static struct tXbeeTxStats g_sTxWindowStats;
+
+//*****************************************************************************
+// Number of frames in flight.
+uint8_t XbeeTxWindowInFlightGet(void){
+	uint8_t ui8Count = 0;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_TX_WINDOW_SIZE; i++){
+		if(g_psTxWindow[i].inUse){
+			ui8Count++;
+		}
+	}
+	return ui8Count;
+}
+
+//*****************************************************************************
+// Get a frame id not used by another frame in flight.
+static uint8_t txWindowFrameId(void){
+	uint8_t ui8FrameId;
+	uint8_t i;
+
+	do{
+		ui8FrameId = g_psTxWindowXbee->nextFrameId();
+		for(i = 0; i < XBEE_TX_WINDOW_SIZE; i++){
+			if(g_psTxWindow[i].inUse && g_psTxWindow[i].frameId == ui8FrameId){
+				break;
+			}
+		}
+	} while(i < XBEE_TX_WINDOW_SIZE);
+
+	return ui8FrameId;
+}
+
+//*****************************************************************************
+// Send an attempt of a frame in flight with a fresh frame id, so a late status
+// of a previous attempt is not taken for this one. Return false if UART1 has
+// no room, leaving the resend pending.
+static bool txWindowAttempt(struct tXbeeTxEntry *psEntry, uint32_t ui32Now){
+	struct tXbeeTxSegment sSegment;
+	uint8_t ui8FrameId = txWindowFrameId();
+
+	sSegment.data = psEntry->payload;
+	sSegment.length = psEntry->length;
+	if(!g_psTxWindowXbee->ZBTransmitRequest(XbeeAddrTxHeaderGet(g_pui8ZBCoordinatorAddr64), &sSegment, 1,
+											ui8FrameId)){
+		psEntry->resendPending = true;
+		return false;
+	}
+	psEntry->frameId = ui8FrameId;
+	psEntry->sentMs = ui32Now;
+	psEntry->resendPending = false;
+	return true;
+}
+
+//*****************************************************************************
+// Report the final result of a frame and free its slot.
+static void txWindowComplete(struct tXbeeTxEntry *psEntry, uint8_t ui8Status, uint8_t ui8RetryCount,
+							 uint32_t ui32Now){
+	struct tXbeeTxResult sResult;
+
+	sResult.frameId = psEntry->frameId;
+	sResult.deliveryStatus = ui8Status;
+	sResult.retryCount = ui8RetryCount;
+	sResult.resends = psEntry->resends;
+	sResult.latencyMs = ui32Now - psEntry->firstSentMs;
+	psEntry->inUse = false;
+
+	if(ui8Status == XBEE_DELIVERY_SUCCESS){
+		g_sTxWindowStats.delivered++;
+	}
+	else{
+		g_sTxWindowStats.failed++;
+	}
+	g_sTxWindowStats.lastLatencyMs = sResult.latencyMs;
+	if(sResult.latencyMs > g_sTxWindowStats.maxLatencyMs){
+		g_sTxWindowStats.maxLatencyMs = sResult.latencyMs;
+	}
+
+	if(g_pfnTxWindowDone){
+		g_pfnTxWindowDone(&sResult);
+	}
+}
+
+//*****************************************************************************
+// A failed attempt is sent again while resends are left, otherwise the frame
+// completes with the failure status. The coordinator address is resolved again
+// by the module, in case it changed.
+static void txWindowFailed(struct tXbeeTxEntry *psEntry, uint8_t ui8Status, uint8_t ui8RetryCount,
+						   uint32_t ui32Now){
+	XbeeAddrInvalidate(g_pui8ZBCoordinatorAddr64);
+	if(psEntry->resends < XBEE_TX_MAX_RESENDS){
+		psEntry->resends++;
+		g_sTxWindowStats.resends++;
+		txWindowAttempt(psEntry, ui32Now);
+	}
+	else{
+		txWindowComplete(psEntry, ui8Status, ui8RetryCount, ui32Now);
+	}
+}
+
+//*****************************************************************************
+// Initialize the window. pfnDone, which may be 0, is called with the final
+// result of each frame.
+void XbeeTxWindowInit(XbeeZB *psXbee, tXbeeTxDoneCallback *pfnDone){
+	uint8_t i;
+
+	g_psTxWindowXbee = psXbee;
+	g_pfnTxWindowDone = pfnDone;
+	for(i = 0; i < XBEE_TX_WINDOW_SIZE; i++){
+		g_psTxWindow[i].inUse = false;
+	}
+	g_sTxWindowStats.sent = 0;
+	g_sTxWindowStats.delivered = 0;
+	g_sTxWindowStats.failed = 0;
+	g_sTxWindowStats.resends = 0;
+	g_sTxWindowStats.timeouts = 0;
+	g_sTxWindowStats.lastLatencyMs = 0;
+	g_sTxWindowStats.maxLatencyMs = 0;
+	g_sTxWindowStats.inFlightHighWater = 0;
+}
+
+//*****************************************************************************
+// Send a payload in a ZB Transmit Request tracked by the window. The payload is
+// copied, so the caller's buffer can be reused. Return false if the window is
+// full, the payload is too long or UART1 has no room for the frame.
+bool XbeeTxWindowSend(const uint8_t *pui8Payload, uint8_t ui8Length, uint32_t ui32Now){
+	struct tXbeeTxEntry *psEntry = 0;
+	uint8_t ui8InFlight;
+	uint8_t i;
+
+	if(ui8Length > ZB_MAX_RF_PAYLOAD){
+		return false;
+	}
+	for(i = 0; i < XBEE_TX_WINDOW_SIZE; i++){
+		if(!g_psTxWindow[i].inUse){
+			psEntry = &g_psTxWindow[i];
+			break;
+		}
+	}
+	if(!psEntry){
+		return false;
+	}
+
+	for(i = 0; i < ui8Length; i++){
+		psEntry->payload[i] = pui8Payload[i];
+	}
+	psEntry->length = ui8Length;
+	psEntry->resends = 0;
+	psEntry->firstSentMs = ui32Now;
+	if(!txWindowAttempt(psEntry, ui32Now)){
+		return false;
+	}
+	psEntry->inUse = true;
+
+	g_sTxWindowStats.sent++;
+	ui8InFlight = XbeeTxWindowInFlightGet();
+	if(ui8InFlight > g_sTxWindowStats.inFlightHighWater){
+		g_sTxWindowStats.inFlightHighWater = ui8InFlight;
+	}
+	return true;
+}
+
+//*****************************************************************************
+// ZB Transmit Status handler, to be registered with XbeeFrameHandlerSet().
+// Statuses of frames not in flight, such as late ones, are ignored.
+void XbeeTxWindowStatusHandler(const struct tXbeeApiFrame *psFrame){
+	const struct tXbeeTxStatus *psStatus = &psFrame->u.txStatus;
+	struct tXbeeTxEntry *psEntry;
+	uint32_t ui32Now = TimebaseMsGet();
+	uint8_t i;
+
+	for(i = 0; i < XBEE_TX_WINDOW_SIZE; i++){
+		psEntry = &g_psTxWindow[i];
+		if(psEntry->inUse && !psEntry->resendPending && psEntry->frameId == psStatus->frameId){
+			if(psStatus->deliveryStatus == XBEE_DELIVERY_SUCCESS){
+				XbeeAddrLearn(g_pui8ZBCoordinatorAddr64, psStatus->dstAddr16);
+				txWindowComplete(psEntry, psStatus->deliveryStatus, psStatus->retryCount, ui32Now);
+			}
+			else{
+				txWindowFailed(psEntry, psStatus->deliveryStatus, psStatus->retryCount, ui32Now);
+			}
+			return;
+		}
+	}
+}
+
+//*****************************************************************************
+// Resend frames that could not be queued to UART1 and time out attempts left
+// without ZB Transmit Status. Call it periodically from the main loop.
+void XbeeTxWindowProcess(uint32_t ui32Now){
+	struct tXbeeTxEntry *psEntry;
+	uint8_t i;
+
+	for(i = 0; i < XBEE_TX_WINDOW_SIZE; i++){
+		psEntry = &g_psTxWindow[i];
+		if(!psEntry->inUse){
+			continue;
+		}
+		if(psEntry->resendPending){
+			txWindowAttempt(psEntry, ui32Now);
+		}
+		else if(TimebaseDeadlineReached(ui32Now, psEntry->sentMs + XBEE_TX_STATUS_TIMEOUT_MS)){
+			g_sTxWindowStats.timeouts++;
+			txWindowFailed(psEntry, XBEE_DELIVERY_TIMEOUT, 0, ui32Now);
+		}
+	}
+}
+
+//*****************************************************************************
+// Get window statistics.
+void XbeeTxWindowStatsGet(struct tXbeeTxStats *psStats){
+	*psStats = g_sTxWindowStats;
+}
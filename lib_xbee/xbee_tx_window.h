@@ -0,0 +1,83 @@
+/*
+ * xbee_tx_window.h - Keep several ZB Transmit Requests in flight and match
+ * 					  them with the ZB Transmit Status frames sent back by the
+ * 					  module.
+ *
+ * Each frame gets its own frame id and a slot in the window until its status
+ * arrives. Frames whose delivery failed, or whose status did not arrive within
+ * XBEE_TX_STATUS_TIMEOUT_MS, are sent again up to XBEE_TX_MAX_RESENDS times.
+ * The result of every frame is reported once, with its delivery status, the
+ * MAC retries of the last attempt, the resends and the latency from first
+ * send to final status. Frames carry the coordinator 16 bit address once
+ * learned, see xbee_addr_table.h.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef XBEE_TX_WINDOW_H_
+#define XBEE_TX_WINDOW_H_
+
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+
+//*****************************************************************************
+// Window parameters.
+#define XBEE_TX_WINDOW_SIZE				    4		// Frames in flight at once.
+#define XBEE_TX_STATUS_TIMEOUT_MS		 5000		// Time to wait for a ZB Transmit Status.
+#define XBEE_TX_MAX_RESENDS				    2		// Resends after the first attempt.
+
+//*****************************************************************************
+// Delivery status reported when no ZB Transmit Status arrived.
+#define XBEE_DELIVERY_TIMEOUT			 0xFF
+
+//*****************************************************************************
+// Frame in flight.
+struct tXbeeTxEntry{
+	bool inUse;
+	bool resendPending;						// Last attempt failed, send again from XbeeTxWindowProcess.
+	uint8_t frameId;						// Frame id of the last attempt.
+	uint8_t resends;
+	uint32_t firstSentMs;
+	uint32_t sentMs;						// Time of the last attempt.
+	uint8_t length;
+	uint8_t payload[ZB_MAX_RF_PAYLOAD];
+};
+
+//*****************************************************************************
+// Final result of a frame.
+struct tXbeeTxResult{
+	uint8_t frameId;
+	uint8_t deliveryStatus;					// XBEE_DELIVERY_* value from the last attempt.
+	uint8_t retryCount;						// MAC retries of the last attempt.
+	uint8_t resends;
+	uint32_t latencyMs;
+};
+
+//*****************************************************************************
+// Window statistics.
+struct tXbeeTxStats{
+	uint32_t sent;							// Frames accepted by the window.
+	uint32_t delivered;
+	uint32_t failed;
+	uint32_t resends;
+	uint32_t timeouts;						// Attempts without ZB Transmit Status.
+	uint32_t lastLatencyMs;
+	uint32_t maxLatencyMs;
+	uint8_t inFlightHighWater;
+};
+
+//*****************************************************************************
+// Function called with the final result of each frame.
+typedef void (tXbeeTxDoneCallback)(const struct tXbeeTxResult *psResult);
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern void XbeeTxWindowInit(XbeeZB *psXbee, tXbeeTxDoneCallback *pfnDone);
+extern bool XbeeTxWindowSend(const uint8_t *pui8Payload, uint8_t ui8Length, uint32_t ui32Now);
+extern void XbeeTxWindowStatusHandler(const struct tXbeeApiFrame *psFrame);
+extern void XbeeTxWindowProcess(uint32_t ui32Now);
+extern uint8_t XbeeTxWindowInFlightGet(void);
+extern void XbeeTxWindowStatsGet(struct tXbeeTxStats *psStats);
+
+#endif /* XBEE_TX_WINDOW_H_ */
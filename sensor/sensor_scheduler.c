@@ -0,0 +1,389 @@
+/*
+ * sensor_scheduler.c - Non-blocking acquisition of BMP180, SHT21 and ISL29023
+ * 						data over the shared I2C3 bus.
+ *
+ * Every sensor is a small state machine (a task). A task state starts its I2C
+ * transaction and returns immediately; the next state is entered once the
+ * driver callback reports the transaction complete or once a conversion or
+ * settle deadline expires. SensorSchedulerProcess() never waits, so main can
+ * service the xbee UART between any two sensor steps.
+ *
+ * In SENSOR_MODE_SEQUENTIAL one task runs at a time, in sensor id order. In
+ * SENSOR_MODE_OVERLAPPED every task is started together, so the BMP180 polls,
+ * the SHT21 measurement command and the ISL29023 read are all queued in the
+ * tI2CMInstance command queue back to back, and each result is collected when
+ * that device's conversion ends.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor/i2cm_drv.h"
+#include "sensor/hw_bmp180.h"
+#include "sensor/bmp180.h"
+#include "sensor/hw_sht21.h"
+#include "sensor/sht21.h"
+#include "sensor/hw_isl29023.h"
+#include "sensor/isl29023.h"
+#include "lib_utils/timebase.h"
+#include "sensor/sensor_scheduler.h"
+
+//*****************************************************************************
+// The states of a sensor task. Not every sensor uses every state.
+#define TASK_STATE_INIT        0	// Reset the sensor.
+#define TASK_STATE_CONFIG      1	// Configure the sensor after reset.
+#define TASK_STATE_IDLE        2	// Nothing to do until the next sweep.
+#define TASK_STATE_MEAS        3	// Start a conversion.
+#define TASK_STATE_READ        4	// Read the conversion result.
+
+//*****************************************************************************
+// What the current task state is waiting for before it can be started/completed.
+#define TASK_WAIT_NONE         0	// State must be started.
+#define TASK_WAIT_I2C          1	// Waiting for the driver callback.
+#define TASK_WAIT_DELAY        2	// Waiting for ui32DeadlineMs.
+
+//*****************************************************************************
+// Sensor task state.
+typedef struct{
+	uint8_t ui8Sensor;				// SENSOR_BMP180, SENSOR_SHT21 or SENSOR_ISL29023.
+	uint8_t ui8State;				// Current sensor operation.
+	uint8_t ui8Wait;				// What ui8State is waiting for.
+	uint32_t ui32DeadlineMs;		// I2C timeout or end of conversion/settle delay.
+	uint32_t ui32ErrorCount;		// Failed or timed out transactions of this sensor.
+
+	// Completion event written from I2C interrupt context. Each task has at most
+	// one transaction in flight and is the only reader, so the ISR writes
+	// ui8Status then bDone, and main clears bDone, without any locking.
+	volatile uint8_t ui8Status;		// I2CM_STATUS_* of the completed transaction.
+	volatile bool bDone;			// Set when the transaction completed.
+}
+tSensorTask;
+
+//*****************************************************************************
+// Scheduler state.
+typedef struct{
+	tI2CMInstance *psI2CInst;		// I2C master shared by all sensors.
+	tSensorTask psTasks[NUM_SENSORS];
+	uint8_t ui8Mode;				// SENSOR_MODE_SEQUENTIAL or SENSOR_MODE_OVERLAPPED.
+	uint8_t ui8Pending;				// Bit per sensor task with work left in this phase.
+	bool bSweep;					// False while sensors are still being initialized.
+	uint32_t ui32SweepStartMs;		// Time at which the current sweep started.
+	uint32_t ui32SweepMs;			// Duration of the last complete sweep.
+	tSensorReadings sReadings;		// Latest successfully read values.
+}
+tSensorScheduler;
+
+static tSensorScheduler g_sSched;
+
+static tBMP180 g_sBMP180Inst;					// Instance structure for the BMP180 sensor driver.
+static tSHT21 g_sSHT21Inst;						// Instance structure for the SHT21 sensor driver.
+static tISL29023 g_sISL29023Inst;				// Instance structure for the ISL29023 sensor driver.
+
+//*****************************************************************************
+// SHT21, BMP180, ISL29023 sensors callback function. Called at the end of SHT21, BMP180, ISL29023
+// sensor driver transactions. This is called from I2C interrupt context. Therefore, we just post
+// the completion event to the sensor task and let the scheduler do the bulk of the computations.
+// pvCallbackData is the task of the sensor that issued the transaction.
+static void SensorAppCallback(void* pvCallbackData, uint_fast8_t ui8Status){
+	tSensorTask *psTask = (tSensorTask *)pvCallbackData;
+
+	psTask->ui8Status = ui8Status;	// Status must be visible before the done flag.
+	psTask->bDone = true;
+}
+
+//*****************************************************************************
+// Move a task to ui8State once ui32DeadlineMs is reached.
+static void TaskDelay(tSensorTask *psTask, uint8_t ui8State, uint32_t ui32DeadlineMs){
+	psTask->ui8State = ui8State;
+	psTask->ui8Wait = TASK_WAIT_DELAY;
+	psTask->ui32DeadlineMs = ui32DeadlineMs;
+}
+
+//*****************************************************************************
+// Move a task to ui8State and start it on its next step.
+static void TaskNext(tSensorTask *psTask, uint8_t ui8State){
+	psTask->ui8State = ui8State;
+	psTask->ui8Wait = TASK_WAIT_NONE;
+}
+
+//*****************************************************************************
+// The task has nothing left to do in this phase.
+static void TaskIdle(tSensorTask *psTask){
+	TaskNext(psTask, TASK_STATE_IDLE);
+	g_sSched.ui8Pending &= ~(1 << psTask->ui8Sensor);
+}
+
+//*****************************************************************************
+// Start the I2C transaction of the current task state. Return 1 if the driver
+// accepted the request.
+static uint_fast8_t TaskStart(tSensorTask *psTask){
+	uint8_t ui8Mask;
+
+	switch(psTask->ui8Sensor){
+		case SENSOR_BMP180:
+			if(psTask->ui8State == TASK_STATE_INIT){
+				return BMP180Init(&g_sBMP180Inst, g_sSched.psI2CInst, BMP180_I2C_ADDRESS,
+								  SensorAppCallback, psTask);
+			}
+			// This command starts a temperature measurement, polls until it is ready, then
+			// starts a pressure measurement and polls for that to complete. Polling is
+			// done on I2C interrupts so the processor is free meanwhile.
+			return BMP180DataRead(&g_sBMP180Inst, SensorAppCallback, psTask);
+
+		case SENSOR_SHT21:
+			if(psTask->ui8State == TASK_STATE_INIT){
+				return SHT21Init(&g_sSHT21Inst, g_sSched.psI2CInst, SHT21_I2C_ADDRESS,
+								 SensorAppCallback, psTask);
+			}
+			if(psTask->ui8State == TASK_STATE_MEAS){
+				// Write the command to start a humidity measurement. The no hold master
+				// command leaves the bus free for the other sensors during conversion.
+				return SHT21Write(&g_sSHT21Inst, SHT21_CMD_MEAS_RH, g_sSHT21Inst.pui8Data, 0,
+								  SensorAppCallback, psTask);
+			}
+			// Get the raw data from the sensor over the I2C bus.
+			return SHT21DataRead(&g_sSHT21Inst, SensorAppCallback, psTask);
+
+		case SENSOR_ISL29023:
+			if(psTask->ui8State == TASK_STATE_INIT){
+				return ISL29023Init(&g_sISL29023Inst, g_sSched.psI2CInst, ISL29023_I2C_ADDRESS,
+									SensorAppCallback, psTask);
+			}
+			if(psTask->ui8State == TASK_STATE_CONFIG){
+				// Configure the ISL29023 to measure ambient light continuously. Set a 8
+				// sample persistence before the INT pin is asserted. Clears the INT flag.
+				// Persistence setting of 8 is sufficient to ignore camera flashes.
+				ui8Mask = (ISL29023_CMD_I_OP_MODE_M | ISL29023_CMD_I_INT_PERSIST_M | ISL29023_CMD_I_INT_FLAG_M);
+				return ISL29023ReadModifyWrite(&g_sISL29023Inst, ISL29023_O_CMD_I, ~ui8Mask,
+											   (ISL29023_CMD_I_OP_MODE_ALS_CONT | ISL29023_CMD_I_INT_PERSIST_8),
+											   SensorAppCallback, psTask);
+			}
+			return ISL29023DataRead(&g_sISL29023Inst, SensorAppCallback, psTask);
+
+		default:
+			return 0;
+	}
+}
+
+//*****************************************************************************
+// Handle the end of the current task state's transaction and select the next one.
+static void TaskComplete(tSensorTask *psTask, uint_fast8_t ui8Status, uint32_t ui32NowMs){
+	bool bSuccess = (ui8Status == I2CM_STATUS_SUCCESS);
+
+	if(!bSuccess){
+		psTask->ui32ErrorCount++;
+	}
+
+	switch(psTask->ui8Sensor){
+		case SENSOR_BMP180:
+			if(psTask->ui8State == TASK_STATE_INIT){
+				TaskDelay(psTask, TASK_STATE_IDLE, ui32NowMs + SENSOR_SETTLE_MS);
+				break;
+			}
+			if(bSuccess){
+				BMP180DataTemperatureGetFloat(&g_sBMP180Inst, &g_sSched.sReadings.fTemp);
+				BMP180DataPressureGetFloat(&g_sBMP180Inst, &g_sSched.sReadings.fPres);
+			}
+			TaskIdle(psTask);
+			break;
+
+		case SENSOR_SHT21:
+			if(psTask->ui8State == TASK_STATE_INIT){
+				TaskDelay(psTask, TASK_STATE_IDLE, ui32NowMs + SENSOR_SETTLE_MS);
+			}
+			else if(psTask->ui8State == TASK_STATE_MEAS){
+				// Let the conversion run instead of spinning on it. Nothing to read if
+				// the command did not reach the sensor.
+				if(bSuccess){
+					TaskDelay(psTask, TASK_STATE_READ, ui32NowMs + SHT21_MEAS_RH_MS);
+				}
+				else{
+					TaskIdle(psTask);
+				}
+			}
+			else{
+				if(bSuccess){
+					SHT21DataHumidityGetFloat(&g_sSHT21Inst, &g_sSched.sReadings.fHum);
+					g_sSched.sReadings.fHum *= 100.0f;		// Multiply by 100 to return percentage.
+				}
+				TaskIdle(psTask);
+			}
+			break;
+
+		case SENSOR_ISL29023:
+			if(psTask->ui8State == TASK_STATE_INIT){
+				TaskNext(psTask, TASK_STATE_CONFIG);
+			}
+			else if(psTask->ui8State == TASK_STATE_CONFIG){
+				TaskDelay(psTask, TASK_STATE_IDLE, ui32NowMs + SENSOR_SETTLE_MS);
+			}
+			else{
+				if(bSuccess){
+					ISL29023DataLightVisibleGetFloat(&g_sISL29023Inst, &g_sSched.sReadings.fLight);
+				}
+				TaskIdle(psTask);
+			}
+			break;
+
+		default:
+			TaskIdle(psTask);
+			break;
+	}
+}
+
+//*****************************************************************************
+// Advance one task by at most one step without blocking.
+static void TaskProcess(tSensorTask *psTask, uint32_t ui32NowMs){
+	uint_fast8_t ui8Status;
+
+	switch(psTask->ui8Wait){
+		case TASK_WAIT_I2C:
+			if(psTask->bDone){
+				psTask->bDone = false;
+				ui8Status = psTask->ui8Status;
+			}
+			else if(TimebaseDeadlineReached(ui32NowMs, psTask->ui32DeadlineMs)){
+				ui8Status = I2CM_STATUS_ERROR;
+			}
+			else{
+				return;
+			}
+			TaskComplete(psTask, ui8Status, ui32NowMs);
+			return;
+
+		case TASK_WAIT_DELAY:
+			if(!TimebaseDeadlineReached(ui32NowMs, psTask->ui32DeadlineMs)){
+				return;
+			}
+			psTask->ui8Wait = TASK_WAIT_NONE;
+			// Fall through and start the state right away.
+
+		case TASK_WAIT_NONE:
+		default:
+			// A delay into the idle state ends the task's work for this phase.
+			if(psTask->ui8State == TASK_STATE_IDLE){
+				TaskIdle(psTask);
+				return;
+			}
+			psTask->bDone = false;
+			if(TaskStart(psTask) == 0){
+				// The driver refused the request (busy or I2C queue full). Skip it.
+				TaskComplete(psTask, I2CM_STATUS_ERROR, ui32NowMs);
+				return;
+			}
+			psTask->ui8Wait = TASK_WAIT_I2C;
+			psTask->ui32DeadlineMs = ui32NowMs + SENSOR_I2C_TIMEOUT_MS;
+			return;
+	}
+}
+
+//*****************************************************************************
+// Put every task in ui8State and mark it pending.
+static void SchedulerPhaseStart(uint8_t ui8State){
+	uint8_t ui8Idx;
+
+	for(ui8Idx = 0; ui8Idx < NUM_SENSORS; ui8Idx++){
+		TaskNext(&g_sSched.psTasks[ui8Idx], ui8State);
+	}
+	// The SHT21 conversion must be started before it can be read.
+	if(ui8State == TASK_STATE_READ){
+		TaskNext(&g_sSched.psTasks[SENSOR_SHT21], TASK_STATE_MEAS);
+	}
+	g_sSched.ui8Pending = (1 << NUM_SENSORS) - 1;
+}
+
+//*****************************************************************************
+// Prepare the scheduler. Sensors are reset and configured by the first calls
+// to SensorSchedulerProcess(), so this returns immediately.
+void SensorSchedulerInit(tI2CMInstance *psI2CInst){
+	uint8_t ui8Idx;
+
+	g_sSched.psI2CInst = psI2CInst;
+	g_sSched.ui8Mode = SENSOR_MODE_OVERLAPPED;
+	g_sSched.bSweep = false;
+	g_sSched.ui32SweepMs = 0;
+	g_sSched.sReadings.fTemp = 0.0f;
+	g_sSched.sReadings.fPres = 0.0f;
+	g_sSched.sReadings.fHum = 0.0f;
+	g_sSched.sReadings.fLight = 0.0f;
+	for(ui8Idx = 0; ui8Idx < NUM_SENSORS; ui8Idx++){
+		g_sSched.psTasks[ui8Idx].ui8Sensor = ui8Idx;
+		g_sSched.psTasks[ui8Idx].ui32ErrorCount = 0;
+		g_sSched.psTasks[ui8Idx].bDone = false;
+	}
+	SchedulerPhaseStart(TASK_STATE_INIT);
+}
+
+//*****************************************************************************
+// Select how sensors are sequenced. Takes effect from the next sweep.
+void SensorSchedulerModeSet(uint8_t ui8Mode){
+	g_sSched.ui8Mode = ui8Mode;
+}
+
+//*****************************************************************************
+// Advance the sensor tasks without blocking. Call it from the main loop as
+// often as possible. Return true when a new set of readings is available from
+// SensorSchedulerReadingsGet().
+bool SensorSchedulerProcess(uint32_t ui32NowMs){
+	uint8_t ui8Idx;
+
+	// Between sweeps, wait for the next sweep start.
+	if(g_sSched.ui8Pending == 0){
+		if(!TimebaseDeadlineReached(ui32NowMs, g_sSched.ui32SweepStartMs)){
+			return false;
+		}
+		g_sSched.ui32SweepStartMs = ui32NowMs;
+		SchedulerPhaseStart(TASK_STATE_READ);
+	}
+
+	for(ui8Idx = 0; ui8Idx < NUM_SENSORS; ui8Idx++){
+		if(g_sSched.ui8Pending & (1 << ui8Idx)){
+			TaskProcess(&g_sSched.psTasks[ui8Idx], ui32NowMs);
+
+			// Sequential mode and sensor initialization run one task at a time.
+			if((g_sSched.ui8Mode == SENSOR_MODE_SEQUENTIAL) || !g_sSched.bSweep){
+				break;
+			}
+		}
+	}
+
+	if(g_sSched.ui8Pending != 0){
+		return false;
+	}
+
+	// Sensors are initialized, first sweep can start now.
+	if(!g_sSched.bSweep){
+		g_sSched.bSweep = true;
+		g_sSched.ui32SweepStartMs = ui32NowMs;
+		return false;
+	}
+
+	// Sweep complete. Next one starts one period after this one did, or now if we are late.
+	g_sSched.ui32SweepMs = ui32NowMs - g_sSched.ui32SweepStartMs;
+	g_sSched.ui32SweepStartMs += SENSOR_SWEEP_PERIOD_MS;
+	return true;
+}
+
+//*****************************************************************************
+// Get a copy of the latest sensor readings.
+void SensorSchedulerReadingsGet(tSensorReadings *psReadings){
+	*psReadings = g_sSched.sReadings;
+}
+
+//*****************************************************************************
+// Get the duration in milliseconds of the last complete sweep, from the start
+// of the first conversion to the collection of the last result.
+uint32_t SensorSchedulerSweepTimeGet(void){
+	return g_sSched.ui32SweepMs;
+}
+
+//*****************************************************************************
+// Get the number of failed or timed out transactions of sensor ui8Sensor.
+uint32_t SensorSchedulerErrorCountGet(uint8_t ui8Sensor){
+	if(ui8Sensor >= NUM_SENSORS){
+		return 0;
+	}
+	return g_sSched.psTasks[ui8Sensor].ui32ErrorCount;
+}
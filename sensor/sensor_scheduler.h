@@ -0,0 +1,78 @@
+/*
+ * sensor_scheduler.h - Non-blocking acquisition of BMP180, SHT21 and ISL29023
+ * 						data over the shared I2C3 bus.
+ *
+ *  Created on: 17-10-2026
+ *      Author: r9hino
+ */
+
+#ifndef SENSOR_SCHEDULER_H_
+#define SENSOR_SCHEDULER_H_
+
+//*****************************************************************************
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+// Define I2C Devices Addresses.
+#define BMP180_I2C_ADDRESS      0x77
+#define SHT21_I2C_ADDRESS  		0x40
+#define ISL29023_I2C_ADDRESS    0x44
+
+//*****************************************************************************
+// Scheduler timings in milliseconds.
+#define SENSOR_SWEEP_PERIOD_MS		1000	// Time between the start of two sensor sweeps.
+#define SENSOR_SETTLE_MS			  33	// Wait after a sensor reset or configuration.
+#define SHT21_MEAS_RH_MS			  33	// SHT21 RH conversion. Datasheet claims up to 29 ms.
+#define SENSOR_I2C_TIMEOUT_MS		 100	// Give up on a transaction without callback.
+
+//*****************************************************************************
+// Sensor ids. Also the bit position of each sensor in the scheduler pending mask.
+#define SENSOR_BMP180				0
+#define SENSOR_SHT21				1
+#define SENSOR_ISL29023				2
+#define NUM_SENSORS					3
+
+//*****************************************************************************
+// Acquisition modes.
+//
+// Sweep time model (standard BMP180 mode, 100 kHz I2C):
+//   BMP180 temperature + pressure conversion      ~ 4.5 + 7.5 ms
+//   SHT21 12 bit RH conversion                    ~ SHT21_MEAS_RH_MS
+//   ISL29023 register read (continuous ALS)       < 1 ms
+// SEQUENTIAL sweep is the sum (~46 ms), OVERLAPPED sweep is the slowest
+// sensor plus interleaved bus transfers (~34 ms). The achieved value is
+// returned by SensorSchedulerSweepTimeGet().
+#define SENSOR_MODE_SEQUENTIAL		0	// One sensor at a time.
+#define SENSOR_MODE_OVERLAPPED		1	// All conversions run concurrently.
+
+//*****************************************************************************
+// Latest values read from the sensors.
+typedef struct{
+	float fTemp;				// Temperature.
+	float fPres;				// Pressure.
+	float fHum;					// Humidity.
+	float fLight;				// Ambient Light.
+}
+tSensorReadings;
+
+//*****************************************************************************
+// Prototypes for the APIs.
+extern void SensorSchedulerInit(tI2CMInstance *psI2CInst);
+extern bool SensorSchedulerProcess(uint32_t ui32NowMs);
+extern void SensorSchedulerModeSet(uint8_t ui8Mode);
+extern void SensorSchedulerReadingsGet(tSensorReadings *psReadings);
+extern uint32_t SensorSchedulerSweepTimeGet(void);
+extern uint32_t SensorSchedulerErrorCountGet(uint8_t ui8Sensor);
+
+//*****************************************************************************
+// Mark the end of the C bindings section for C++ compilers.
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_SCHEDULER_H_ */
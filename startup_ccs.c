@@ -57,8 +57,10 @@ extern uint32_t __STACK_TOP;
 //
 //*****************************************************************************
 extern void UARTStdioIntHandler(void);	// Used in UART1
+extern void UART0IntHandler(void);		// UART0 console
 extern void Timer0IntHandler(void);
 extern void SensorI2CIntHandler(void);
+extern void TimebaseIntHandler(void);
 
 //*****************************************************************************
 //
@@ -86,13 +88,13 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // Debug monitor handler
     0,                                      // Reserved
     IntDefaultHandler,                      // The PendSV handler
-    IntDefaultHandler,                      // The SysTick handler
+    TimebaseIntHandler,                      // The SysTick handler
     IntDefaultHandler,                      // GPIO Port A
     IntDefaultHandler,                      // GPIO Port B
     IntDefaultHandler,                      // GPIO Port C
     IntDefaultHandler,                      // GPIO Port D
     IntDefaultHandler,                      // GPIO Port E
-    IntDefaultHandler,                      // UART0 Rx and Tx
+    UART0IntHandler,                        // UART0 Rx and Tx
     UARTStdioIntHandler,                      // UART1 Rx and Tx
     IntDefaultHandler,                      // SSI0 Rx and Tx
     IntDefaultHandler,                      // I2C0 Master and Slave
@@ -0,0 +1,130 @@
+//*****************************************************************************
+//
+// bench_api_mode.cpp - Wire size, build and parse time of frames in API mode
+//                      2 (escaped) and API mode 1 (unescaped).
+//
+// ZB Transmit Requests with BENCH_PAYLOAD random bytes, to an address with
+// special bytes in it, are built and looped back from UART1 transmit to the
+// receive ring, then parsed by the zero copy parser and checked.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "host_uart.h"
+
+//*****************************************************************************
+// Benchmark parameters.
+#define BENCH_FRAMES		200000
+#define BENCH_PAYLOAD		ZB_MAX_RF_PAYLOAD
+
+static uint64_t g_ui64BenchWire;
+
+//*****************************************************************************
+// Loop frames written to UART1 back to the receive ring.
+static void benchLoopback(const uint8_t *pui8Buf, uint32_t ui32Len){
+	g_ui64BenchWire += ui32Len;
+	HostUartReceive(pui8Buf, ui32Len);
+}
+
+static double benchNs(void){
+	struct timespec sNow;
+
+	clock_gettime(CLOCK_MONOTONIC, &sNow);
+	return sNow.tv_sec * 1e9 + sNow.tv_nsec;
+}
+
+//*****************************************************************************
+// Build, loop back and parse BENCH_FRAMES frames. Random payloads, or
+// payloads made only of start bytes when bSpecial is set.
+static void benchRun(uint8_t ui8Mode, bool bSpecial){
+	static const uint8_t pui8Addr64[8] = {0x00, 0x13, 0xA2, 0x00, 0x41, 0x7E, 0x11, 0x13};
+	XbeeZB sXbee;
+	struct tXbeeTxHeader sHeader;
+	struct tXbeeTxSegment sSegment;
+	const struct tXbeeRxSlot *psSlot;
+	uint8_t pui8Payload[BENCH_PAYLOAD];
+	uint8_t pui8Data[BENCH_PAYLOAD + ZB_TX_HEADER_SIZE + 1];
+	uint32_t ui32Bad = 0;
+	double dBuildNs = 0, dParseNs = 0, dT0, dT1, dT2;
+	uint32_t f;
+	uint8_t i;
+
+	HostUartInit();
+	HostUartWriteHookSet(benchLoopback);
+	sXbee.begin();
+	sXbee.setApiMode(ui8Mode);
+	sXbee.buildTxHeader(&sHeader, pui8Addr64, 0x7D33, 0, 0);
+	sSegment.data = pui8Payload;
+	sSegment.length = BENCH_PAYLOAD;
+	g_ui64BenchWire = 0;
+	srand(1);
+
+	for(f = 0; f < BENCH_FRAMES; f++){
+		for(i = 0; i < BENCH_PAYLOAD; i++){
+			pui8Payload[i] = bSpecial ? START_BYTE : rand();
+		}
+		dT0 = benchNs();
+		sXbee.ZBTransmitRequest(&sHeader, &sSegment, 1, (uint8_t)f);
+		dT1 = benchNs();
+		psSlot = sXbee.ZBRxFrameReceive();
+		dT2 = benchNs();
+		dBuildNs += dT1 - dT0;
+		dParseNs += dT2 - dT1;
+
+		// Frame data: frame id, addresses, radius and options, then the payload.
+		if(!psSlot){
+			ui32Bad++;
+			continue;
+		}
+		XbeeViewCopy(&psSlot->data, pui8Data, sizeof(pui8Data));
+		if((XbeeViewLength(&psSlot->data) != sizeof(pui8Data)) || (pui8Data[0] != (uint8_t)f) ||
+		   memcmp(pui8Data + 1 + ZB_TX_HEADER_SIZE, pui8Payload, BENCH_PAYLOAD)){
+			ui32Bad++;
+		}
+		sXbee.ZBRxFrameRelease();
+	}
+	printf("API mode %u, %s payload: %5.1f wire bytes/frame, build %4.0f ns, parse %4.0f ns,"
+		   " %u bad, %u rx errors\n", ui8Mode, bSpecial ? "0x7E" : "random",
+		   (double)g_ui64BenchWire / BENCH_FRAMES, dBuildNs / BENCH_FRAMES, dParseNs / BENCH_FRAMES,
+		   (unsigned)ui32Bad, (unsigned)sXbee.getRxErrorCount());
+}
+
+//*****************************************************************************
+// In API mode 1, 0x7E and 0x7D are data inside a frame, and a frame is
+// found again after bytes outside frames.
+static bool benchUnescapedFraming(void){
+	static const uint8_t pui8Payload[4] = {START_BYTE, ESCAPE_BYTE, START_BYTE, XON_BYTE};
+	static const uint8_t ui8Noise = 0x55;
+	XbeeZB sXbee;
+	uint32_t ui32Frames = 0;
+
+	HostUartInit();
+	HostUartWriteHookSet(benchLoopback);
+	sXbee.begin();
+	sXbee.setApiMode(API_MODE_UNESCAPED);
+	sXbee.ZBTransmitRequest(pui8Payload, sizeof(pui8Payload), 9);
+	HostUartReceive(&ui8Noise, 1);
+	sXbee.ZBTransmitRequest(pui8Payload, sizeof(pui8Payload), 10);
+	while(sXbee.ZBRxFrameReceive() != 0){
+		ui32Frames++;
+		sXbee.ZBRxFrameRelease();
+	}
+	printf("API mode 1 special bytes: %u of 2 frames, %u rx errors\n", (unsigned)ui32Frames,
+		   (unsigned)sXbee.getRxErrorCount());
+	return ui32Frames == 2;
+}
+
+int main(void){
+	benchRun(API_MODE_ESCAPED, false);
+	benchRun(API_MODE_UNESCAPED, false);
+	benchRun(API_MODE_ESCAPED, true);
+	benchRun(API_MODE_UNESCAPED, true);
+	return benchUnescapedFraming() ? 0 : 1;
+}
@@ -0,0 +1,322 @@
+//*****************************************************************************
+//
+// bench_rx_parser.cpp - Bytes per second parsed by the zero copy receive
+//                       parser and by the byte copying parser it replaced.
+//
+// The byte copying parser is ZBReceivePacket() as it was before the zero copy
+// parser, kept here since the driver no longer has it: every byte is taken out
+// of the UART1 ring with UARTgetc(), echoed to UART0 and copied to rxFrameData
+// and message. It runs with the reset that cleared both buffers before each
+// frame and with the reset of the frame state only.
+//
+// The parsers read the same streams of escaped ZB Receive Packet frames from
+// the host UART1 ring: command text, and short back to back frames where the
+// reset is paid on every few bytes. Only the time spent in the parser and in
+// the copy of the command text is measured.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "driverlib/rom.h"
+#include "lib_utils/uartstdio.h"
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "host_uart.h"
+
+//*****************************************************************************
+// Benchmark parameters.
+#define BENCH_FRAMES		20000		// Frames in the stream.
+#define BENCH_PAYLOAD_MIN	8			// Command text length range.
+#define BENCH_PAYLOAD_MAX	72
+#define BENCH_SHORT_MIN		1			// Short frame payload length range.
+#define BENCH_SHORT_MAX		4
+#define BENCH_ROUNDS		5			// Best of this many runs is reported.
+
+//*****************************************************************************
+// State of the byte copying parser, as in the former struct tXbee.
+static struct{
+	uint8_t rxFrameData[MAX_FRAME_SIZE];
+	uint8_t pos;
+	uint8_t lsbRxFrameLength;
+	uint8_t frameType;
+	uint16_t rxChecksumTotal;
+	uint8_t message[MAX_FRAME_SIZE - 16];
+	uint8_t messageIdx;
+	uint8_t errorCode;
+	bool escape;
+	bool rxComplete;
+}
+g_sLegacy;
+
+static bool g_bLegacyPayloadComplete;
+static bool g_bLegacyClear;				// Reset clears the buffers.
+
+//*****************************************************************************
+// Parsers compared.
+#define BENCH_LEGACY_CLEAR		0
+#define BENCH_LEGACY_STATE		1
+#define BENCH_ZERO_COPY			2
+
+static uint8_t *g_pui8Stream;
+static uint32_t g_ui32StreamLen;
+static uint32_t g_ui32Frames;
+static uint32_t g_ui32TextBytes;
+static uint8_t g_pui8Command[MAX_FRAME_SIZE];
+
+//*****************************************************************************
+// uartstdio receive functions used by the byte copying parser.
+static int benchRxBytesAvail(void){
+	return (UARTRxWriteIndexGet() + UART_RX_BUFFER_SIZE - UARTRxReadIndexGet()) % UART_RX_BUFFER_SIZE;
+}
+
+static unsigned char benchGetc(void){
+	uint32_t ui32Read = UARTRxReadIndexGet();
+	unsigned char cChar = UARTRxBufferGet()[ui32Read];
+
+	UARTRxBufferRelease((ui32Read + 1) % UART_RX_BUFFER_SIZE);
+	return cChar;
+}
+
+//*****************************************************************************
+// Former resetXbeeFrameInfo(), clearing all frame data or the state only.
+static void legacyReset(void){
+	uint8_t i;
+
+	if(g_bLegacyClear){
+		for(i = 0; i < MAX_FRAME_SIZE; i++){
+			g_sLegacy.rxFrameData[i] = 0;
+			if(i < MAX_FRAME_SIZE - 16) g_sLegacy.message[i] = 0;
+		}
+	}
+	g_sLegacy.pos = 0;
+	g_sLegacy.lsbRxFrameLength = 0;
+	g_sLegacy.frameType = 0;
+	g_sLegacy.rxChecksumTotal = 0;
+	g_sLegacy.messageIdx = 0;
+	g_sLegacy.errorCode = 0;
+	g_sLegacy.escape = false;
+	g_sLegacy.rxComplete = false;
+	g_bLegacyPayloadComplete = false;
+}
+
+//*****************************************************************************
+// Former ZBReceivePacket().
+static void legacyReceivePacket(void){
+	uint8_t rxB;
+
+	if(g_sLegacy.rxComplete || g_sLegacy.errorCode){
+		legacyReset();
+	}
+
+	while(benchRxBytesAvail()){
+		rxB = (uint8_t)benchGetc();
+		ROM_UARTCharPutNonBlocking(UART0_BASE, rxB);
+
+		if(g_sLegacy.pos > 0 && rxB == START_BYTE){
+			g_sLegacy.errorCode = UNEXPECTED_START_BYTE;
+			return;
+		}
+		if((g_sLegacy.pos > 0) && (rxB == ESCAPE_BYTE)){
+			g_sLegacy.escape = true;
+			continue;
+		}
+		if(g_sLegacy.escape == true){
+			rxB = 0x20 ^ rxB;
+			g_sLegacy.escape = false;
+		}
+		if(g_sLegacy.pos >= FRAME_TYPE_IDX){
+			g_sLegacy.rxChecksumTotal += rxB;
+		}
+
+		switch(g_sLegacy.pos){
+			case 0:
+				if(rxB == START_BYTE){
+					g_sLegacy.rxFrameData[g_sLegacy.pos] = rxB;
+					g_sLegacy.pos++;
+				}
+				break;
+			case 1:
+				g_sLegacy.rxFrameData[g_sLegacy.pos] = rxB;
+				g_sLegacy.pos++;
+				break;
+			case 2:
+				g_sLegacy.lsbRxFrameLength = rxB;
+				g_sLegacy.rxFrameData[g_sLegacy.pos] = rxB;
+				g_sLegacy.pos++;
+				break;
+			case 3:
+				g_sLegacy.frameType = rxB;
+				g_sLegacy.rxFrameData[g_sLegacy.pos] = rxB;
+				g_sLegacy.pos++;
+				break;
+			default:
+				if(g_sLegacy.pos >= MAX_FRAME_SIZE){
+					g_sLegacy.errorCode = PACKET_EXCEEDS_BYTE_ARRAY_LENGTH;
+					return;
+				}
+				if((g_sLegacy.pos >= RECEIVED_DATA_IDX) &&
+				   (g_sLegacy.pos < (g_sLegacy.lsbRxFrameLength + FRAME_TYPE_IDX)) &&
+				   (g_sLegacy.frameType == 0x90)){
+					if(g_sLegacy.messageIdx >= sizeof(g_sLegacy.message) - 1){
+						g_sLegacy.errorCode = PACKET_EXCEEDS_BYTE_ARRAY_LENGTH;
+						return;
+					}
+					g_sLegacy.message[g_sLegacy.messageIdx] = rxB;
+					g_sLegacy.messageIdx++;
+				}
+				else if(g_sLegacy.pos == (g_sLegacy.lsbRxFrameLength + FRAME_TYPE_IDX)){
+					if((g_sLegacy.rxChecksumTotal & 0xff) == 0xff){
+						g_sLegacy.message[g_sLegacy.messageIdx] = 0;
+						g_sLegacy.rxComplete = true;
+						g_bLegacyPayloadComplete = true;
+						g_sLegacy.errorCode = NO_ERROR;
+						ROM_UARTCharPutNonBlocking(UART0_BASE, '\n');
+						ROM_UARTCharPutNonBlocking(UART0_BASE, '\r');
+						return;
+					}
+					else{
+						g_sLegacy.errorCode = CHECKSUM_FAILURE;
+						return;
+					}
+				}
+				g_sLegacy.rxFrameData[g_sLegacy.pos] = rxB;
+				g_sLegacy.pos++;
+		}
+	}
+}
+
+//*****************************************************************************
+// Build BENCH_FRAMES escaped ZB Receive Packet frames carrying ui8Min to
+// ui8Max bytes of text, from random senders so that some address bytes need
+// escaping.
+static void benchStreamBuild(uint8_t ui8Min, uint8_t ui8Max){
+	uint8_t pui8Frame[MAX_FRAME_SIZE];
+	uint8_t ui8Len;
+	uint8_t ui8Sum;
+	uint32_t i;
+	uint8_t j;
+
+	if(!g_pui8Stream){
+		g_pui8Stream = (uint8_t *)malloc(BENCH_FRAMES * 2 * MAX_FRAME_SIZE);
+	}
+	g_ui32StreamLen = 0;
+	g_ui32TextBytes = 0;
+	srand(1);
+	for(i = 0; i < BENCH_FRAMES; i++){
+		ui8Len = ui8Min + rand() % (ui8Max - ui8Min + 1);
+		pui8Frame[0] = START_BYTE;
+		pui8Frame[1] = 0;
+		pui8Frame[2] = 12 + ui8Len;
+		pui8Frame[3] = ZB_RECEIVE_PACKET;
+		for(j = 4; j < 14; j++){
+			pui8Frame[j] = rand();
+		}
+		pui8Frame[14] = 0x01;
+		for(j = 0; j < ui8Len; j++){
+			pui8Frame[RECEIVED_DATA_IDX + j] = 'a' + rand() % 26;
+		}
+		ui8Sum = 0;
+		for(j = FRAME_TYPE_IDX; j < RECEIVED_DATA_IDX + ui8Len; j++){
+			ui8Sum += pui8Frame[j];
+		}
+		pui8Frame[RECEIVED_DATA_IDX + ui8Len] = 0xFF - ui8Sum;
+		g_ui32StreamLen += HostFrameEscape(pui8Frame, RECEIVED_DATA_IDX + ui8Len + 1,
+										   g_pui8Stream + g_ui32StreamLen);
+		g_ui32TextBytes += ui8Len;
+	}
+}
+
+//*****************************************************************************
+// Handler of ZB Receive Packet frames, copying the command text as main does.
+static void benchRxPacket(const struct tXbeeApiFrame *psFrame){
+	uint16_t ui16Len = XbeeViewCopy(&psFrame->u.rxPacket.data, g_pui8Command, sizeof(g_pui8Command) - 1);
+
+	g_pui8Command[ui16Len] = 0;
+	g_ui32Frames++;
+}
+
+static long benchElapsedNs(const struct timespec *psStart){
+	struct timespec sEnd;
+
+	clock_gettime(CLOCK_MONOTONIC, &sEnd);
+	return (sEnd.tv_sec - psStart->tv_sec) * 1000000000L + (sEnd.tv_nsec - psStart->tv_nsec);
+}
+
+//*****************************************************************************
+// Feed the stream to the UART1 ring as fast as it has room, and run one of the
+// parsers after each block. Return the parser time in nanoseconds.
+static long benchRun(XbeeZB *psXbee, uint8_t ui8Parser){
+	const struct tXbeeRxSlot *psSlot;
+	struct timespec sStart;
+	uint32_t ui32Fed = 0;
+	long lNs = 0;
+
+	HostUartInit();
+	*psXbee = XbeeZB();
+	psXbee->begin();
+	g_bLegacyClear = (ui8Parser == BENCH_LEGACY_CLEAR);
+	legacyReset();
+	g_ui32Frames = 0;
+
+	while(ui32Fed < g_ui32StreamLen || benchRxBytesAvail()){
+		ui32Fed += HostUartReceive(g_pui8Stream + ui32Fed, g_ui32StreamLen - ui32Fed);
+
+		clock_gettime(CLOCK_MONOTONIC, &sStart);
+		if(ui8Parser != BENCH_ZERO_COPY){
+			while(benchRxBytesAvail()){
+				legacyReceivePacket();
+				if(g_bLegacyPayloadComplete){
+					g_bLegacyPayloadComplete = false;
+					memcpy(g_pui8Command, g_sLegacy.message, g_sLegacy.messageIdx + 1);
+					g_ui32Frames++;
+				}
+			}
+		}
+		else{
+			while((psSlot = psXbee->ZBRxFrameReceive()) != 0){
+				XbeeFrameDispatch(psSlot);
+				psXbee->ZBRxFrameRelease();
+			}
+		}
+		lNs += benchElapsedNs(&sStart);
+	}
+	return lNs;
+}
+
+static void benchReport(XbeeZB *psXbee, const char *pcName, uint8_t ui8Parser){
+	long lNs, lBestNs = -1;
+	uint8_t i;
+
+	for(i = 0; i < BENCH_ROUNDS; i++){
+		lNs = benchRun(psXbee, ui8Parser);
+		if((lBestNs < 0) || (lNs < lBestNs)){
+			lBestNs = lNs;
+		}
+	}
+	printf("%-30s frames %u/%u  %7.1f MB/s  %6.1f ns/byte  %6.1f ns/frame\n", pcName,
+		   (unsigned)g_ui32Frames, BENCH_FRAMES, g_ui32StreamLen * 1000.0 / lBestNs,
+		   (double)lBestNs / g_ui32StreamLen, (double)lBestNs / BENCH_FRAMES);
+}
+
+static void benchStream(XbeeZB *psXbee, const char *pcName, uint8_t ui8Min, uint8_t ui8Max){
+	benchStreamBuild(ui8Min, ui8Max);
+	printf("%s: %u bytes, %u bytes of text\n", pcName, (unsigned)g_ui32StreamLen,
+		   (unsigned)g_ui32TextBytes);
+	benchReport(psXbee, "ZBReceivePacket, clear buffers", BENCH_LEGACY_CLEAR);
+	benchReport(psXbee, "ZBReceivePacket, reset state", BENCH_LEGACY_STATE);
+	benchReport(psXbee, "ZBRxFrameReceive", BENCH_ZERO_COPY);
+}
+
+int main(void){
+	XbeeZB sXbee;
+
+	XbeeFrameHandlerSet(ZB_RECEIVE_PACKET, benchRxPacket);
+	benchStream(&sXbee, "command frames", BENCH_PAYLOAD_MIN, BENCH_PAYLOAD_MAX);
+	benchStream(&sXbee, "short frames", BENCH_SHORT_MIN, BENCH_SHORT_MAX);
+	return 0;
+}
@@ -0,0 +1,6 @@
+// Host stand-in, see tivaware.h.
+#include "tivaware.h"
+
+#ifndef ROM_UARTCharPutNonBlocking
+#define ROM_UARTCharPutNonBlocking(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
@@ -0,0 +1,97 @@
+// Host stand-in, see tivaware.h. A simulation can define any of these
+// functions before this file is included to model the peripheral.
+#include "tivaware.h"
+
+#ifndef MAP_IntDisable
+#define MAP_IntDisable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_IntEnable
+#define MAP_IntEnable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_IntMasterDisable
+#define MAP_IntMasterDisable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_IntMasterEnable
+#define MAP_IntMasterEnable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_SysCtlPeripheralEnable
+#define MAP_SysCtlPeripheralEnable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_SysCtlPeripheralPresent
+#define MAP_SysCtlPeripheralPresent(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTBusy
+#define MAP_UARTBusy(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTCharGet
+#define MAP_UARTCharGet(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTCharGetNonBlocking
+#define MAP_UARTCharGetNonBlocking(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTCharPut
+#define MAP_UARTCharPut(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTCharPutNonBlocking
+#define MAP_UARTCharPutNonBlocking(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTCharsAvail
+#define MAP_UARTCharsAvail(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTConfigSetExpClk
+#define MAP_UARTConfigSetExpClk(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTDMAEnable
+#define MAP_UARTDMAEnable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTEnable
+#define MAP_UARTEnable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTFIFOLevelSet
+#define MAP_UARTFIFOLevelSet(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTFlowControlSet
+#define MAP_UARTFlowControlSet(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTIntClear
+#define MAP_UARTIntClear(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTIntDisable
+#define MAP_UARTIntDisable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTIntEnable
+#define MAP_UARTIntEnable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTIntStatus
+#define MAP_UARTIntStatus(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTSpaceAvail
+#define MAP_UARTSpaceAvail(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_UARTTxIntModeSet
+#define MAP_UARTTxIntModeSet(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_uDMAChannelAttributeDisable
+#define MAP_uDMAChannelAttributeDisable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_uDMAChannelAttributeEnable
+#define MAP_uDMAChannelAttributeEnable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_uDMAChannelControlSet
+#define MAP_uDMAChannelControlSet(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_uDMAChannelEnable
+#define MAP_uDMAChannelEnable(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_uDMAChannelIsEnabled
+#define MAP_uDMAChannelIsEnabled(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_uDMAChannelModeGet
+#define MAP_uDMAChannelModeGet(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_uDMAChannelSizeGet
+#define MAP_uDMAChannelSizeGet(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
+#ifndef MAP_uDMAChannelTransferSet
+#define MAP_uDMAChannelTransferSet(...) HostPeripheralCall(0, ##__VA_ARGS__)
+#endif
@@ -0,0 +1,32 @@
+//*****************************************************************************
+//
+// host_test.h - Checks used by the host tests.
+//
+//*****************************************************************************
+
+#ifndef __HOST_TEST_H__
+#define __HOST_TEST_H__
+
+#include <stdio.h>
+
+//*****************************************************************************
+// Failed checks of the running test program.
+static unsigned g_uHostFailures;
+
+//*****************************************************************************
+// Report a failed check and carry on with the next one.
+#define CHECK(x)															\
+	do{																		\
+		if(!(x)){															\
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x);	\
+			g_uHostFailures++;												\
+		}																	\
+	}while(0)
+
+//*****************************************************************************
+// Print the outcome and return the exit status of the test program.
+#define CHECK_DONE(name)													\
+	(printf("%s: %s\n", name, g_uHostFailures ? "FAILED" : "passed"),		\
+	 g_uHostFailures ? 1 : 0)
+
+#endif // __HOST_TEST_H__
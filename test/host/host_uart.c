@@ -0,0 +1,156 @@
+//*****************************************************************************
+//
+// host_uart.c - Host stand-in for the UART1 link and the millisecond timebase
+//               used by the xbee driver.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lib_utils/uartstdio.h"
+#include "lib_utils/timebase.h"
+#include "host_uart.h"
+
+#define HOST_ESCAPE			0x7D
+#define HOST_ESCAPE_XOR		0x20
+
+static unsigned char g_pucHostRxBuffer[UART_RX_BUFFER_SIZE];
+static uint32_t g_ui32HostRxRead;
+static uint32_t g_ui32HostRxWrite;
+static bool g_bHostRoom;
+static uint32_t g_ui32HostWrites;
+static tHostUartWriteHook *g_pfnHostWriteHook;
+static void (*g_pfnHostTxDone)(void);
+
+//*****************************************************************************
+// Empty the receive ring, give the transmit side room and drop the hook.
+void HostUartInit(void){
+	g_ui32HostRxRead = 0;
+	g_ui32HostRxWrite = 0;
+	g_bHostRoom = true;
+	g_ui32HostWrites = 0;
+	g_pfnHostWriteHook = 0;
+}
+
+//*****************************************************************************
+// Set the function called with each block queued by the driver.
+void HostUartWriteHookSet(tHostUartWriteHook *pfnHook){
+	g_pfnHostWriteHook = pfnHook;
+}
+
+//*****************************************************************************
+// Select whether UARTwriteRaw() finds room in the transmit buffer.
+void HostUartRoomSet(bool bRoom){
+	g_bHostRoom = bRoom;
+}
+
+//*****************************************************************************
+// Number of blocks queued since HostUartInit().
+uint32_t HostUartWrites(void){
+	return g_ui32HostWrites;
+}
+
+//*****************************************************************************
+// Queue bytes from the module in the receive ring. Return the number stored,
+// less than ui32Len when the ring is full.
+uint32_t HostUartReceive(const uint8_t *pui8Buf, uint32_t ui32Len){
+	uint32_t ui32Stored = 0;
+	uint32_t ui32Next;
+
+	while(ui32Stored < ui32Len){
+		ui32Next = (g_ui32HostRxWrite + 1) % UART_RX_BUFFER_SIZE;
+		if(ui32Next == g_ui32HostRxRead){
+			break;
+		}
+		g_pucHostRxBuffer[g_ui32HostRxWrite] = pui8Buf[ui32Stored++];
+		g_ui32HostRxWrite = ui32Next;
+	}
+	return ui32Stored;
+}
+
+//*****************************************************************************
+// Report the end of the last queued block, as the transmit interrupt does.
+void HostUartTxDone(void){
+	if(g_pfnHostTxDone){
+		g_pfnHostTxDone();
+	}
+}
+
+//*****************************************************************************
+// Remove the API mode 2 escapes of a frame. Return the unescaped length.
+uint16_t HostFrameUnescape(const uint8_t *pui8Buf, uint32_t ui32Len, uint8_t *pui8Frame){
+	uint16_t ui16Len = 0;
+	uint32_t i;
+
+	for(i = 0; i < ui32Len; i++){
+		if(pui8Buf[i] == HOST_ESCAPE && i + 1 < ui32Len){
+			pui8Frame[ui16Len++] = pui8Buf[++i] ^ HOST_ESCAPE_XOR;
+		}
+		else{
+			pui8Frame[ui16Len++] = pui8Buf[i];
+		}
+	}
+	return ui16Len;
+}
+
+//*****************************************************************************
+// Add the API mode 2 escapes to a frame, all bytes but the start delimiter.
+// Return the escaped length.
+uint16_t HostFrameEscape(const uint8_t *pui8Frame, uint16_t ui16Len, uint8_t *pui8Buf){
+	uint16_t ui16Out = 0;
+	uint16_t i;
+
+	for(i = 0; i < ui16Len; i++){
+		if(i > 0 && (pui8Frame[i] == 0x7E || pui8Frame[i] == HOST_ESCAPE ||
+					 pui8Frame[i] == 0x11 || pui8Frame[i] == 0x13)){
+			pui8Buf[ui16Out++] = HOST_ESCAPE;
+			pui8Buf[ui16Out++] = pui8Frame[i] ^ HOST_ESCAPE_XOR;
+		}
+		else{
+			pui8Buf[ui16Out++] = pui8Frame[i];
+		}
+	}
+	return ui16Out;
+}
+
+//*****************************************************************************
+// Move the millisecond timebase forward.
+void HostTimeAdvance(uint32_t ui32Ms){
+	while(ui32Ms--){
+		TimebaseIntHandler();
+	}
+}
+
+//*****************************************************************************
+// UARTStdioConfig() functions used by the xbee driver.
+int UARTwriteRaw(const uint8_t *pui8Buf, uint32_t ui32Len){
+	if(!g_bHostRoom){
+		return 0;
+	}
+	g_ui32HostWrites++;
+	if(g_pfnHostWriteHook){
+		g_pfnHostWriteHook(pui8Buf, ui32Len);
+	}
+	return (int)ui32Len;
+}
+
+void UARTTxDoneCallbackSet(void (*pfnCallback)(void)){
+	g_pfnHostTxDone = pfnCallback;
+}
+
+unsigned char *UARTRxBufferGet(void){
+	return g_pucHostRxBuffer;
+}
+
+uint32_t UARTRxReadIndexGet(void){
+	return g_ui32HostRxRead;
+}
+
+uint32_t UARTRxWriteIndexGet(void){
+	return g_ui32HostRxWrite;
+}
+
+void UARTRxBufferRelease(uint32_t ui32ReadIndex){
+	g_ui32HostRxRead = ui32ReadIndex;
+}
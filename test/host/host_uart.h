@@ -0,0 +1,42 @@
+//*****************************************************************************
+//
+// host_uart.h - Host stand-in for the UART1 link and the millisecond timebase
+//               used by the xbee driver.
+//
+// The UARTStdioConfig() functions of uartstdio used by XbeeZB are replaced:
+// frames queued by the driver are passed to a write hook, and bytes from the
+// module are queued with HostUartReceive() into the receive ring the parser
+// scans. The real timebase.c is linked, HostTimeAdvance() moves it forward.
+//
+//*****************************************************************************
+
+#ifndef __HOST_UART_H__
+#define __HOST_UART_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+// Function called with each block queued by UARTwriteRaw().
+typedef void (tHostUartWriteHook)(const uint8_t *pui8Buf, uint32_t ui32Len);
+
+extern void HostUartInit(void);
+extern void HostUartWriteHookSet(tHostUartWriteHook *pfnHook);
+extern void HostUartRoomSet(bool bRoom);
+extern uint32_t HostUartWrites(void);
+extern uint32_t HostUartReceive(const uint8_t *pui8Buf, uint32_t ui32Len);
+extern void HostUartTxDone(void);
+extern uint16_t HostFrameUnescape(const uint8_t *pui8Buf, uint32_t ui32Len, uint8_t *pui8Frame);
+extern uint16_t HostFrameEscape(const uint8_t *pui8Frame, uint16_t ui16Len, uint8_t *pui8Buf);
+extern void HostTimeAdvance(uint32_t ui32Ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HOST_UART_H__
@@ -0,0 +1,2 @@
+// Host stand-in, see tivaware.h.
+#include "tivaware.h"
@@ -0,0 +1,20 @@
+//*****************************************************************************
+//
+// tivaware.c - Host stand-in for the TivaWare peripheral functions.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tivaware.h"
+
+//*****************************************************************************
+// Peripheral function calls made so far.
+uint32_t g_ui32HostPeripheralCalls;
+
+//*****************************************************************************
+// Called in place of every peripheral function. Does nothing.
+uint32_t HostPeripheralCall(int n, ...){
+	g_ui32HostPeripheralCalls++;
+	return 0;
+}
@@ -0,0 +1,154 @@
+//*****************************************************************************
+//
+// tivaware.h - Host stand-ins for the TivaWare definitions used by the modules
+//              built in the host tests and simulations.
+//
+// Peripheral functions do nothing and return 0; g_ui32HostPeripheralCalls
+// counts them. Register accesses go through HWREG(), which a simulation can
+// redirect by defining it before this file is included.
+//
+//*****************************************************************************
+
+#ifndef __HOST_TIVAWARE_H__
+#define __HOST_TIVAWARE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern uint32_t g_ui32HostPeripheralCalls;
+extern uint32_t HostPeripheralCall(int n, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef HWREG
+#define HWREG(x) (*((volatile uint32_t *)(x)))
+#endif
+#define HWREGB(x) (*((volatile uint8_t *)(x)))
+#define HWREGBITW(x, b) HWREG(x)
+#define ASSERT(x)
+
+#define UART0_BASE 0x4000C000
+#define UART1_BASE 0x4000D000
+#define UART2_BASE 0x4000E000
+#define GPIO_PORTA_BASE 1
+#define GPIO_PORTB_BASE 2
+#define GPIO_PORTC_BASE 3
+#define GPIO_PORTD_BASE 4
+#define GPIO_PORTF_BASE 5
+#define TIMER0_BASE 6
+#define TIMER1_BASE 7
+#define I2C3_BASE 8
+#define UDMA_BASE 9
+#define INT_UART0 21
+#define INT_UART1 22
+#define INT_UART2 49
+#define INT_I2C3 84
+#define INT_TIMER0A 35
+#define INT_UDMAERR 63
+#define FAULT_SYSTICK 15
+#define GPIO_PIN_0 1
+#define GPIO_PIN_1 2
+#define GPIO_PIN_2 4
+#define GPIO_PIN_3 8
+#define GPIO_PIN_4 16
+#define GPIO_PIN_5 32
+#define GPIO_PA0_U0RX 1
+#define GPIO_PA1_U0TX 1
+#define GPIO_PB0_U1RX 1
+#define GPIO_PB1_U1TX 1
+#define GPIO_PC4_U1RTS 1
+#define GPIO_PC5_U1CTS 1
+#define GPIO_PD0_I2C3SCL 1
+#define GPIO_PD1_I2C3SDA 1
+#define SYSCTL_PERIPH_GPIOA 1
+#define SYSCTL_PERIPH_GPIOB 2
+#define SYSCTL_PERIPH_GPIOC 3
+#define SYSCTL_PERIPH_GPIOD 4
+#define SYSCTL_PERIPH_GPIOF 5
+#define SYSCTL_PERIPH_UART0 6
+#define SYSCTL_PERIPH_UART1 7
+#define SYSCTL_PERIPH_UART2 8
+#define SYSCTL_PERIPH_TIMER0 9
+#define SYSCTL_PERIPH_TIMER1 9
+#define SYSCTL_PERIPH_I2C3 10
+#define SYSCTL_PERIPH_UDMA 11
+#define SYSCTL_SYSDIV_2_5 1
+#define SYSCTL_USE_PLL 1
+#define SYSCTL_XTAL_16MHZ 1
+#define SYSCTL_OSC_MAIN 1
+#define TIMER_CFG_PERIODIC 1
+#define TIMER_CFG_ONE_SHOT 1
+#define TIMER_A 1
+#define TIMER_TIMA_TIMEOUT 1
+#define UART_CLOCK_PIOSC 1
+#define UART_CONFIG_WLEN_8 1
+#define UART_CONFIG_STOP_ONE 1
+#define UART_CONFIG_PAR_NONE 1
+#define UART_FIFO_TX1_8 0x00
+#define UART_FIFO_TX2_8 0x01
+#define UART_FIFO_RX1_8 0x00
+#define UART_FIFO_RX2_8 0x08
+#define UART_FIFO_RX4_8 0x10
+#define UART_FIFO_RX6_8 0x18
+#define UART_INT_RX 0x10
+#define UART_INT_TX 0x20
+#define UART_INT_RT 0x40
+#define UART_INT_OE 0x400
+#define UART_INT_BE 0x200
+#define UART_INT_PE 0x100
+#define UART_INT_FE 0x80
+#define UART_INT_DMARX 0x10000
+#define UART_INT_DMATX 0x20000
+#define UART_TXINT_MODE_EOT 0x10
+#define UART_TXINT_MODE_FIFO 0
+#define UART_FLOWCONTROL_TX 0x8000
+#define UART_FLOWCONTROL_RX 0x4000
+#define UART_FLOWCONTROL_NONE 0
+#define UART_RXERROR_OVERRUN 8
+#define UART_RXERROR_BREAK 4
+#define UART_RXERROR_PARITY 2
+#define UART_RXERROR_FRAMING 1
+#define UART_DMA_RX 1
+#define UART_DMA_TX 2
+#define UART_DMA_ERR_RXSTOP 4
+#define UART_O_DR 0
+#define UART_O_FR 0x18
+#define UART_FR_RXFE 0x10
+#define UART_FR_TXFF 0x20
+#define UART_FR_BUSY 0x8
+#define UDMA_CHANNEL_UART1RX 22
+#define UDMA_CH22_UART1RX 22
+#define UDMA_PRI_SELECT 0
+#define UDMA_ALT_SELECT 0x20
+#define UDMA_SIZE_8 0
+#define UDMA_SRC_INC_NONE 0
+#define UDMA_DST_INC_8 0
+#define UDMA_ARB_1 0x0000
+#define UDMA_ARB_2 0x4000
+#define UDMA_ARB_4 0x8000
+#define UDMA_ARB_8 0xC000
+#define UDMA_MODE_PINGPONG 3
+#define UDMA_MODE_STOP 0
+#define UDMA_ATTR_ALTSELECT 1
+#define UDMA_ATTR_USEBURST 2
+#define UDMA_ATTR_HIGH_PRIORITY 4
+#define UDMA_ATTR_REQMASK 8
+#define UDMA_ATTR_ALL 15
+#define I2C_MASTER_INT_DATA 1
+#define NVIC_ST_CURRENT 0xE000E018
+#define NVIC_DBG_CTRL 0
+#define NVIC_DBG_INT 0xE000EDF0
+#define DWT_BASE 0
+#define UART_DR_OE 0x800
+#define UART_DR_BE 0x400
+#define UART_DR_PE 0x200
+#define UART_DR_FE 0x100
+
+#endif // __HOST_TIVAWARE_H__
@@ -0,0 +1,2 @@
+// Host stand-in: ustdlib.c includes its header from the TivaWare utils directory.
+#include "lib_utils/ustdlib.h"
@@ -0,0 +1,129 @@
+//*****************************************************************************
+//
+// sim_addr_discovery.cpp - Report latency with learned 16 bit addresses and
+//                          with every frame sent to ZB_UNKNOWN_ADDR16.
+//
+// Reports go through the real TX window and address table to a stand-in
+// coordinator. A frame sent to ZB_UNKNOWN_ADDR16 costs an address discovery
+// before it is sent, and every hop costs SIM_HOP_MS. Every SIM_BREAK_EVERY
+// frame, the route breaks: the attempt fails with Address Not Found, the
+// address is invalidated and the window sends the frame again.
+//
+// Without learning, the coordinator address is dropped before each report,
+// so every frame pays the discovery as before the address table.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "lib_utils/timebase.h"
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_addr_table.h"
+#include "lib_xbee/xbee_tx_window.h"
+#include "host_uart.h"
+
+//*****************************************************************************
+// Simulation parameters.
+#define SIM_REPORTS			1000
+#define SIM_REPORT_MS		1000		// Time between two reports.
+#define SIM_HOP_MS			10
+#define SIM_HOPS			1
+#define SIM_BREAK_EVERY		25
+#define SIM_COORD_ADDR16	0x0000
+
+//*****************************************************************************
+// Last frame written to UART1.
+static uint8_t g_ui8SimFrameId;
+static uint16_t g_ui16SimDstAddr16;
+static bool g_bSimSent;
+
+static uint64_t g_ui64SimLatencySumMs;
+static uint32_t g_ui32SimDelivered;
+
+static void simUartWrite(const uint8_t *pui8Buf, uint32_t ui32Len){
+	uint8_t pui8Frame[MAX_TX_FRAME_SIZE];
+	uint16_t ui16Len = HostFrameUnescape(pui8Buf, ui32Len, pui8Frame);
+
+	if((ui16Len < 17) || (pui8Frame[FRAME_TYPE_IDX] != ZB_TRANSMIT_REQUEST)){
+		return;
+	}
+	g_ui8SimFrameId = pui8Frame[4];
+	g_ui16SimDstAddr16 = ((uint16_t)pui8Frame[13] << 8) | pui8Frame[14];
+	g_bSimSent = true;
+}
+
+static void simTxDone(const struct tXbeeTxResult *psResult){
+	if(psResult->deliveryStatus == XBEE_DELIVERY_SUCCESS){
+		g_ui32SimDelivered++;
+		g_ui64SimLatencySumMs += psResult->latencyMs;
+	}
+}
+
+//*****************************************************************************
+// Coordinator side of the last frame sent: wait for the discovery and the
+// hops, then return the ZB Transmit Status.
+static void simCoordinator(uint32_t ui32DiscoveryMs, bool bBroken){
+	struct tXbeeApiFrame sFrame;
+
+	g_bSimSent = false;
+	HostTimeAdvance(((g_ui16SimDstAddr16 == ZB_UNKNOWN_ADDR16) ? ui32DiscoveryMs : 0) +
+					SIM_HOPS * SIM_HOP_MS);
+	memset(&sFrame, 0, sizeof(sFrame));
+	sFrame.frameType = ZB_TRANSMIT_STATUS;
+	sFrame.u.txStatus.frameId = g_ui8SimFrameId;
+	sFrame.u.txStatus.dstAddr16 = SIM_COORD_ADDR16;
+	sFrame.u.txStatus.deliveryStatus = bBroken ? XBEE_DELIVERY_ADDRESS_NOT_FOUND : XBEE_DELIVERY_SUCCESS;
+	XbeeTxWindowStatusHandler(&sFrame);
+}
+
+//*****************************************************************************
+// Send SIM_REPORTS reports. Return their mean latency.
+static double simRun(uint32_t ui32DiscoveryMs, bool bLearn, struct tXbeeAddrStats *psStats){
+	XbeeZB sXbee;
+	uint8_t pui8Report[20];
+	uint32_t i;
+
+	HostUartInit();
+	HostUartWriteHookSet(simUartWrite);
+	sXbee.begin();
+	XbeeAddrTableInit(&sXbee);
+	XbeeTxWindowInit(&sXbee, simTxDone);
+	memset(pui8Report, 0x55, sizeof(pui8Report));
+	g_ui64SimLatencySumMs = 0;
+	g_ui32SimDelivered = 0;
+
+	for(i = 0; i < SIM_REPORTS; i++){
+		if(!bLearn){
+			XbeeAddrInvalidate(g_pui8ZBCoordinatorAddr64);
+		}
+		XbeeTxWindowSend(pui8Report, sizeof(pui8Report), TimebaseMsGet());
+		simCoordinator(ui32DiscoveryMs, (i % SIM_BREAK_EVERY) == SIM_BREAK_EVERY - 1);
+
+		// The failed attempt is sent again at once.
+		XbeeTxWindowProcess(TimebaseMsGet());
+		if(g_bSimSent){
+			simCoordinator(ui32DiscoveryMs, false);
+		}
+		HostTimeAdvance(SIM_REPORT_MS);
+	}
+	XbeeAddrStatsGet(psStats);
+	return (double)g_ui64SimLatencySumMs / g_ui32SimDelivered;
+}
+
+int main(void){
+	struct tXbeeAddrStats sUnknown, sLearned;
+	uint32_t ui32DiscoveryMs;
+	double dUnknown, dLearned;
+
+	for(ui32DiscoveryMs = 40; ui32DiscoveryMs <= 160; ui32DiscoveryMs *= 2){
+		dUnknown = simRun(ui32DiscoveryMs, false, &sUnknown);
+		dLearned = simRun(ui32DiscoveryMs, true, &sLearned);
+		printf("discovery %3u ms: mean latency unknown address %5.1f ms, learned %5.1f ms"
+			   " (hits %u misses %u invalidated %u)\n", (unsigned)ui32DiscoveryMs, dUnknown, dLearned,
+			   (unsigned)sLearned.hits, (unsigned)sLearned.misses, (unsigned)sLearned.invalidated);
+	}
+	return 0;
+}
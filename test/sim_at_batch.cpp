@@ -0,0 +1,207 @@
+//*****************************************************************************
+//
+// sim_at_batch.cpp - Time to change the channel of a network with one remote
+//                    AT command at a time and with an AT client batch.
+//
+// Each of SIM_NODES stand-in remote modules answers after its own round trip
+// of SIM_RTT_MIN_MS to SIM_RTT_MAX_MS. One node in SIM_DEAD_EVERY on average
+// never answers. A node holds CH until a command with the apply option, and
+// counts how many times the held change was applied.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib_utils/timebase.h"
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_addr_table.h"
+#include "lib_xbee/xbee_at.h"
+#include "host_uart.h"
+
+//*****************************************************************************
+// Simulation parameters.
+#define SIM_NODES			300
+#define SIM_RTT_MIN_MS		80
+#define SIM_RTT_MAX_MS		280
+#define SIM_DEAD_EVERY		50
+#define SIM_RESPONSES_MAX	64			// Responses in flight.
+
+//*****************************************************************************
+// Stand-in remote modules, addressed by the last two bytes of their 64 bit
+// address.
+static uint8_t g_ppui8SimAddr[SIM_NODES][8];
+static bool g_pbSimDead[SIM_NODES];
+static uint32_t g_pui32SimRttMs[SIM_NODES];
+static bool g_pbSimHeld[SIM_NODES];
+static uint32_t g_pui32SimApplied[SIM_NODES];
+
+//*****************************************************************************
+// Remote Command Responses on their way back.
+static struct{
+	uint32_t ui32ArrivalMs;
+	uint8_t ui8FrameId;
+	uint16_t ui16Node;
+	uint8_t pui8Command[2];
+}
+g_psSimResponses[SIM_RESPONSES_MAX];
+static uint32_t g_ui32SimResponses;
+
+static uint32_t g_ui32SimBatchDone;
+static uint32_t g_ui32SimBatchFailed;
+
+//*****************************************************************************
+// Remote AT Command Requests written to UART1.
+static void simUartWrite(const uint8_t *pui8Buf, uint32_t ui32Len){
+	uint8_t pui8Frame[MAX_TX_FRAME_SIZE];
+	uint16_t ui16Len = HostFrameUnescape(pui8Buf, ui32Len, pui8Frame);
+	uint16_t ui16Node;
+
+	if((ui16Len < 19) || (pui8Frame[FRAME_TYPE_IDX] != REMOTE_AT_COMMAND_REQUEST)){
+		return;
+	}
+	ui16Node = ((uint16_t)pui8Frame[11] << 8) | pui8Frame[12];
+	if(ui16Node >= SIM_NODES || g_pbSimDead[ui16Node]){
+		return;
+	}
+	if(pui8Frame[16] == 'C' && pui8Frame[17] == 'H'){
+		g_pbSimHeld[ui16Node] = true;
+	}
+	if(pui8Frame[15] & REMOTE_AT_APPLY_CHANGES){
+		if(g_pbSimHeld[ui16Node]){
+			g_pui32SimApplied[ui16Node]++;
+		}
+		g_pbSimHeld[ui16Node] = false;
+	}
+	if(g_ui32SimResponses == SIM_RESPONSES_MAX){
+		return;
+	}
+	g_psSimResponses[g_ui32SimResponses].ui32ArrivalMs = TimebaseMsGet() + g_pui32SimRttMs[ui16Node];
+	g_psSimResponses[g_ui32SimResponses].ui8FrameId = pui8Frame[4];
+	g_psSimResponses[g_ui32SimResponses].ui16Node = ui16Node;
+	g_psSimResponses[g_ui32SimResponses].pui8Command[0] = pui8Frame[16];
+	g_psSimResponses[g_ui32SimResponses].pui8Command[1] = pui8Frame[17];
+	g_ui32SimResponses++;
+}
+
+//*****************************************************************************
+// Pass the responses that arrived by now to the AT client.
+static void simResponsesReceive(void){
+	struct tXbeeApiFrame sFrame;
+	uint32_t i = 0;
+
+	while(i < g_ui32SimResponses){
+		if(!TimebaseDeadlineReached(TimebaseMsGet(), g_psSimResponses[i].ui32ArrivalMs)){
+			i++;
+			continue;
+		}
+		memset(&sFrame, 0, sizeof(sFrame));
+		sFrame.frameType = REMOTE_COMMAND_RESPONSE;
+		sFrame.u.remoteAtResponse.frameId = g_psSimResponses[i].ui8FrameId;
+		memcpy(sFrame.u.remoteAtResponse.srcAddr64, g_ppui8SimAddr[g_psSimResponses[i].ui16Node], 8);
+		sFrame.u.remoteAtResponse.srcAddr16 = g_psSimResponses[i].ui16Node;
+		sFrame.u.remoteAtResponse.command[0] = g_psSimResponses[i].pui8Command[0];
+		sFrame.u.remoteAtResponse.command[1] = g_psSimResponses[i].pui8Command[1];
+		sFrame.u.remoteAtResponse.status = XBEE_AT_STATUS_OK;
+		XbeeAtRemoteResponseHandler(&sFrame);
+		g_psSimResponses[i] = g_psSimResponses[--g_ui32SimResponses];
+	}
+}
+
+//*****************************************************************************
+// Advance the clock by 1 ms and run the AT client.
+static void simStep(void){
+	HostTimeAdvance(1);
+	simResponsesReceive();
+	XbeeAtProcess(TimebaseMsGet());
+}
+
+static void simBatchDone(uint16_t ui16Node, const uint8_t *pui8Addr64, uint8_t ui8Status){
+	g_ui32SimBatchDone++;
+	if(ui8Status != XBEE_AT_STATUS_OK){
+		g_ui32SimBatchFailed++;
+	}
+}
+
+static void simNetworkReset(void){
+	memset(g_pbSimHeld, 0, sizeof(g_pbSimHeld));
+	memset(g_pui32SimApplied, 0, sizeof(g_pui32SimApplied));
+	g_ui32SimResponses = 0;
+}
+
+//*****************************************************************************
+// Nodes with the change applied exactly once, and live nodes.
+static void simReport(const char *pcName, uint32_t ui32StartMs, uint32_t ui32Failed){
+	uint32_t ui32Once = 0;
+	uint32_t ui32Live = 0;
+	uint16_t i;
+
+	for(i = 0; i < SIM_NODES; i++){
+		ui32Once += (g_pui32SimApplied[i] == 1);
+		ui32Live += !g_pbSimDead[i];
+	}
+	printf("%-22s %4.0f s, %u failed, applied once on %u of %u live nodes\n", pcName,
+		   (TimebaseMsGet() - ui32StartMs) / 1000.0, (unsigned)ui32Failed, (unsigned)ui32Once,
+		   (unsigned)ui32Live);
+}
+
+int main(void){
+	static const uint8_t pui8Channel[1] = {0x0F};
+	static const struct tXbeeAtBatchCommand psCommands[3] = {{"CH", pui8Channel, 1}, {"WR", 0, 0},
+															 {"AC", 0, 0}};
+	struct tXbeeAtFuture sFuture;
+	XbeeZB sXbee;
+	uint32_t ui32StartMs;
+	uint32_t ui32Failed;
+	bool bFailed;
+	uint16_t i;
+	uint8_t c;
+
+	srand(3);
+	for(i = 0; i < SIM_NODES; i++){
+		memset(g_ppui8SimAddr[i], 0, 8);
+		g_ppui8SimAddr[i][0] = 0x13;
+		g_ppui8SimAddr[i][6] = i >> 8;
+		g_ppui8SimAddr[i][7] = i & 0xFF;
+		g_pbSimDead[i] = (rand() % SIM_DEAD_EVERY == 0);
+		g_pui32SimRttMs[i] = SIM_RTT_MIN_MS + rand() % (SIM_RTT_MAX_MS - SIM_RTT_MIN_MS);
+	}
+
+	HostUartInit();
+	HostUartWriteHookSet(simUartWrite);
+	sXbee.begin();
+	XbeeAddrTableInit(&sXbee);
+	XbeeAtInit(&sXbee);
+
+	// Each command waits for its response before the next one is sent.
+	simNetworkReset();
+	ui32StartMs = TimebaseMsGet();
+	ui32Failed = 0;
+	for(i = 0; i < SIM_NODES; i++){
+		bFailed = false;
+		for(c = 0; c < 3 && !bFailed; c++){
+			XbeeAtRemoteCommand(g_ppui8SimAddr[i], psCommands[c].command, psCommands[c].parameter,
+								psCommands[c].length, c == 2, 0, &sFuture);
+			while(!sFuture.done){
+				simStep();
+			}
+			bFailed = (sFuture.result.status != XBEE_AT_STATUS_OK);
+		}
+		ui32Failed += bFailed;
+	}
+	simReport("one command at a time:", ui32StartMs, ui32Failed);
+
+	simNetworkReset();
+	ui32StartMs = TimebaseMsGet();
+	g_ui32SimBatchDone = 0;
+	g_ui32SimBatchFailed = 0;
+	XbeeAtBatchStart(g_ppui8SimAddr, SIM_NODES, psCommands, 3, simBatchDone);
+	while(XbeeAtBatchBusy()){
+		simStep();
+	}
+	simReport("batch:", ui32StartMs, g_ui32SimBatchFailed);
+	return (g_ui32SimBatchDone == SIM_NODES) ? 0 : 1;
+}
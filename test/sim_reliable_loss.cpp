@@ -0,0 +1,171 @@
+//*****************************************************************************
+//
+// sim_reliable_loss.cpp - Report delivery of the reliable layer over a lossy
+//                         link.
+//
+// One report of SIM_REPORT_SIZE bytes is offered every second for SIM_RUN_MS
+// to the coordinator. Data payloads and acknowledges are each lost with the
+// given probability and otherwise arrive SIM_LINK_MS later. The coordinator
+// acknowledges every data payload it receives.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib_utils/timebase.h"
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_reliable.h"
+#include "host_uart.h"
+
+//*****************************************************************************
+// Simulation parameters.
+#define SIM_RUN_MS			600000		// Simulated time of each run.
+#define SIM_REPORT_MS		1000		// Time between two reports.
+#define SIM_REPORT_SIZE		40
+#define SIM_LINK_MS			20			// One way delay of the link.
+#define SIM_STEP_MS			10			// Main loop pass.
+#define SIM_ACKS_MAX		64			// Acknowledges in flight.
+#define SIM_PAYLOAD_IDX		17			// Payload index in a ZB Transmit Request.
+
+static double g_dSimLoss;
+
+// Reports go to the coordinator alias, acknowledges come from its own address.
+static const uint8_t g_pui8SimCoordAddr64[8] = {0x00, 0x13, 0xA2, 0x00, 0x40, 0x8B, 0x2C, 0x11};
+
+//*****************************************************************************
+// Acknowledges on their way back from the coordinator.
+static struct{
+	uint32_t ui32ArrivalMs;
+	uint8_t ui8Epoch;
+	uint8_t ui8Seq;
+}
+g_psSimAcks[SIM_ACKS_MAX];
+static uint32_t g_ui32SimAcks;
+
+static uint32_t g_ui32SimDelivered;
+static uint32_t g_ui32SimFailed;
+static uint64_t g_ui64SimLatencySumMs;
+
+//*****************************************************************************
+// Frames written to UART1. A data payload that survives the link is
+// acknowledged by the coordinator, and the acknowledge may be lost too.
+static void simUartWrite(const uint8_t *pui8Buf, uint32_t ui32Len){
+	uint8_t pui8Frame[MAX_TX_FRAME_SIZE];
+	uint16_t ui16Len = HostFrameUnescape(pui8Buf, ui32Len, pui8Frame);
+
+	if((ui16Len <= SIM_PAYLOAD_IDX + 2) || (pui8Frame[FRAME_TYPE_IDX] != ZB_TRANSMIT_REQUEST) ||
+	   (pui8Frame[SIM_PAYLOAD_IDX] != XBEE_RELIABLE_DATA)){
+		return;
+	}
+	if((drand48() < g_dSimLoss) || (drand48() < g_dSimLoss) || (g_ui32SimAcks == SIM_ACKS_MAX)){
+		return;
+	}
+	g_psSimAcks[g_ui32SimAcks].ui32ArrivalMs = TimebaseMsGet() + 2 * SIM_LINK_MS;
+	g_psSimAcks[g_ui32SimAcks].ui8Epoch = pui8Frame[SIM_PAYLOAD_IDX + 1];
+	g_psSimAcks[g_ui32SimAcks].ui8Seq = pui8Frame[SIM_PAYLOAD_IDX + 2];
+	g_ui32SimAcks++;
+}
+
+//*****************************************************************************
+// Pass the acknowledges that arrived by now to the reliable layer.
+static void simAcksReceive(void){
+	struct tXbeeRxPacket sPacket;
+	uint8_t pui8Ack[XBEE_RELIABLE_HEADER_SIZE];
+	uint32_t i = 0;
+
+	while(i < g_ui32SimAcks){
+		if(!TimebaseDeadlineReached(TimebaseMsGet(), g_psSimAcks[i].ui32ArrivalMs)){
+			i++;
+			continue;
+		}
+		pui8Ack[0] = XBEE_RELIABLE_ACK;
+		pui8Ack[1] = g_psSimAcks[i].ui8Epoch;
+		pui8Ack[2] = g_psSimAcks[i].ui8Seq;
+		memset(&sPacket, 0, sizeof(sPacket));
+		memcpy(sPacket.srcAddr64, g_pui8SimCoordAddr64, 8);
+		sPacket.srcAddr16 = ZB_COORDINATOR_ADDR16;
+		sPacket.data.data1 = pui8Ack;
+		sPacket.data.length1 = sizeof(pui8Ack);
+		sPacket.data.data2 = pui8Ack;
+		sPacket.data.length2 = 0;
+		XbeeReliableReceive(&sPacket);
+		g_psSimAcks[i] = g_psSimAcks[--g_ui32SimAcks];
+	}
+}
+
+static void simDone(uint8_t ui8Seq, bool bDelivered, uint32_t ui32LatencyMs){
+	if(bDelivered){
+		g_ui32SimDelivered++;
+		g_ui64SimLatencySumMs += ui32LatencyMs;
+	}
+	else{
+		g_ui32SimFailed++;
+	}
+}
+
+static void simRun(double dLoss){
+	XbeeZB sXbee;
+	struct tXbeeReliableStats sStats;
+	uint8_t pui8Report[SIM_REPORT_SIZE];
+	uint32_t ui32Offered = 0;
+	uint32_t ui32Refused = 0;
+	uint32_t ui32Start;
+	uint32_t ui32NextReportMs;
+
+	HostUartInit();
+	HostUartWriteHookSet(simUartWrite);
+	sXbee.begin();
+	XbeeReliableInit(&sXbee, 1, 0, simDone);
+	g_dSimLoss = dLoss;
+	g_ui32SimAcks = 0;
+	g_ui32SimDelivered = 0;
+	g_ui32SimFailed = 0;
+	g_ui64SimLatencySumMs = 0;
+	memset(pui8Report, 0x55, sizeof(pui8Report));
+	srand48(1);
+
+	ui32Start = TimebaseMsGet();
+	ui32NextReportMs = ui32Start;
+	while(TimebaseMsGet() - ui32Start < SIM_RUN_MS){
+		if(TimebaseDeadlineReached(TimebaseMsGet(), ui32NextReportMs)){
+			ui32NextReportMs += SIM_REPORT_MS;
+			ui32Offered++;
+			if(!XbeeReliableSend(g_pui8ZBCoordinatorAddr64, pui8Report, sizeof(pui8Report),
+								 TimebaseMsGet())){
+				ui32Refused++;
+			}
+		}
+		simAcksReceive();
+		XbeeReliableProcess(TimebaseMsGet());
+		HostTimeAdvance(SIM_STEP_MS);
+	}
+
+	// Let the payloads in flight finish.
+	while(g_ui32SimDelivered + g_ui32SimFailed + ui32Refused < ui32Offered){
+		simAcksReceive();
+		XbeeReliableProcess(TimebaseMsGet());
+		HostTimeAdvance(SIM_STEP_MS);
+	}
+
+	XbeeReliableStatsGet(&sStats);
+	printf("loss %2.0f%%  offered %u  delivered %5.1f%%  failed %u  refused %u  retransmits %u"
+		   "  mean latency %4.0f ms  max %u ms\n", dLoss * 100, (unsigned)ui32Offered,
+		   100.0 * g_ui32SimDelivered / ui32Offered, (unsigned)g_ui32SimFailed, (unsigned)ui32Refused,
+		   (unsigned)sStats.retransmits,
+		   g_ui32SimDelivered ? (double)g_ui64SimLatencySumMs / g_ui32SimDelivered : 0.0,
+		   (unsigned)sStats.maxLatencyMs);
+}
+
+int main(void){
+	static const double pdLoss[5] = {0.0, 0.05, 0.10, 0.20, 0.30};
+	uint8_t i;
+
+	for(i = 0; i < 5; i++){
+		simRun(pdLoss[i]);
+	}
+	return 0;
+}
@@ -0,0 +1,216 @@
+//*****************************************************************************
+//
+// sim_source_route.cpp - Route discoveries of a concentrator unicasting to
+//                        the nodes of a tree, with and without source routes.
+//
+// The code runs here as it would on a concentrator, the only device that
+// receives Route Record Indicator frames. SIM_NODES nodes form a random tree
+// below it. The stand-in module keeps SIM_ROUTE_TABLE routes, least recently
+// used first out. A unicast to a node without a route and without a source
+// route costs a route discovery, whose request is rebroadcast by every
+// device. One node in four sends a Route Record before it is addressed.
+//
+// Every Create Source Route frame is checked against the tree.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib_xbee/XbeeZB.h"
+#include "lib_xbee/xbee_frames.h"
+#include "lib_xbee/xbee_addr_table.h"
+#include "lib_xbee/xbee_source_route.h"
+#include "host_uart.h"
+
+//*****************************************************************************
+// Simulation parameters.
+#define SIM_NODES			60
+#define SIM_ROUTE_TABLE		10			// Routes kept by the module.
+#define SIM_UNICASTS		5000
+
+//*****************************************************************************
+// Tree below the concentrator, node 0.
+static int g_piSimParent[SIM_NODES + 1];
+static uint16_t g_pui16SimAddr16[SIM_NODES + 1];
+
+//*****************************************************************************
+// Stand-in module state.
+static bool g_pbSimSourceRouted[SIM_NODES + 1];
+static int g_piSimRoutes[SIM_ROUTE_TABLE];
+static int g_iSimRoutes;
+
+static uint32_t g_ui32SimFrames;
+static uint32_t g_ui32SimDiscoveries;
+static uint32_t g_ui32SimRebroadcasts;
+static uint32_t g_ui32SimCreated;
+static uint32_t g_ui32SimBadRoutes;
+
+static void simNodeAddr64(int iNode, uint8_t *pui8Addr64){
+	memset(pui8Addr64, 0, 8);
+	pui8Addr64[0] = 0x13;
+	pui8Addr64[7] = (uint8_t)iNode;
+}
+
+//*****************************************************************************
+// Look a node up in the module route table, moving it to the front.
+static bool simRouteKnown(int iNode){
+	int i;
+
+	for(i = 0; i < g_iSimRoutes; i++){
+		if(g_piSimRoutes[i] == iNode){
+			memmove(g_piSimRoutes + 1, g_piSimRoutes, i * sizeof(int));
+			g_piSimRoutes[0] = iNode;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void simRouteAdd(int iNode){
+	if(g_iSimRoutes < SIM_ROUTE_TABLE){
+		g_iSimRoutes++;
+	}
+	memmove(g_piSimRoutes + 1, g_piSimRoutes, (g_iSimRoutes - 1) * sizeof(int));
+	g_piSimRoutes[0] = iNode;
+}
+
+//*****************************************************************************
+// Create Source Route frames must list the hops from the node's parent up to
+// the concentrator.
+static void simCreateSourceRoute(const uint8_t *pui8Frame, int iNode){
+	uint8_t ui8Hops = pui8Frame[16];
+	uint8_t i;
+	int iParent = g_piSimParent[iNode];
+
+	g_ui32SimCreated++;
+	g_pbSimSourceRouted[iNode] = true;
+	if((((uint16_t)pui8Frame[13] << 8) | pui8Frame[14]) != g_pui16SimAddr16[iNode]){
+		g_ui32SimBadRoutes++;
+		return;
+	}
+	for(i = 0; i < ui8Hops; i++, iParent = g_piSimParent[iParent]){
+		if((iParent == 0) ||
+		   ((((uint16_t)pui8Frame[17 + 2 * i] << 8) | pui8Frame[18 + 2 * i]) != g_pui16SimAddr16[iParent])){
+			g_ui32SimBadRoutes++;
+			return;
+		}
+	}
+	if(iParent != 0){
+		g_ui32SimBadRoutes++;
+	}
+}
+
+//*****************************************************************************
+// Frames written to UART1, as handled by the module.
+static void simUartWrite(const uint8_t *pui8Buf, uint32_t ui32Len){
+	uint8_t pui8Frame[MAX_TX_FRAME_SIZE];
+	uint16_t ui16Len = HostFrameUnescape(pui8Buf, ui32Len, pui8Frame);
+	int iNode;
+
+	if(ui16Len < 17){
+		return;
+	}
+	iNode = pui8Frame[12];
+	if(pui8Frame[FRAME_TYPE_IDX] == CREATE_SOURCE_ROUTE){
+		simCreateSourceRoute(pui8Frame, iNode);
+		return;
+	}
+	g_ui32SimFrames++;
+	if(g_pbSimSourceRouted[iNode] || simRouteKnown(iNode)){
+		return;
+	}
+	g_ui32SimDiscoveries++;
+	g_ui32SimRebroadcasts += SIM_NODES + 1;
+	simRouteAdd(iNode);
+}
+
+//*****************************************************************************
+// Route Record Indicator of a node, listing the hops from its parent up.
+static void simRouteRecord(int iNode){
+	struct tXbeeApiFrame sFrame;
+	uint8_t ui8Hops = 0;
+	int iParent;
+
+	memset(&sFrame, 0, sizeof(sFrame));
+	sFrame.frameType = ROUTE_RECORD_INDICATOR;
+	simNodeAddr64(iNode, sFrame.u.routeRecord.srcAddr64);
+	sFrame.u.routeRecord.srcAddr16 = g_pui16SimAddr16[iNode];
+	for(iParent = g_piSimParent[iNode]; iParent != 0; iParent = g_piSimParent[iParent]){
+		sFrame.u.routeRecord.addresses[ui8Hops++] = g_pui16SimAddr16[iParent];
+	}
+	sFrame.u.routeRecord.numAddresses = ui8Hops;
+	XbeeSourceRouteRecordHandler(&sFrame);
+}
+
+static void simRun(bool bSourceRoutes){
+	XbeeZB sXbee;
+	uint8_t pui8Addr64[8];
+	uint8_t pui8Payload[10];
+	struct tXbeeTxSegment sSegment;
+	uint32_t i;
+	int iNode;
+
+	HostUartInit();
+	HostUartWriteHookSet(simUartWrite);
+	sXbee.begin();
+	XbeeAddrTableInit(&sXbee);
+	XbeeSourceRouteInit(&sXbee);
+	memset(g_pbSimSourceRouted, 0, sizeof(g_pbSimSourceRouted));
+	memset(pui8Payload, 0x55, sizeof(pui8Payload));
+	sSegment.data = pui8Payload;
+	sSegment.length = sizeof(pui8Payload);
+	g_iSimRoutes = 0;
+	g_ui32SimFrames = 0;
+	g_ui32SimDiscoveries = 0;
+	g_ui32SimRebroadcasts = 0;
+	g_ui32SimCreated = 0;
+	g_ui32SimBadRoutes = 0;
+	srand(1);
+
+	for(i = 0; i < SIM_UNICASTS; i++){
+		iNode = 1 + rand() % SIM_NODES;
+		if(bSourceRoutes && (rand() % 4 == 0)){
+			simRouteRecord(iNode);
+		}
+		simNodeAddr64(iNode, pui8Addr64);
+		XbeeSourceRoutePrepare(pui8Addr64);
+		sXbee.ZBTransmitRequest(XbeeAddrTxHeaderGet(pui8Addr64), &sSegment, 1, 0);
+	}
+}
+
+int main(void){
+	struct tXbeeSourceRouteStats sStats;
+	int iDepth, iMaxDepth = 0;
+	int iNode, iParent;
+
+	srand(7);
+	for(iNode = 1; iNode <= SIM_NODES; iNode++){
+		g_piSimParent[iNode] = (iNode <= 4) ? 0 : 1 + rand() % (iNode - 1);
+		g_pui16SimAddr16[iNode] = 0x1000 + iNode * 37;
+		iDepth = 0;
+		for(iParent = g_piSimParent[iNode]; iParent != 0; iParent = g_piSimParent[iParent]){
+			iDepth++;
+		}
+		if(iDepth > iMaxDepth){
+			iMaxDepth = iDepth;
+		}
+	}
+	printf("%d nodes, up to %d hops, module route table of %d, %d unicasts\n", SIM_NODES, iMaxDepth + 1,
+		   SIM_ROUTE_TABLE, SIM_UNICASTS);
+
+	simRun(false);
+	printf("no source routes: %u frames, %u route discoveries, %u rebroadcasts\n",
+		   (unsigned)g_ui32SimFrames, (unsigned)g_ui32SimDiscoveries, (unsigned)g_ui32SimRebroadcasts);
+
+	simRun(true);
+	XbeeSourceRouteStatsGet(&sStats);
+	printf("source routes:    %u frames, %u route discoveries, %u rebroadcasts, %u Create Source Route"
+		   " (%u wrong)\n", (unsigned)g_ui32SimFrames, (unsigned)g_ui32SimDiscoveries,
+		   (unsigned)g_ui32SimRebroadcasts, (unsigned)g_ui32SimCreated, (unsigned)g_ui32SimBadRoutes);
+	printf("                  %u route records, %u routes changed, %u too long\n",
+		   (unsigned)sStats.records, (unsigned)sStats.changed, (unsigned)sStats.tooLong);
+	return g_ui32SimBadRoutes ? 1 : 0;
+}
@@ -0,0 +1,305 @@
+//*****************************************************************************
+//
+// sim_uart_dma.c - UART1 receive interrupts with interrupt driven reception
+//                  and with the uDMA ping-pong blocks, and the data the uDMA
+//                  stores for a given burst size.
+//
+// uartstdio.c is built into this file with UART1 and its uDMA channel
+// redirected to models. One byte arrives per byte time. The UART makes a
+// burst request once its receive FIFO reaches the trigger level, and a single
+// request while it holds fewer bytes. The uDMA moves one byte per single
+// request and one arbitration size per burst request, reading DR even when
+// the FIFO is empty. In a share SIM_DMA_BUSY of the byte times the uDMA
+// serves other channels, so the FIFO can reach the trigger level. A control
+// structure that completes raises the UART interrupt.
+//
+// The reader of the receive buffer checks every byte it takes.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//*****************************************************************************
+// Simulation parameters, in byte times.
+#define SIM_BYTES			200000
+#define SIM_FIFO_SIZE		16
+#define SIM_RT_IDLE			4			// Idle time before a receive timeout.
+#define SIM_DMA_BUSY		0.25		// Share of byte times the uDMA serves other channels.
+#define SIM_FRAME			30			// Frame length in the frames stream.
+#define SIM_FRAME_GAP		20			// Idle time between two frames.
+#define SIM_SLOW_EVERY		8			// The slow reader reads SIM_SLOW_READ bytes
+#define SIM_SLOW_READ		4			// every SIM_SLOW_EVERY byte times.
+#define SIM_EMPTY_DR		0xEE		// DR read with the FIFO empty.
+
+//*****************************************************************************
+// UART1 receive FIFO model.
+static uint8_t g_pui8SimFifo[SIM_FIFO_SIZE];
+static uint32_t g_ui32SimHead;
+static uint32_t g_ui32SimTail;
+static uint32_t g_ui32SimLevel;			// Trigger level in bytes.
+
+//*****************************************************************************
+// uDMA channel model, primary and alternate control structures.
+static struct{
+	uint32_t ui32Mode;
+	uint32_t ui32Remaining;
+	uint8_t *pui8Dst;
+	uint32_t ui32Arb;					// Bytes per burst request.
+}
+g_psSimDma[2];
+static bool g_bSimDmaEnabled;
+static uint32_t g_ui32SimDmaActive;
+static uint32_t g_ui32SimDmaStarts;
+static uint32_t g_ui32SimEmptyReads;
+static bool g_bSimDmaMode;
+
+static uint32_t simDmaModeGet(uint32_t ui32ChannelStructIndex);
+static uint32_t simDmaSizeGet(uint32_t ui32ChannelStructIndex);
+static void simDmaTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode, void *pvSrc, void *pvDst,
+							  uint32_t ui32Size);
+static bool simDmaIsEnabled(uint32_t ui32Channel);
+static void simDmaEnable(uint32_t ui32Channel);
+static void simDmaAttributeEnable(uint32_t ui32Channel, uint32_t ui32Attr);
+static void simDmaAttributeDisable(uint32_t ui32Channel, uint32_t ui32Attr);
+static void simDmaControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control);
+static void simFifoLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel, uint32_t ui32RxLevel);
+static uint32_t simIntStatus(uint32_t ui32Base, bool bMasked);
+static volatile uint32_t *simReg(uint32_t ui32Addr);
+
+#define MAP_uDMAChannelModeGet simDmaModeGet
+#define MAP_uDMAChannelSizeGet simDmaSizeGet
+#define MAP_uDMAChannelTransferSet simDmaTransferSet
+#define MAP_uDMAChannelIsEnabled simDmaIsEnabled
+#define MAP_uDMAChannelEnable simDmaEnable
+#define MAP_uDMAChannelAttributeEnable simDmaAttributeEnable
+#define MAP_uDMAChannelAttributeDisable simDmaAttributeDisable
+#define MAP_uDMAChannelControlSet simDmaControlSet
+#define MAP_UARTFIFOLevelSet simFifoLevelSet
+#define MAP_UARTIntStatus simIntStatus
+#define MAP_SysCtlPeripheralPresent(x) 1
+#define HWREG(x) (*simReg(x))
+
+#include "lib_utils/uartstdio.c"
+
+static tUARTStdioInstance g_sSimInst;
+static unsigned char g_pui8SimRx[512];
+static unsigned char g_pui8SimTx[256];
+
+//*****************************************************************************
+// uDMA functions on the control structure selected by UDMA_ALT_SELECT.
+static uint32_t simDmaModeGet(uint32_t ui32ChannelStructIndex){
+	return g_psSimDma[(ui32ChannelStructIndex & UDMA_ALT_SELECT) ? 1 : 0].ui32Mode;
+}
+
+static uint32_t simDmaSizeGet(uint32_t ui32ChannelStructIndex){
+	return g_psSimDma[(ui32ChannelStructIndex & UDMA_ALT_SELECT) ? 1 : 0].ui32Remaining;
+}
+
+static void simDmaTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode, void *pvSrc, void *pvDst,
+							  uint32_t ui32Size){
+	uint32_t ui32Select = (ui32ChannelStructIndex & UDMA_ALT_SELECT) ? 1 : 0;
+
+	g_psSimDma[ui32Select].ui32Mode = ui32Mode;
+	g_psSimDma[ui32Select].ui32Remaining = ui32Size;
+	g_psSimDma[ui32Select].pui8Dst = pvDst;
+}
+
+static bool simDmaIsEnabled(uint32_t ui32Channel){
+	return g_bSimDmaEnabled;
+}
+
+static void simDmaEnable(uint32_t ui32Channel){
+	if(!g_bSimDmaEnabled){
+		g_ui32SimDmaStarts++;
+	}
+	g_bSimDmaEnabled = true;
+}
+
+static void simDmaAttributeEnable(uint32_t ui32Channel, uint32_t ui32Attr){
+	if(ui32Attr & UDMA_ATTR_ALTSELECT){
+		g_ui32SimDmaActive = 1;
+	}
+}
+
+static void simDmaAttributeDisable(uint32_t ui32Channel, uint32_t ui32Attr){
+	if(ui32Attr & UDMA_ATTR_ALTSELECT){
+		g_ui32SimDmaActive = 0;
+	}
+}
+
+static void simDmaControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control){
+	g_psSimDma[(ui32ChannelStructIndex & UDMA_ALT_SELECT) ? 1 : 0].ui32Arb = 1 << ((ui32Control >> 14) & 3);
+}
+
+//*****************************************************************************
+// UART functions and registers. In uDMA mode the receive interrupts are off.
+static void simFifoLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel, uint32_t ui32RxLevel){
+	static const uint32_t pui32Levels[4] = {2, 4, 8, 12};
+
+	g_ui32SimLevel = pui32Levels[(ui32RxLevel >> 3) & 3];
+}
+
+static uint32_t simIntStatus(uint32_t ui32Base, bool bMasked){
+	return g_bSimDmaMode ? 0 : (UART_INT_RX | UART_INT_RT);
+}
+
+static uint8_t simFifoPop(void){
+	if(g_ui32SimHead == g_ui32SimTail){
+		g_ui32SimEmptyReads++;
+		return SIM_EMPTY_DR;
+	}
+	return g_pui8SimFifo[g_ui32SimTail++ % SIM_FIFO_SIZE];
+}
+
+static volatile uint32_t *simReg(uint32_t ui32Addr){
+	static uint32_t ui32Value;
+
+	switch(ui32Addr){
+	case UART1_BASE + UART_O_DR:
+		ui32Value = simFifoPop();
+		break;
+	case UART1_BASE + UART_O_FR:
+		ui32Value = (g_ui32SimHead == g_ui32SimTail) ? UART_FR_RXFE : 0;
+		break;
+	default:
+		ui32Value = 0;
+		break;
+	}
+	return &ui32Value;
+}
+
+//*****************************************************************************
+// Serve the requests of the UART until the FIFO is empty or the channel
+// stops. A completed control structure raises the UART interrupt.
+static void simDmaService(void){
+	uint32_t ui32Count;
+
+	while(g_bSimDmaEnabled && (g_ui32SimHead != g_ui32SimTail)){
+		if(g_psSimDma[g_ui32SimDmaActive].ui32Mode == UDMA_MODE_STOP){
+			g_bSimDmaEnabled = false;
+			break;
+		}
+		ui32Count = (g_ui32SimHead - g_ui32SimTail >= g_ui32SimLevel) ? g_psSimDma[g_ui32SimDmaActive].ui32Arb : 1;
+		if(ui32Count > g_psSimDma[g_ui32SimDmaActive].ui32Remaining){
+			ui32Count = g_psSimDma[g_ui32SimDmaActive].ui32Remaining;
+		}
+		while(ui32Count--){
+			*g_psSimDma[g_ui32SimDmaActive].pui8Dst++ = simFifoPop();
+			g_psSimDma[g_ui32SimDmaActive].ui32Remaining--;
+		}
+		if(g_psSimDma[g_ui32SimDmaActive].ui32Remaining == 0){
+			g_psSimDma[g_ui32SimDmaActive].ui32Mode = UDMA_MODE_STOP;
+			g_ui32SimDmaActive ^= 1;
+			if(g_psSimDma[g_ui32SimDmaActive].ui32Mode == UDMA_MODE_STOP){
+				g_bSimDmaEnabled = false;
+			}
+			UARTStdioInstIntHandler(&g_sSimInst);
+		}
+	}
+}
+
+//*****************************************************************************
+// Pass SIM_BYTES bytes. ui32Frame bytes are sent, then the line is idle for
+// ui32Gap byte times. A slow reader takes SIM_SLOW_READ bytes every
+// SIM_SLOW_EVERY byte times, the other one all of them. ui32Arb overrides the
+// burst size when not 0. Return false if a byte was lost or changed.
+static bool simRun(const char *pcName, bool bDma, bool bFlow, uint32_t ui32Frame, uint32_t ui32Gap,
+				   bool bSlow, uint32_t ui32Arb){
+	tUARTStdioStats sStats;
+	uint32_t ui32Sent = 0, ui32Got = 0, ui32Bad = 0, ui32Overruns = 0, ui32Idle = 0;
+	uint32_t ui32Read, ui32Write;
+	uint32_t t, n;
+	uint8_t ui8Next = 0, ui8Expect = 0;
+
+	g_bSimDmaMode = false;
+	g_bSimDmaEnabled = false;
+	g_ui32SimDmaActive = 0;
+	g_ui32SimDmaStarts = 0;
+	g_ui32SimEmptyReads = 0;
+	g_psSimDma[0].ui32Mode = UDMA_MODE_STOP;
+	g_psSimDma[1].ui32Mode = UDMA_MODE_STOP;
+	g_ui32SimHead = 0;
+	g_ui32SimTail = 0;
+	UARTStdioInit(&g_sSimInst, 1, 921600, 16000000, g_pui8SimRx, sizeof(g_pui8SimRx), g_pui8SimTx,
+				  sizeof(g_pui8SimTx));
+	UARTStdioRawModeSet(&g_sSimInst, true);
+	UARTStdioFlowControlSet(&g_sSimInst, bFlow);
+	if(bDma){
+		g_bSimDmaMode = true;
+		UARTStdioRxDmaEnable(&g_sSimInst, UDMA_CHANNEL_UART1RX);
+		if(ui32Arb){
+			g_psSimDma[0].ui32Arb = ui32Arb;
+			g_psSimDma[1].ui32Arb = ui32Arb;
+		}
+	}
+	srand48(1);
+
+	// After the last byte is sent the reader empties the FIFO and the buffer.
+	for(t = 0; (ui32Sent < SIM_BYTES) || (ui32Got + ui32Overruns < ui32Sent); t++){
+		// Arrival, held off by RTS once the FIFO reaches its level.
+		if((ui32Sent < SIM_BYTES) && (t % (ui32Frame + ui32Gap) < ui32Frame) &&
+		   !(bFlow && (g_ui32SimHead - g_ui32SimTail >= g_ui32SimLevel))){
+			if(g_ui32SimHead - g_ui32SimTail < SIM_FIFO_SIZE){
+				g_pui8SimFifo[g_ui32SimHead++ % SIM_FIFO_SIZE] = ui8Next;
+			}
+			else{
+				ui32Overruns++;
+			}
+			ui8Next++;
+			ui32Sent++;
+			ui32Idle = 0;
+		}
+		else{
+			ui32Idle++;
+		}
+
+		if(bDma){
+			if(drand48() >= SIM_DMA_BUSY){
+				simDmaService();
+			}
+		}
+		else if(!g_sSimInst.bRxHeld && (g_ui32SimHead != g_ui32SimTail) &&
+				((g_ui32SimHead - g_ui32SimTail >= g_ui32SimLevel) || (ui32Idle >= SIM_RT_IDLE))){
+			UARTStdioInstIntHandler(&g_sSimInst);
+		}
+
+		if(bSlow && (t % SIM_SLOW_EVERY)){
+			continue;
+		}
+		ui32Read = UARTStdioRxReadIndexGet(&g_sSimInst);
+		ui32Write = UARTStdioRxWriteIndexGet(&g_sSimInst);
+		for(n = 0; (ui32Read != ui32Write) && (!bSlow || (n < SIM_SLOW_READ)); n++){
+			if(g_pui8SimRx[ui32Read] != ui8Expect){
+				ui32Bad++;
+			}
+			ui8Expect = g_pui8SimRx[ui32Read] + 1;
+			ui32Got++;
+			ui32Read = (ui32Read + 1) % sizeof(g_pui8SimRx);
+		}
+		UARTStdioRxBufferRelease(&g_sSimInst, ui32Read);
+	}
+
+	UARTStdioStatsGet(&g_sSimInst, &sStats);
+	printf("%-34s %6u interrupts (%.4f/byte), %5u blocks, %3u stops, %3u restarts | read %u of %u,"
+		   " %u changed, %u overruns, %u empty FIFO reads\n", pcName, (unsigned)sStats.ui32Interrupts,
+		   (double)sStats.ui32Interrupts / ui32Sent, (unsigned)sStats.ui32RxDmaBlocks,
+		   (unsigned)sStats.ui32RxHolds, (unsigned)g_ui32SimDmaStarts, (unsigned)ui32Got, (unsigned)ui32Sent,
+		   (unsigned)ui32Bad, (unsigned)ui32Overruns, (unsigned)g_ui32SimEmptyReads);
+	return (ui32Got == ui32Sent) && !ui32Bad && !g_ui32SimEmptyReads;
+}
+
+int main(void){
+	bool bOk = true;
+
+	bOk = simRun("interrupts, stream", false, false, 1, 0, false, 0) && bOk;
+	bOk = simRun("uDMA, stream", true, false, 1, 0, false, 0) && bOk;
+	bOk = simRun("uDMA, 30 byte frames", true, false, SIM_FRAME, SIM_FRAME_GAP, false, 0) && bOk;
+	bOk = simRun("uDMA, slow reader, flow control", true, true, 1, 0, true, 0) && bOk;
+
+	// Bursts of 4 at the 2 byte level, for comparison only.
+	simRun("uDMA, stream, 4 byte bursts", true, false, 1, 0, false, 4);
+	return bOk ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+//*****************************************************************************
+//
+// sim_uart_raw.c - Receive interrupt cost of uartstdio with echo and line
+//                  editing, with echo off and in raw mode.
+//
+// uartstdio.c is built into this file with UART1 redirected to a model of
+// its 16 byte receive FIFO. The FR and DR registers and the library calls
+// that read the FIFO are served by the model, and DWT_CYCCNT reads the host
+// monotonic clock in nanoseconds. The test fills the FIFO with 2 or 8 bytes before
+// every interrupt, then empties the receive buffer.
+//
+// Every register read is a function call here, where it is a single load on
+// the target, and each DWT_CYCCNT read is a clock call, so the host times
+// understate the gain of raw mode.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+//*****************************************************************************
+// Simulation parameters.
+#define SIM_BYTES			200000
+#define SIM_REPEATS			5			// Runs per case, the fastest one counts.
+#define SIM_FIFO_SIZE		16
+#define SIM_SLOW_PASSES		50000
+#define SIM_SLOW_READ		4			// Bytes read per pass by the slow reader.
+#define SIM_SLOW_LEVEL		8			// Bytes arriving per pass.
+
+//*****************************************************************************
+// UART1 receive FIFO model.
+static uint32_t g_pui32SimFifo[SIM_FIFO_SIZE];
+static uint32_t g_ui32SimHead;
+static uint32_t g_ui32SimTail;
+static uint32_t g_ui32SimRegReads;
+
+static bool simCharsAvail(uint32_t ui32Base);
+static int32_t simCharGet(uint32_t ui32Base);
+static uint32_t simIntStatus(uint32_t ui32Base, bool bMasked);
+static volatile uint32_t *simReg(uint32_t ui32Addr);
+
+#define MAP_UARTCharsAvail simCharsAvail
+#define MAP_UARTCharGetNonBlocking simCharGet
+#define MAP_UARTIntStatus simIntStatus
+#define MAP_SysCtlPeripheralPresent(x) 1
+#define HWREG(x) (*simReg(x))
+
+#include "lib_utils/uartstdio.c"
+
+//*****************************************************************************
+// Library calls that read the FIFO, counted with the other peripheral calls.
+static bool simCharsAvail(uint32_t ui32Base){
+	g_ui32HostPeripheralCalls++;
+	return g_ui32SimHead != g_ui32SimTail;
+}
+
+static int32_t simCharGet(uint32_t ui32Base){
+	g_ui32HostPeripheralCalls++;
+	if(g_ui32SimHead == g_ui32SimTail){
+		return -1;
+	}
+	return g_pui32SimFifo[g_ui32SimTail++ % SIM_FIFO_SIZE];
+}
+
+static uint32_t simIntStatus(uint32_t ui32Base, bool bMasked){
+	g_ui32HostPeripheralCalls++;
+	return UART_INT_RX | UART_INT_RT;
+}
+
+//*****************************************************************************
+// UART1 FR and DR, DWT_CYCCNT. Other registers read and write a dummy.
+static volatile uint32_t *simReg(uint32_t ui32Addr){
+	static uint32_t ui32Value;
+	struct timespec sNow;
+
+	switch(ui32Addr){
+	case UART1_BASE + UART_O_DR:
+		g_ui32SimRegReads++;
+		ui32Value = g_pui32SimFifo[g_ui32SimTail++ % SIM_FIFO_SIZE];
+		break;
+	case UART1_BASE + UART_O_FR:
+		g_ui32SimRegReads++;
+		ui32Value = (g_ui32SimHead == g_ui32SimTail) ? UART_FR_RXFE : 0;
+		break;
+	case DWT_CYCCNT:
+		clock_gettime(CLOCK_MONOTONIC, &sNow);
+		ui32Value = (uint32_t)((uint64_t)sNow.tv_sec * 1000000000 + sNow.tv_nsec);
+		break;
+	default:
+		break;
+	}
+	return &ui32Value;
+}
+
+static tUARTStdioInstance g_sSimInst;
+static unsigned char g_pui8SimRx[512];
+static unsigned char g_pui8SimTx[256];
+
+static void simInit(bool bEcho, bool bRaw){
+	UARTStdioInit(&g_sSimInst, 1, 921600, 16000000, g_pui8SimRx, sizeof(g_pui8SimRx), g_pui8SimTx,
+				  sizeof(g_pui8SimTx));
+	UARTStdioEchoSet(&g_sSimInst, bEcho);
+	UARTStdioRawModeSet(&g_sSimInst, bRaw);
+	g_ui32SimHead = 0;
+	g_ui32SimTail = 0;
+}
+
+//*****************************************************************************
+// Pass SIM_BYTES bytes, ui32Level per interrupt. Data is checked when echo
+// is off, since line editing changes it.
+static void simRun(const char *pcName, bool bEcho, bool bRaw, uint32_t ui32Level){
+	tUARTStdioStats sStats;
+	uint32_t ui32Calls, ui32Regs, ui32Bad, ui32Read, ui32Write;
+	uint32_t i, k, r;
+	uint8_t ui8Next, ui8Expect;
+	double dNs, dBest = 1e9;
+
+	for(r = 0; r < SIM_REPEATS; r++){
+		simInit(bEcho, bRaw);
+		ui32Calls = g_ui32HostPeripheralCalls;
+		ui32Regs = g_ui32SimRegReads;
+		ui32Bad = 0;
+		ui8Next = 0;
+		ui8Expect = 0;
+		for(i = 0; i < SIM_BYTES / ui32Level; i++){
+			for(k = 0; k < ui32Level; k++){
+				g_pui32SimFifo[g_ui32SimHead++ % SIM_FIFO_SIZE] = ui8Next++;
+			}
+			UARTStdioInstIntHandler(&g_sSimInst);
+			ui32Read = UARTStdioRxReadIndexGet(&g_sSimInst);
+			ui32Write = UARTStdioRxWriteIndexGet(&g_sSimInst);
+			while(ui32Read != ui32Write){
+				if(!bEcho && (g_pui8SimRx[ui32Read] != ui8Expect)){
+					ui32Bad++;
+				}
+				ui8Expect++;
+				ui32Read = (ui32Read + 1) % sizeof(g_pui8SimRx);
+			}
+			UARTStdioRxBufferRelease(&g_sSimInst, ui32Read);
+		}
+		ui32Calls = g_ui32HostPeripheralCalls - ui32Calls;
+		ui32Regs = g_ui32SimRegReads - ui32Regs;
+		UARTStdioStatsGet(&g_sSimInst, &sStats);
+		dNs = (double)sStats.ui64InterruptCycles / sStats.ui32RxBytes;
+		if(dNs < dBest){
+			dBest = dNs;
+		}
+	}
+	printf("%-21s level %u: rx %u, %u mismatches | per byte: %5.2f library calls, %4.2f register reads,"
+		   " %4.1f host ns\n", pcName, (unsigned)ui32Level, (unsigned)sStats.ui32RxBytes,
+		   (unsigned)ui32Bad, (double)ui32Calls / sStats.ui32RxBytes, (double)ui32Regs / sStats.ui32RxBytes,
+		   dBest);
+}
+
+//*****************************************************************************
+// Raw mode with a reader slower than the line. With flow control the sender
+// stops once the FIFO is full; without it, the bytes that find the FIFO full
+// are lost. Return false if bytes went missing without being counted.
+static bool simSlowReader(bool bFlow){
+	tUARTStdioStats sStats;
+	uint32_t ui32Sent = 0, ui32Got = 0, ui32Gaps = 0, ui32Missing = 0, ui32FifoLost = 0;
+	uint32_t ui32Read, ui32Write;
+	uint32_t i, k, n;
+	uint8_t ui8Next = 0, ui8Expect = 0;
+
+	simInit(false, true);
+	UARTStdioFlowControlSet(&g_sSimInst, bFlow);
+
+	// The sender stops after SIM_SLOW_PASSES passes, then the reader empties
+	// the FIFO and the receive buffer.
+	for(i = 0; (i < SIM_SLOW_PASSES) || (g_ui32SimHead != g_ui32SimTail) ||
+			   (UARTStdioRxReadIndexGet(&g_sSimInst) != UARTStdioRxWriteIndexGet(&g_sSimInst)); i++){
+		for(k = 0; (i < SIM_SLOW_PASSES) && (k < SIM_SLOW_LEVEL); k++){
+			if(g_ui32SimHead - g_ui32SimTail < SIM_FIFO_SIZE){
+				g_pui32SimFifo[g_ui32SimHead++ % SIM_FIFO_SIZE] = ui8Next++;
+				ui32Sent++;
+			}
+			else if(!bFlow){
+				ui8Next++;
+				ui32Sent++;
+				ui32FifoLost++;
+			}
+		}
+		if(!g_sSimInst.bRxHeld){
+			UARTStdioInstIntHandler(&g_sSimInst);
+		}
+		ui32Read = UARTStdioRxReadIndexGet(&g_sSimInst);
+		ui32Write = UARTStdioRxWriteIndexGet(&g_sSimInst);
+		for(n = 0; (ui32Read != ui32Write) && (n < SIM_SLOW_READ); n++){
+			if(g_pui8SimRx[ui32Read] != ui8Expect){
+				ui32Gaps++;
+				ui32Missing += (uint8_t)(g_pui8SimRx[ui32Read] - ui8Expect);
+			}
+			ui8Expect = g_pui8SimRx[ui32Read] + 1;
+			ui32Got++;
+			ui32Read = (ui32Read + 1) % sizeof(g_pui8SimRx);
+		}
+		UARTStdioRxBufferRelease(&g_sSimInst, ui32Read);
+	}
+	ui32Missing += (uint8_t)(ui8Next - ui8Expect);
+	UARTStdioStatsGet(&g_sSimInst, &sStats);
+	printf("raw, slow reader, flow control %s: sent %u, read %u, %u gaps of %u bytes | dropped %u,"
+		   " fifo lost %u, holds %u, max used %u\n", bFlow ? "on " : "off", (unsigned)ui32Sent,
+		   (unsigned)ui32Got, (unsigned)ui32Gaps, (unsigned)ui32Missing, (unsigned)sStats.ui32RxDropped,
+		   (unsigned)ui32FifoLost, (unsigned)sStats.ui32RxHolds, (unsigned)sStats.ui32RxMaxUsed);
+	return (ui32Got + ui32Missing == ui32Sent) && (ui32Missing == sStats.ui32RxDropped + ui32FifoLost);
+}
+
+int main(void){
+	static const uint32_t pui32Levels[2] = {2, 8};
+	bool bOk;
+	uint8_t i;
+
+	for(i = 0; i < 2; i++){
+		simRun("echo + line editing", true, false, pui32Levels[i]);
+		simRun("echo off (old UART1)", false, false, pui32Levels[i]);
+		simRun("raw", false, true, pui32Levels[i]);
+	}
+	bOk = simSlowReader(false);
+	bOk = simSlowReader(true) && bOk;
+	return bOk ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+//*****************************************************************************
+//
+// test_sensor_report.c - Round trips of the binary sensor report encoder and
+//                        decoder, as the gateway builds them on the host.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lib_xbee/sensor_report.h"
+#include "host_test.h"
+
+//*****************************************************************************
+// Fill a sample with four values of growing width.
+static void sampleFill(tReportSample *psSample, uint32_t ui32TimeMs, int32_t i32Base){
+	psSample->ui32TimeMs = ui32TimeMs;
+	psSample->ui8Count = 4;
+	psSample->psValues[0].ui8Sensor = REPORT_SENSOR_TEMP;
+	psSample->psValues[0].i32Value = i32Base;
+	psSample->psValues[1].ui8Sensor = REPORT_SENSOR_PRESSURE;
+	psSample->psValues[1].i32Value = 10132512 + i32Base;
+	psSample->psValues[2].ui8Sensor = REPORT_SENSOR_HUMIDITY;
+	psSample->psValues[2].i32Value = 5022 - i32Base;
+	psSample->psValues[3].ui8Sensor = REPORT_SENSOR_LIGHT;
+	psSample->psValues[3].i32Value = -18050;
+}
+
+//*****************************************************************************
+// Fixed-point conversion rounds to the nearest hundredth.
+static void testFixedPoint(void){
+	CHECK(SensorReportFixedPoint(20.51f) == 2051);
+	CHECK(SensorReportFixedPoint(-20.51f) == -2051);
+	CHECK(SensorReportFixedPoint(101325.12f) == 10132512);
+	CHECK(SensorReportFixedPoint(0.004f) == 0);
+	CHECK(SensorReportFixedPoint(-0.006f) == -1);
+}
+
+//*****************************************************************************
+// Values of every width come back unchanged, in the smallest encoding.
+static void testSampleRoundTrip(void){
+	tReportValue psValues[6] = {{REPORT_SENSOR_TEMP, 0}, {REPORT_SENSOR_TEMP, -128},
+								{REPORT_SENSOR_PRESSURE, 127}, {REPORT_SENSOR_HUMIDITY, -32768},
+								{REPORT_SENSOR_LIGHT, 32768}, {REPORT_SENSOR_M, INT32_MIN}};
+	tReportValue psDecoded[6];
+	uint8_t pui8Buf[64];
+	uint16_t ui16Len;
+	uint8_t i;
+
+	ui16Len = SensorReportEncode(pui8Buf, sizeof(pui8Buf), psValues, 6);
+	CHECK(ui16Len == REPORT_HEADER_SIZE + 2 + 2 + 2 + 3 + 5 + 5);
+	CHECK(pui8Buf[0] == (REPORT_MAGIC | REPORT_VERSION));
+	CHECK(pui8Buf[1] == REPORT_TYPE_SAMPLE);
+	CHECK(pui8Buf[2] == 6);
+
+	memset(psDecoded, 0, sizeof(psDecoded));
+	CHECK(SensorReportDecode(pui8Buf, ui16Len, psDecoded, 6) == 6);
+	for(i = 0; i < 6; i++){
+		CHECK(psDecoded[i].ui8Sensor == psValues[i].ui8Sensor);
+		CHECK(psDecoded[i].i32Value == psValues[i].i32Value);
+	}
+
+	// A decoder with less room gets the first values and the full count.
+	memset(psDecoded, 0, sizeof(psDecoded));
+	CHECK(SensorReportDecode(pui8Buf, ui16Len, psDecoded, 2) == 6);
+	CHECK(psDecoded[1].i32Value == -128);
+	CHECK(psDecoded[2].i32Value == 0);
+
+	// A report with no value is valid.
+	CHECK(SensorReportEncode(pui8Buf, sizeof(pui8Buf), psValues, 0) == REPORT_HEADER_SIZE);
+	CHECK(SensorReportDecode(pui8Buf, REPORT_HEADER_SIZE, psDecoded, 6) == 0);
+}
+
+//*****************************************************************************
+// Short buffers and foreign payloads are refused.
+static void testSampleInvalid(void){
+	tReportValue psValues[2] = {{REPORT_SENSOR_TEMP, 2051}, {REPORT_SENSOR_LIGHT, 70000}};
+	tReportValue psDecoded[2];
+	uint8_t pui8Buf[16];
+	uint16_t ui16Len;
+	uint16_t i;
+
+	ui16Len = SensorReportEncode(pui8Buf, sizeof(pui8Buf), psValues, 2);
+	CHECK(ui16Len == REPORT_HEADER_SIZE + 3 + 5);
+	for(i = 0; i < ui16Len; i++){
+		CHECK(SensorReportEncode(pui8Buf, i, psValues, 2) == 0);
+	}
+
+	ui16Len = SensorReportEncode(pui8Buf, sizeof(pui8Buf), psValues, 2);
+	for(i = 0; i < ui16Len; i++){
+		CHECK(SensorReportDecode(pui8Buf, i, psDecoded, 2) == -1);
+	}
+
+	pui8Buf[0] = REPORT_MAGIC | (REPORT_VERSION + 1);
+	CHECK(SensorReportDecode(pui8Buf, ui16Len, psDecoded, 2) == -1);
+	pui8Buf[0] = 't';
+	CHECK(SensorReportDecode(pui8Buf, ui16Len, psDecoded, 2) == -1);
+	pui8Buf[0] = REPORT_MAGIC | REPORT_VERSION;
+	pui8Buf[1] = REPORT_TYPE_BATCH;
+	CHECK(SensorReportDecode(pui8Buf, ui16Len, psDecoded, 2) == -1);
+	pui8Buf[1] = REPORT_TYPE_SAMPLE;
+	pui8Buf[3] |= REPORT_WIDTH_M;
+	CHECK(SensorReportDecode(pui8Buf, ui16Len, psDecoded, 2) == -1);
+}
+
+//*****************************************************************************
+// A batch is sent when full or old enough, and its samples come back with
+// their time rounded down to REPORT_BATCH_TICK_MS.
+static void testBatchRoundTrip(void){
+	tReportBatch sBatch;
+	tReportSample sSample;
+	tReportSample psDecoded[REPORT_BATCH_SIZE];
+	uint8_t pui8Buf[84];
+	uint16_t ui16Len;
+	uint8_t ui8Samples;
+	uint8_t i;
+	uint8_t j;
+
+	SensorReportBatchInit(&sBatch, sizeof(pui8Buf), 180000);
+	CHECK(!SensorReportBatchReady(&sBatch, 0));
+	CHECK(SensorReportBatchEncode(&sBatch, pui8Buf, sizeof(pui8Buf), &ui8Samples) == 0);
+
+	for(i = 0; i < 3; i++){
+		sampleFill(&sSample, 1000 + i * 45050, i);
+		SensorReportBatchAdd(&sBatch, &sSample);
+	}
+	CHECK(!SensorReportBatchReady(&sBatch, 1000 + 179999));
+	CHECK(SensorReportBatchReady(&sBatch, 1000 + 180000));
+
+	ui16Len = SensorReportBatchEncode(&sBatch, pui8Buf, sizeof(pui8Buf), &ui8Samples);
+	CHECK(ui16Len > REPORT_BATCH_HEADER_SIZE);
+	CHECK(ui8Samples == 3);
+	CHECK(SensorReportBatchDecode(pui8Buf, ui16Len, psDecoded, REPORT_BATCH_SIZE) == 3);
+	for(i = 0; i < 3; i++){
+		sampleFill(&sSample, 1000 + i * 45050, i);
+		CHECK(psDecoded[i].ui32TimeMs == sSample.ui32TimeMs / REPORT_BATCH_TICK_MS * REPORT_BATCH_TICK_MS);
+		CHECK(psDecoded[i].ui8Count == 4);
+		for(j = 0; j < 4; j++){
+			CHECK(psDecoded[i].psValues[j].ui8Sensor == sSample.psValues[j].ui8Sensor);
+			CHECK(psDecoded[i].psValues[j].i32Value == sSample.psValues[j].i32Value);
+		}
+	}
+
+	// Truncated batches are refused.
+	CHECK(SensorReportBatchDecode(pui8Buf, ui16Len - 1, psDecoded, REPORT_BATCH_SIZE) == -1);
+	CHECK(SensorReportBatchDecode(pui8Buf, REPORT_BATCH_HEADER_SIZE - 1, psDecoded, REPORT_BATCH_SIZE) == -1);
+}
+
+//*****************************************************************************
+// Encoding keeps the samples until they are discarded, so a record refused by
+// the transmit path is encoded again with the same samples.
+static void testBatchDiscard(void){
+	tReportBatch sBatch;
+	tReportSample sSample;
+	tReportSample psDecoded[REPORT_BATCH_SIZE];
+	uint8_t pui8First[84];
+	uint8_t pui8Again[84];
+	uint16_t ui16Len;
+	uint8_t ui8Samples;
+	uint8_t i;
+
+	SensorReportBatchInit(&sBatch, sizeof(pui8First), 180000);
+	for(i = 0; i < 5; i++){
+		sampleFill(&sSample, i * 1000, i);
+		SensorReportBatchAdd(&sBatch, &sSample);
+	}
+
+	// Room for two samples only, 16 bytes each.
+	ui16Len = SensorReportBatchEncode(&sBatch, pui8First, REPORT_BATCH_HEADER_SIZE + 2 * 16, &ui8Samples);
+	CHECK(ui8Samples == 2);
+	CHECK(sBatch.ui8Count == 5);
+	CHECK(SensorReportBatchEncode(&sBatch, pui8Again, REPORT_BATCH_HEADER_SIZE + 2 * 16, &ui8Samples) == ui16Len);
+	CHECK(memcmp(pui8First, pui8Again, ui16Len) == 0);
+
+	SensorReportBatchDiscard(&sBatch, ui8Samples);
+	CHECK(sBatch.ui8Count == 3);
+	ui16Len = SensorReportBatchEncode(&sBatch, pui8First, sizeof(pui8First), &ui8Samples);
+	CHECK(ui8Samples == 3);
+	CHECK(SensorReportBatchDecode(pui8First, ui16Len, psDecoded, REPORT_BATCH_SIZE) == 3);
+	CHECK(psDecoded[0].ui32TimeMs == 2000);
+	CHECK(psDecoded[0].psValues[0].i32Value == 2);
+
+	SensorReportBatchDiscard(&sBatch, ui8Samples);
+	CHECK(sBatch.ui8Count == 0);
+	CHECK(sBatch.ui16EncodedSize == REPORT_BATCH_HEADER_SIZE);
+	SensorReportBatchDiscard(&sBatch, 1);
+	CHECK(sBatch.ui8Count == 0);
+}
+
+//*****************************************************************************
+// A full ring drops its oldest sample and asks to be sent.
+static void testBatchOverflow(void){
+	tReportBatch sBatch;
+	tReportSample sSample;
+	tReportSample psDecoded[REPORT_BATCH_SIZE];
+	uint8_t pui8Buf[255];
+	uint16_t ui16Len;
+	uint8_t ui8Samples;
+	uint8_t i;
+
+	SensorReportBatchInit(&sBatch, sizeof(pui8Buf), 180000);
+	for(i = 0; i < REPORT_BATCH_SIZE + 2; i++){
+		sampleFill(&sSample, i * 100, i);
+		SensorReportBatchAdd(&sBatch, &sSample);
+	}
+	CHECK(sBatch.ui8Count == REPORT_BATCH_SIZE);
+	CHECK(sBatch.ui32Dropped == 2);
+	CHECK(SensorReportBatchReady(&sBatch, 0));
+
+	ui16Len = SensorReportBatchEncode(&sBatch, pui8Buf, sizeof(pui8Buf), &ui8Samples);
+	CHECK(ui8Samples == REPORT_BATCH_SIZE);
+	CHECK(SensorReportBatchDecode(pui8Buf, ui16Len, psDecoded, REPORT_BATCH_SIZE) == REPORT_BATCH_SIZE);
+	CHECK(psDecoded[0].ui32TimeMs == 200);
+	CHECK(psDecoded[0].psValues[0].i32Value == 2);
+}
+
+int main(void){
+	testFixedPoint();
+	testSampleRoundTrip();
+	testSampleInvalid();
+	testBatchRoundTrip();
+	testBatchDiscard();
+	testBatchOverflow();
+	return CHECK_DONE("test_sensor_report");
+}